@@ -1,9 +1,16 @@
 // Day 2.5 – ROI Blend (center sharp, periphery lower texel density)
+// The ROI is a memory policy, not just a look: the full image is only resident from mip
+// `baseLevel` (= floor of the periphery bias) down, plus a small full-res tile (with its own
+// mips) that follows the ROI. Each fragment takes ONE sample, from the tile inside it and from
+// the base outside, with the ROI falloff folded into its bias.
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <algorithm> // std::clamp
 #include <cmath>
+#include <vector>
+#include <cstdio>
+#include <string>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -24,32 +31,100 @@ void main() {
 }
 )";
 
-// ROI blend in screen space using gl_FragCoord (pixels)
+// ROI blend in screen space using gl_FragCoord (pixels), one texture fetch per fragment
 static const char* kFS = R"(
 #version 330 core
 in vec2 vUV;
 out vec4 fragColor;
 
-// Same texture bound twice with different samplers:
-uniform sampler2D texHi; // unit 0: sharp sampler (bias = 0)
-uniform sampler2D texLo; // unit 1: biased sampler (bias > 0)
+uniform sampler2D texBase; // unit 0: full image from mip baseLevel down (level 0 here = full-res level baseLevel)
+uniform sampler2D texTile; // unit 1: full-res tile around the ROI, with its own mips
+uniform vec4  tileRect;    // tile extent in image uv: x0, y0, x1, y1
 
 // ROI parameters in framebuffer pixels
 uniform vec2  roiCenter;   // screen center or mouse pos
 uniform float roiRadius;   // fully sharp radius
 uniform float roiFeather;  // soft transition thickness
+uniform float periphBias;  // LOD bias outside radius+feather
 
 void main() {
     float d = distance(gl_FragCoord.xy, roiCenter);
     // 0.0 inside radius (sharp), 1.0 outside radius+feather (biased)
     float w = smoothstep(roiRadius, roiRadius + roiFeather, d);
 
-    vec4 sharp = texture(texHi, vUV);
-    vec4 soft  = texture(texLo, vUV);
-    fragColor = mix(sharp, soft, w);
+    // Bias through the gradients (2^bias scales the footprint), so both branches share one set
+    // of derivatives. The base's level 0 is already baseLevel texels coarser, which
+    // textureGrad accounts for by itself (same uv, smaller texture).
+    vec2 gx = dFdx(vUV) * exp2(w * periphBias), gy = dFdy(vUV) * exp2(w * periphBias);
+    vec2 ext = tileRect.zw - tileRect.xy;
+    if (all(greaterThanEqual(vUV, tileRect.xy)) && all(lessThan(vUV, tileRect.zw)))
+        fragColor = textureGrad(texTile, (vUV - tileRect.xy) / ext, gx / ext, gy / ext);
+    else
+        fragColor = textureGrad(texBase, vUV, gx, gy);
 }
 )";
 
+// ---------- CPU mip chain (source for the base and the tile) ----------
+struct Level { int w, h; std::vector<unsigned char> px; };
+
+static std::vector<Level> buildChain(const unsigned char* rgba, int w, int h) {
+    std::vector<Level> chain;
+    chain.push_back({ w, h, std::vector<unsigned char>(rgba, rgba + (size_t)w * h * 4) });
+    while (chain.back().w > 1 || chain.back().h > 1) {
+        const Level& s = chain.back();
+        Level d{ std::max(1, s.w / 2), std::max(1, s.h / 2), {} };
+        d.px.resize((size_t)d.w * d.h * 4);
+        for (int y = 0; y < d.h; ++y) for (int x = 0; x < d.w; ++x) for (int c = 0; c < 4; ++c) {
+            int x0 = std::min(2 * x, s.w - 1), x1 = std::min(2 * x + 1, s.w - 1);
+            int y0 = std::min(2 * y, s.h - 1), y1 = std::min(2 * y + 1, s.h - 1);
+            int sum = s.px[((size_t)y0 * s.w + x0) * 4 + c] + s.px[((size_t)y0 * s.w + x1) * 4 + c]
+                    + s.px[((size_t)y1 * s.w + x0) * 4 + c] + s.px[((size_t)y1 * s.w + x1) * 4 + c];
+            d.px[((size_t)y * d.w + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+        }
+        chain.push_back(std::move(d));
+    }
+    return chain;
+}
+
+static double levelsMB(const std::vector<Level>& chain, int from) {
+    double b = 0;
+    for (int l = from; l < (int)chain.size(); ++l) b += (double)chain[l].w * chain[l].h * 4;
+    return b / (1024.0 * 1024.0);
+}
+
+// Base texture = levels [baseLevel ..] of the chain; the finer ones are simply not resident.
+static void uploadBase(GLuint tex, const std::vector<Level>& chain, int baseLevel) {
+    glBindTexture(GL_TEXTURE_2D, tex);
+    int n = (int)chain.size() - baseLevel;
+    for (int l = 0; l < n; ++l) {
+        const Level& L = chain[baseLevel + l];
+        glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, L.w, L.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, L.px.data());
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, n - 1);
+}
+
+// Tile = a tw x th window of levels [0 .. levels) at texel (ox, oy); ox/oy are multiples of
+// 2^(levels-1) so every tile level lines up with the chain.
+static void uploadTile(GLuint tex, const std::vector<Level>& chain, int ox, int oy, int tw, int th, int levels) {
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int l = 0; l < levels; ++l) {
+        const Level& L = chain[l];
+        int w = std::max(1, tw >> l), h = std::max(1, th >> l);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, L.w);
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, ox >> l);
+        glPixelStorei(GL_UNPACK_SKIP_ROWS, oy >> l);
+        glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, L.px.data());
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+}
+
+static int pow2Ceil(int v) { int p = 1; while (p < v) p <<= 1; return p; }
+
 // ---------- Shader helpers ----------
 static GLuint compileShader(GLenum type, const char* src) {
     GLuint sh = glCreateShader(type);
@@ -146,44 +221,41 @@ int main() {
         return -1;
     }
 
-    GLuint tex = 0;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, tw, th, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    std::vector<Level> chain = buildChain(pixels, tw, th);
     stbi_image_free(pixels);
-
-    // --- Create samplers ---
-    GLuint sampHi = 0, sampLo = 0;
-    glGenSamplers(1, &sampHi);
-    glGenSamplers(1, &sampLo);
-
-    // Sharp sampler (no extra bias)
-    glSamplerParameteri(sampHi, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glSamplerParameteri(sampHi, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glSamplerParameterf(sampHi, GL_TEXTURE_LOD_BIAS, 0.0f);
-    // Optional anisotropy:
-    // glSamplerParameterf(sampHi, GL_TEXTURE_MAX_ANISOTROPY, 4.0f);
-
-    // Biased sampler (periphery)
-    glSamplerParameteri(sampLo, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glSamplerParameteri(sampLo, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    float lodBias = 1.2f; // start biased (tweak with keys)
-    glSamplerParameterf(sampLo, GL_TEXTURE_LOD_BIAS, lodBias);
-    glSamplerParameterf(sampLo, GL_TEXTURE_MAX_ANISOTROPY, 1.0f);
+    const int levels = (int)chain.size();
+
+    float lodBias = 1.2f; // periphery bias (tweak with keys)
+    int baseLevel = -1;   // resident finest level of the full image, follows floor(lodBias)
+    GLuint baseTex = 0, tileTex = 0;
+    glGenTextures(1, &baseTex);
+    glGenTextures(1, &tileTex);
+
+    // One sampler for both units: same filtering, no sampler LOD bias (the shader computes it)
+    GLuint samp = 0;
+    glGenSamplers(1, &samp);
+    glSamplerParameteri(samp, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glSamplerParameteri(samp, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(samp, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(samp, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
     // --- Program and uniforms ---
     GLuint prog = createProgram(kVS, kFS);
     glUseProgram(prog);
 
-    GLint uTexHi = glGetUniformLocation(prog, "texHi");
-    GLint uTexLo = glGetUniformLocation(prog, "texLo");
-    glUniform1i(uTexHi, 0); // unit 0
-    glUniform1i(uTexLo, 1); // unit 1
+    glUniform1i(glGetUniformLocation(prog, "texBase"), 0); // unit 0
+    glUniform1i(glGetUniformLocation(prog, "texTile"), 1); // unit 1
 
     GLint uROICenter  = glGetUniformLocation(prog, "roiCenter");
     GLint uROIRadius  = glGetUniformLocation(prog, "roiRadius");
     GLint uROIFeather = glGetUniformLocation(prog, "roiFeather");
+    GLint uPeriph     = glGetUniformLocation(prog, "periphBias");
+    GLint uTileRect   = glGetUniformLocation(prog, "tileRect");
+
+    // Tile state (texels of the full image)
+    const int tileAlignLog2 = 6;                    // origin on a 64-texel grid -> 7 aligned tile levels
+    int tileX = -1, tileY = -1, tileW = 0, tileH = 0, tileLevels = 1;
+    double lastTitle = 0.0;
 
     // Initial ROI params (pixels)
     int fbW=0, fbH=0; glfwGetFramebufferSize(window, &fbW, &fbH);
@@ -210,26 +282,59 @@ int main() {
         if (glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS) lodBias += 0.01f;
         if (glfwGetKey(window, GLFW_KEY_LEFT_BRACKET)  == GLFW_PRESS) lodBias -= 0.01f;
         lodBias = std::clamp(lodBias, -0.25f, 3.0f);
-        glSamplerParameterf(sampLo, GL_TEXTURE_LOD_BIAS, lodBias);
+
+        // Periphery residency: drop (or bring back) whole top mips of the full image
+        int wantBase = std::clamp((int)std::floor(std::max(0.0f, lodBias)), 0, levels - 1);
+        if (wantBase != baseLevel) {
+            baseLevel = wantBase;
+            uploadBase(baseTex, chain, baseLevel);
+        }
+
+        // Full-res tile covering radius+feather around the ROI (in texels), re-cut when it moves
+        float sx = (float)tw / std::max(1, fbW), sy = (float)th / std::max(1, fbH);
+        float reach = roiRadius + roiFeather;
+        int wantW = std::min(tw, pow2Ceil((int)std::ceil(2.f * reach * sx) + (1 << tileAlignLog2)));
+        int wantH = std::min(th, pow2Ceil((int)std::ceil(2.f * reach * sy) + (1 << tileAlignLog2)));
+        int align = 1 << tileAlignLog2;
+        int ox = std::clamp((int)(roiX * sx - wantW / 2) / align * align, 0, std::max(0, (tw - wantW) / align * align));
+        int oy = std::clamp((int)(roiY * sy - wantH / 2) / align * align, 0, std::max(0, (th - wantH) / align * align));
+        if (ox != tileX || oy != tileY || wantW != tileW || wantH != tileH) {
+            tileX = ox; tileY = oy; tileW = wantW; tileH = wantH;
+            tileLevels = std::min(levels, tileAlignLog2 + 1);
+            uploadTile(tileTex, chain, tileX, tileY, tileW, tileH, tileLevels);
+        }
 
         // Upload ROI uniforms
         glUseProgram(prog);
         glUniform2f(uROICenter,  roiX, roiY);
         glUniform1f(uROIRadius,  roiRadius);
         glUniform1f(uROIFeather, roiFeather);
+        glUniform1f(uPeriph,     lodBias);
+        glUniform4f(uTileRect, (float)tileX / tw, (float)tileY / th, (float)(tileX + tileW) / tw, (float)(tileY + tileH) / th);
+
+        double now = glfwGetTime();
+        if (now - lastTitle > 0.25) {
+            lastTitle = now;
+            double tileMB = 0;
+            for (int l = 0; l < tileLevels; ++l) tileMB += (double)std::max(1, tileW >> l) * std::max(1, tileH >> l) * 4 / (1024.0 * 1024.0);
+            char title[256];
+            std::snprintf(title, sizeof(title), "Day 2.5 – ROI Blend | bias %.2f | resident: base (from mip %d) %.2f MB + tile %dx%d %.2f MB vs full chain %.2f MB",
+                          lodBias, baseLevel, levelsMB(chain, baseLevel), tileW, tileH, tileMB, levelsMB(chain, 0));
+            glfwSetWindowTitle(window, title);
+        }
 
         // Clear + draw
         glClearColor(0.07f, 0.10f, 0.15f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // Bind same texture on two units; bind different samplers
+        // Base on unit 0, ROI tile on unit 1; the shader reads exactly one of them per fragment
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, tex);
-        glBindSampler(0, sampHi);
+        glBindTexture(GL_TEXTURE_2D, baseTex);
+        glBindSampler(0, samp);
 
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, tex);
-        glBindSampler(1, sampLo);
+        glBindTexture(GL_TEXTURE_2D, tileTex);
+        glBindSampler(1, samp);
 
         glBindVertexArray(vao);
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
@@ -238,10 +343,10 @@ int main() {
     }
 
     // Cleanup
-    glDeleteSamplers(1, &sampHi);
-    glDeleteSamplers(1, &sampLo);
+    glDeleteSamplers(1, &samp);
     glDeleteProgram(prog);
-    glDeleteTextures(1, &tex);
+    glDeleteTextures(1, &baseTex);
+    glDeleteTextures(1, &tileTex);
     glDeleteBuffers(1, &ebo);
     glDeleteBuffers(1, &vbo);
     glDeleteVertexArrays(1, &vao);
@@ -1,9 +1,26 @@
 // Day 4 – Automatic Texel-Density Governor (VRAM + Density fallback)
-// - Core-profile safe extension scan (no GL_INVALID_ENUM spam)
-// - If VRAM telemetry exists: keep freeMB >= target headroom
-// - Else: keep average screen-space density near target
+// - Built on the vram_governor library (Day 6): telemetry, the governor, admission, deferred
+//   release, GPU timers and the shader helpers come from there; the density metric stays here
+// - The cube's sampler bias is one governed object (Band control, evaluated every frame): keep
+//   freeMB within targetFreeMB ± band; without driver telemetry the ledger model stands in
+// - The density keeper steps the same object toward a density target on every fresh sample
 // - Uses MRT to write color + per-pixel density to an offscreen FBO
-// - Averages density by mipmapping the R16F metric texture and reading its 1x1
+// - GL 4.3: a compute reduction yields mean/min/max + histogram of covered pixels; the
+//   controller then tracks the 90th percentile
+// - GL 3.3 fallback: averages density by mipmapping the R16F metric texture and reading its 1x1
+// - The 1x1 is read back through a PBO ring + fences (2-3 frames late, never stalls)
+// - Metric pass runs every Nth frame (key N cycles 1/2/4/8)
+// - GpuTimer rings time the scene and metric passes (read back late, never stall); scene GPU
+//   time over the governor's gpuBudgetMs pushes the bias up like a VRAM shortfall
+// - Dummy pressure textures go through admission at Low priority: created only while they fit
+//   above its free-VRAM floor, the rest wait instead of pushing the driver into paging
+// - Freed dummies go to gRetire: fenced, then recycled through gTexPool (while more wait) or
+//   deleted a few per frame; the governor counts them as free while they drain
+// - Every allocation goes through the ledger helpers, so the fallback model sees all of it
+// - The metric can be rendered at 1/4 or 1/8 resolution into its own target by a metric-only
+//   shader (no texture fetch, no colour), instead of as a full-res MRT attachment (key M); the
+//   scene pass then links a colour-only shader
+// - Offscreen targets grow to a high-water mark and are reused below it on resize
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -12,8 +29,12 @@
 #include <cmath>
 #include <algorithm>
 #include <cstring>
+#include <cstdint>
+#include <string>
 
-#define STB_IMAGE_IMPLEMENTATION
+#include "vram_governor.h"
+#include "ledger.h"
+#include "gputimer.h"
 #include "stb_image.h"
 
 #ifndef M_PI
@@ -40,20 +61,17 @@ void main(){
 }
 )";
 
-static const char* kFS = R"(
-#version 330 core
-in vec2 vUV;
-layout(location=0) out vec4 outColor;   // to colorTex
-layout(location=1) out vec4 outMetric;  // to metricTex (R in [0..1] density)
-
-uniform sampler2D uTex;
-
+// Shared by the scene FS and the metric-only FS (linked as kGLSLVersion + this + body).
+// uPixelScale: full-res pixels per metric pixel.
+static const char* kGLSLVersion = "#version 330 core\n";
+static const char* kDensityNormGLSL = R"(
+uniform float uPixelScale;
 float computeDensityNorm(sampler2D tex, vec2 uv){
     // Estimate mip level using screen-space UV derivatives
     vec2 texSize0 = vec2(textureSize(tex, 0)); // base level (w,h)
     vec2 dUVdx = dFdx(uv) * texSize0;
     vec2 dUVdy = dFdy(uv) * texSize0;
-    float rho = max(length(dUVdx), length(dUVdy)); // texels per pixel
+    float rho = max(length(dUVdx), length(dUVdy)) / uPixelScale; // texels per full-res pixel
     float lambda = log2(max(rho, 1e-8));           // mip level estimate (magnification -> negative)
     // Normalize by theoretical max mip of the bound texture
     float maxEdge = max(texSize0.x, texSize0.y);
@@ -61,6 +79,14 @@ float computeDensityNorm(sampler2D tex, vec2 uv){
     float norm = clamp(lambda / max(1.0, maxMip), 0.0, 1.0);
     return norm;
 }
+)";
+
+static const char* kFS = R"(
+in vec2 vUV;
+layout(location=0) out vec4 outColor;   // to colorTex
+layout(location=1) out vec4 outMetric;  // to metricTex (R in [0..1] density)
+
+uniform sampler2D uTex;
 
 void main(){
     vec4 c = texture(uTex, vUV);
@@ -72,25 +98,67 @@ void main(){
 }
 )";
 
-/* ======================= Utils ======================= */
-static GLuint compile(GLenum type, const char* src){
-    GLuint s = glCreateShader(type);
-    glShaderSource(s,1,&src,nullptr);
-    glCompileShader(s);
-    GLint ok=0; glGetShaderiv(s,GL_COMPILE_STATUS, &ok); // not all drivers set this; just check status:
-    glGetShaderiv(s,GL_COMPILE_STATUS,&ok);
-    if(!ok){ char log[2048]; glGetShaderInfoLog(s,2048,nullptr,log); std::cerr<<"SH error:\n"<<log<<"\n"; }
-    return s;
-}
-static GLuint linkProgram(const char* vs, const char* fs){
-    GLuint v=compile(GL_VERTEX_SHADER,vs), f=compile(GL_FRAGMENT_SHADER,fs);
-    GLuint p=glCreateProgram();
-    glAttachShader(p,v); glAttachShader(p,f); glLinkProgram(p);
-    GLint ok=0; glGetProgramiv(p,GL_LINK_STATUS,&ok);
-    if(!ok){ char log[2048]; glGetProgramInfoLog(p,2048,nullptr,log); std::cerr<<"PR error:\n"<<log<<"\n"; }
-    glDeleteShader(v); glDeleteShader(f);
-    return p;
+// Scene pass when no full-res metric is written (reduced-res metric, or an off-sample frame).
+static const char* kColorFS = R"(
+in vec2 vUV;
+layout(location=0) out vec4 outColor;
+uniform sampler2D uTex;
+void main(){ outColor = texture(uTex, vUV); }
+)";
+
+// Metric-only pass at reduced resolution: textureSize and derivatives, no fetch, no colour.
+static const char* kMetricFS = R"(
+in vec2 vUV;
+layout(location=0) out vec4 outMetric;
+uniform sampler2D uTex;
+void main(){ outMetric = vec4(computeDensityNorm(uTex, vUV), 0.0, 0.0, 1.0); }
+)";
+
+// Density reduction (GL 4.3). Pixels the cube didn't cover hold the -1 clear value and are skipped.
+// Per-group partials live in shared memory; one set of global atomics per work group.
+static const char* kCS = R"(
+#version 430 core
+layout(local_size_x=16, local_size_y=16) in;
+uniform sampler2D uMetric;
+uniform ivec2 uSize;            // region in use (the texture may be larger, see FBO)
+layout(std430, binding=0) buffer Stats {
+    uint count; uint sumQ; uint minBits; uint maxBits; uint hist[16];
+};
+shared float sSum[256];
+shared uint  sCnt[256];
+shared uint  sMin, sMax;
+shared uint  sHist[16];
+
+void main(){
+    uint li = gl_LocalInvocationIndex;
+    if(li == 0u){ sMin = 0x7F7FFFFFu; sMax = 0u; }
+    if(li < 16u) sHist[li] = 0u;
+    barrier();
+
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    float d = -1.0;
+    if(all(lessThan(p, uSize))) d = texelFetch(uMetric, p, 0).r;
+    bool covered = d >= 0.0;
+    sSum[li] = covered ? d : 0.0;
+    sCnt[li] = covered ? 1u : 0u;
+    if(covered){
+        uint bits = floatBitsToUint(d);          // order-preserving for d >= 0
+        atomicMin(sMin, bits); atomicMax(sMax, bits);
+        atomicAdd(sHist[min(uint(d * 16.0), 15u)], 1u);
+    }
+    barrier();
+    for(uint s = 128u; s > 0u; s >>= 1){
+        if(li < s){ sSum[li] += sSum[li+s]; sCnt[li] += sCnt[li+s]; }
+        barrier();
+    }
+    if(li == 0u && sCnt[0] > 0u){
+        atomicAdd(count, sCnt[0]);
+        atomicAdd(sumQ, uint(sSum[0] * 256.0 + 0.5));
+        atomicMin(minBits, sMin); atomicMax(maxBits, sMax);
+    }
+    if(li < 16u && sHist[li] > 0u) atomicAdd(hist[li], sHist[li]);
 }
+)";
 
 /* ======================= Matrices (column-major) ======================= */
 static void makePerspective(float fovyRad, float aspect, float zn, float zf, float out[16]){
@@ -142,66 +210,16 @@ static const unsigned cubeIdx[] = {
     16,17,18, 18,19,16, 20,21,22, 22,23,20
 };
 
-/* ======================= VRAM telemetry (Core-safe) ======================= */
-static bool gHasNVX = false;
-static bool gHasATI = false;
-
-static void scanExtensionsOnce(bool& hasNVX, bool& hasATI) {
-    hasNVX = hasATI = false;
-
-#ifdef GLEW_NVX_gpu_memory_info
-    if (GLEW_NVX_gpu_memory_info) hasNVX = true;
-#endif
-#ifdef GLEW_ATI_meminfo
-    if (GLEW_ATI_meminfo) hasATI = true;
-#endif
-
-    if (!hasNVX || !hasATI) {
-        GLint n = 0; glGetIntegerv(GL_NUM_EXTENSIONS, &n);
-        for (GLint i = 0; i < n; ++i) {
-            const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
-            if (!ext) continue;
-            if (!hasNVX && std::strcmp(ext, "GL_NVX_gpu_memory_info") == 0) hasNVX = true;
-            if (!hasATI && std::strcmp(ext, "GL_ATI_meminfo") == 0)         hasATI = true;
-        }
-    }
-}
-
-#ifndef GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX
-#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX        0x9047
-#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX   0x9048
-#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
-#endif
-#ifndef GL_TEXTURE_FREE_MEMORY_ATI
-#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
-#endif
-
-// Return (totalMB, freeMB); ok=false if neither extension present
-static void queryVRAM_MB(int& totalMB, int& freeMB, bool& ok) {
-    ok = false; totalMB = -1; freeMB = -1;
-
-    if (gHasNVX) {
-        GLint totalKB=0, availKB=0;
-        glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &totalKB);
-        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &availKB);
-        totalMB = totalKB / 1024;
-        freeMB  = availKB / 1024;
-        ok = true; return;
-    }
-    if (gHasATI) {
-        GLint vals[4] = {0,0,0,0};
-        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, vals);
-        freeMB  = vals[0] / 1024; // heuristic
-        totalMB = -1;
-        ok = true; return;
-    }
-}
-
 /* ======================= Dummy 4K texture harness (to create pressure) ======================= */
+// A batch is only a request: each texture waits in admission (Low priority, so nothing is shed
+// for it) until it fits above the floor. Raising the bias frees nothing here.
+static VramGovernor gVg;
 static std::vector<GLuint> gDummyTex;
+static const TexShape kDummyShape{ GL_RGBA8, 4096, 4096, 13 };    // full mip chain
+static double dummyMB(){ return kDummyShape.bytes() / (1024.0*1024.0); }
 
 static GLuint makeDummy4KTexture(){
-    const int W=4096, H=4096;
+    const int W=kDummyShape.w, H=kDummyShape.h;
     std::vector<unsigned char> tmp(W*H*4);
     for(int y=0;y<H;++y){
         for(int x=0;x<W;++x){
@@ -212,31 +230,41 @@ static GLuint makeDummy4KTexture(){
             tmp[i+3]=255;
         }
     }
-    GLuint t=0; glGenTextures(1,&t);
+    // Recycled storage if a freed dummy is pooled, otherwise a new allocation
+    GLuint t = gTexPool.acquire(kDummyShape);
     glBindTexture(GL_TEXTURE_2D, t);
-    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA8,W,H,0,GL_RGBA,GL_UNSIGNED_BYTE,tmp.data());
+    glTexSubImage2D(GL_TEXTURE_2D,0,0,0,W,H,GL_RGBA,GL_UNSIGNED_BYTE,tmp.data());
     glGenerateMipmap(GL_TEXTURE_2D);
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
     return t;
 }
+
 static void addDummyBatch(int n=10){
-    for(int i=0;i<n;++i) gDummyTex.push_back(makeDummy4KTexture());
-    std::cout<<"[load] +"<<n<<" dummy 4K textures (total "<<gDummyTex.size()<<")\n";
+    for(int i=0;i<n;++i)
+        gVg.request(dummyMB(), Priority::Low, []{ gDummyTex.push_back(makeDummy4KTexture()); }, "dummy 4K");
+    std::cout<<"[load] requested +"<<n<<" dummy 4K textures (total "<<gDummyTex.size()<<", "<<gVg.admission().waiting()<<" waiting)\n";
 }
+// Waiting requests are withdrawn first; the rest are retired, not deleted in the frame.
 static void freeDummyBatch(int n=10){
+    n -= (int)gVg.admission().cancelNewest((size_t)n);
     for(int i=0;i<n && !gDummyTex.empty(); ++i){
-        GLuint t = gDummyTex.back(); gDummyTex.pop_back();
-        glDeleteTextures(1,&t);
+        gRetire.retire(gDummyTex.back(), kDummyShape.bytes(), true, kDummyShape); gDummyTex.pop_back();
     }
-    std::cout<<"[load] -"<<n<<" dummy 4K textures (total "<<gDummyTex.size()<<")\n";
+    std::cout<<"[load] -"<<n<<" dummy 4K textures (total "<<gDummyTex.size()<<", "<<(gRetire.queuedBytes()>>20)<<"MB retiring)\n";
 }
 
 /* ======================= Offscreen FBO (color + metric) ======================= */
+// Storage is allocated at capW x capH and only [0,w) x [0,h) is rendered; a resize within the
+// high-water mark just moves w/h. The metric is either attachment 1 of the scene FBO (full-res
+// MRT) or attachment 0 of a metric-only FBO (reduced resolution, no colour).
 struct FBO {
     GLuint fbo=0, colorTex=0, metricTex=0, rboDepth=0;
-    int w=0, h=0, metricMipCount=1;
+    int w=0, h=0, capW=0, capH=0, metricMipCount=1;
+    bool color=false, metric=false, metricMips=false;
+    int metricAttachment() const { return color ? 1 : 0; }
 };
+static constexpr float kClearColor[4] = { 0.07f, 0.10f, 0.15f, 1.0f };
 
 static int mipCountFor(int w, int h){
     int m=1; while (w>1 || h>1){ w=std::max(1,w/2); h=std::max(1,h/2); ++m; }
@@ -244,65 +272,234 @@ static int mipCountFor(int w, int h){
 }
 
 static void destroyFBO(FBO& f){
-    if (f.rboDepth) glDeleteRenderbuffers(1,&f.rboDepth);
-    if (f.metricTex) glDeleteTextures(1,&f.metricTex);
-    if (f.colorTex)  glDeleteTextures(1,&f.colorTex);
+    if (f.rboDepth) trackedDeleteRenderbuffers(1,&f.rboDepth);
+    if (f.metricTex) trackedDeleteTextures(1,&f.metricTex);
+    if (f.colorTex)  trackedDeleteTextures(1,&f.colorTex);
     if (f.fbo)       glDeleteFramebuffers(1,&f.fbo);
     f = {};
 }
 
-static bool createFBO(FBO& f, int w, int h){
+// `metricMips` = false when the compute reduction reads level 0 only (no chain to allocate).
+static bool createFBO(FBO& f, int w, int h, bool color, bool metric, bool metricMips){
     destroyFBO(f);
-    f.w=w; f.h=h;
-    f.metricMipCount = mipCountFor(w,h);
+    f.w=f.capW=w; f.h=f.capH=h;
+    f.color=color; f.metric=metric; f.metricMips=metricMips;
+    f.metricMipCount = metric && metricMips ? mipCountFor(w,h) : 1;
 
     glGenFramebuffers(1,&f.fbo);
     glBindFramebuffer(GL_FRAMEBUFFER, f.fbo);
 
     // Color
-    glGenTextures(1,&f.colorTex);
-    glBindTexture(GL_TEXTURE_2D, f.colorTex);
-    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA8,w,h,0,GL_RGBA,GL_UNSIGNED_BYTE,nullptr);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, f.colorTex, 0);
+    if (color){
+        glGenTextures(1,&f.colorTex);
+        glBindTexture(GL_TEXTURE_2D, f.colorTex);
+        trackedTexImage2D(MemTag::Target, f.colorTex, 0, GL_RGBA8, w, h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, f.colorTex, 0);
+    }
 
-    // Metric (R16F) with full mip chain for averaging
-    glGenTextures(1,&f.metricTex);
-    glBindTexture(GL_TEXTURE_2D, f.metricTex);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAX_LEVEL,f.metricMipCount-1);
-    for(int level=0, lw=w, lh=h; level<f.metricMipCount; ++level){
-        glTexImage2D(GL_TEXTURE_2D, level, GL_R16F, lw, lh, 0, GL_RED, GL_FLOAT, nullptr);
-        lw = std::max(1, lw/2);
-        lh = std::max(1, lh/2);
+    // Metric (R16F); full mip chain only for mip averaging
+    if (metric){
+        glGenTextures(1,&f.metricTex);
+        glBindTexture(GL_TEXTURE_2D, f.metricTex);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,metricMips ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,metricMips ? GL_LINEAR : GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAX_LEVEL,f.metricMipCount-1);
+        for(int level=0, lw=w, lh=h; level<f.metricMipCount; ++level){
+            trackedTexImage2D(MemTag::Target, f.metricTex, level, GL_R16F, lw, lh, GL_RED, GL_FLOAT, nullptr);
+            lw = std::max(1, lw/2);
+            lh = std::max(1, lh/2);
+        }
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + f.metricAttachment(), GL_TEXTURE_2D, f.metricTex, 0);
     }
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, f.metricTex, 0);
 
     // Depth (renderbuffer)
     glGenRenderbuffers(1,&f.rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, f.rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+    trackedRenderbufferStorage(MemTag::Target, f.rboDepth, 0, GL_DEPTH_COMPONENT24, w, h);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, f.rboDepth);
 
     GLenum bufs[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-    glDrawBuffers(2, bufs);
+    glDrawBuffers(color && metric ? 2 : 1, bufs);
 
     bool ok = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     return ok;
 }
 
+// Resize: reuse the storage while w x h fits and the layout is unchanged, otherwise grow the
+// high-water mark (never below the old one, so flip-flopping sizes allocate once).
+static bool ensureFBO(FBO& f, int w, int h, bool color, bool metric, bool metricMips){
+    w = std::max(1,w); h = std::max(1,h);
+    bool same = f.fbo && f.color==color && f.metric==metric && f.metricMips==metricMips;
+    if (same && w <= f.capW && h <= f.capH){ f.w=w; f.h=h; return true; }
+    int cw = same ? std::max(w, f.capW) : w, ch = same ? std::max(h, f.capH) : h;
+    bool ok = createFBO(f, cw, ch, color, metric, metricMips);
+    f.w=w; f.h=h;
+    std::cout<<"[fbo] "<<(color?"scene":"metric")<<" storage "<<cw<<"x"<<ch<<" (using "<<w<<"x"<<h<<")\n";
+    return ok;
+}
+
+// Metric clear for the frame's sample: -1 (uncovered) for the compute reduction, which reads
+// only w x h; for mip averaging the unused high-water area is zeroed and the active region gets
+// the scene background, and mipMeanScale() undoes the dilution.
+static void clearMetric(const FBO& f, bool compute){
+    int a = f.metricAttachment();
+    const float uncovered[4] = { -1.0f, 0.0f, 0.0f, 0.0f }, zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    if (compute){ glClearBufferfv(GL_COLOR, a, uncovered); return; }
+    if (f.w == f.capW && f.h == f.capH){ glClearBufferfv(GL_COLOR, a, kClearColor); return; }
+    glClearBufferfv(GL_COLOR, a, zero);
+    glEnable(GL_SCISSOR_TEST); glScissor(0,0,f.w,f.h);
+    glClearBufferfv(GL_COLOR, a, kClearColor);
+    glDisable(GL_SCISSOR_TEST);
+}
+static float mipMeanScale(const FBO& f){ return (float)f.capW*f.capH / ((float)f.w*f.h); }
+
+/* ======================= Async density readback ======================= */
+// Each slot owns a small buffer that the GPU writes into (a PBO for the mip path, an SSBO for the
+// compute reduction). A fence per slot tells us when it has landed; we read nothing until then,
+// so the CPU never waits on the GPU.
+static constexpr int kHistBins = 16;
+
+// Matches the std430 `Stats` block of kCS.
+struct GpuDensityStats {
+    uint32_t count, sumQ, minBits, maxBits;   // sumQ: sum of density * kSumScale
+    uint32_t hist[kHistBins];
+};
+static constexpr float kSumScale = 256.0f;
+
+struct DensitySample {
+    float    mean = 0.0f, minD = 0.0f, maxD = 0.0f, p90 = 0.0f;
+    uint32_t pixels = 0;            // covered pixels (compute path only)
+    bool     hasHist = false;
+};
+
+struct DensityReadback {
+    static constexpr int kRing = 4;
+    GLuint   buf[kRing] = {};
+    GLsync   fence[kRing] = {};
+    uint64_t frameOf[kRing] = {};
+    bool     compute[kRing] = {};
+    float    scale[kRing] = {};     // mip path: 1x1 mean -> mean over the region in use
+    int head = 0, inFlight = 0;     // head = next slot to issue; oldest = head - inFlight
+
+    bool          hasSample = false;
+    DensitySample latest;           // newest completed sample
+    uint64_t      latestFrame = 0;  // frame the newest sample was rendered in
+};
+
+static void initReadback(DensityReadback& r){
+    glGenBuffers(DensityReadback::kRing, r.buf);
+    for(GLuint b : r.buf){
+        glBindBuffer(GL_COPY_WRITE_BUFFER, b);
+        trackedBufferData(MemTag::Readback, GL_COPY_WRITE_BUFFER, b, sizeof(GpuDensityStats), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+static void destroyReadback(DensityReadback& r){
+    for(GLsync& f : r.fence) if(f){ glDeleteSync(f); f = nullptr; }
+    trackedDeleteBuffers(DensityReadback::kRing, r.buf);
+    r = {};
+}
+
+// Density at fraction q of the covered pixels, interpolated inside the histogram bin.
+static float histPercentile(const uint32_t hist[kHistBins], uint32_t total, float q){
+    if(total == 0) return 0.0f;
+    float want = q * (float)total, acc = 0.0f;
+    for(int b=0; b<kHistBins; ++b){
+        if(hist[b] && acc + (float)hist[b] >= want)
+            return ((float)b + (want - acc) / (float)hist[b]) / (float)kHistBins;
+        acc += (float)hist[b];
+    }
+    return 1.0f;
+}
+
+// Collect every finished slot in issue order; returns true if a new sample arrived.
+static bool pollReadback(DensityReadback& r){
+    bool got = false;
+    while(r.inFlight > 0){
+        int i = (r.head - r.inFlight + DensityReadback::kRing) % DensityReadback::kRing;
+        GLenum st = glClientWaitSync(r.fence[i], 0, 0);
+        if(st != GL_ALREADY_SIGNALED && st != GL_CONDITION_SATISFIED) break;
+        glDeleteSync(r.fence[i]); r.fence[i] = nullptr;
+        glBindBuffer(GL_COPY_READ_BUFFER, r.buf[i]);
+        DensitySample d;
+        if(r.compute[i]){
+            GpuDensityStats g{};
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(g), &g);
+            d.pixels = g.count; d.hasHist = true;
+            if(g.count){
+                d.mean = (float)g.sumQ / kSumScale / (float)g.count;
+                std::memcpy(&d.minD, &g.minBits, 4); std::memcpy(&d.maxD, &g.maxBits, 4);
+                d.p90 = histPercentile(g.hist, g.count, 0.9f);
+            }
+        } else {
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(float), &d.mean);
+            d.mean *= r.scale[i];
+            d.minD = d.maxD = d.p90 = d.mean;
+        }
+        r.latest = d; r.latestFrame = r.frameOf[i]; r.hasSample = true; got = true;
+        --r.inFlight;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return got;
+}
+
+// Both issue paths skip (return false) when every slot is still in flight rather than blocking.
+static int beginSlot(DensityReadback& r){ return r.inFlight == DensityReadback::kRing ? -1 : r.head; }
+static void endSlot(DensityReadback& r, int i, uint64_t frame, bool compute){
+    r.fence[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    r.frameOf[i] = frame; r.compute[i] = compute;
+    r.head = (r.head + 1) % DensityReadback::kRing;
+    ++r.inFlight;
+}
+
+// Mip path: copy the 1x1 `level` of the mipmapped metric texture.
+static bool issueMipReadback(DensityReadback& r, GLuint metricTex, int level, float scale, uint64_t frame){
+    int i = beginSlot(r); if(i < 0) return false;
+    r.scale[i] = scale;
+    glBindTexture(GL_TEXTURE_2D, metricTex);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, r.buf[i]);
+    glGetTexImage(GL_TEXTURE_2D, level, GL_RED, GL_FLOAT, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    endSlot(r, i, frame, false);
+    return true;
+}
+
+// Compute path: one dispatch over level 0 accumulates count/sum/min/max/histogram into the slot.
+static bool issueComputeReduction(DensityReadback& r, GLuint prog, GLuint metricTex, int w, int h, uint64_t frame){
+    int i = beginSlot(r); if(i < 0) return false;
+    GpuDensityStats init{}; init.minBits = 0x7F7FFFFFu;     // FLT_MAX
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, r.buf[i]);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(init), &init);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, r.buf[i]);
+    glUseProgram(prog);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, metricTex);
+    glUniform2i(glGetUniformLocation(prog,"uSize"), w, h);
+    glDispatchCompute((GLuint)(w+15)/16, (GLuint)(h+15)/16, 1);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    endSlot(r, i, frame, true);
+    return true;
+}
+
 /* ======================= Main ======================= */
 int main(){
     // --- Window / GL ---
     if(!glfwInit()){ std::cerr<<"Failed to init GLFW\n"; return -1; }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,3);
+    // Ask for 4.3 (compute reduction); drop to 3.3 core if the driver can't
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
     glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_DEPTH_BITS,24);
     GLFWwindow* window = glfwCreateWindow(1280,720,"Day 4 – VRAM + Density Governor",nullptr,nullptr);
+    if(!window){
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+        window = glfwCreateWindow(1280,720,"Day 4 – VRAM + Density Governor",nullptr,nullptr);
+    }
     if(!window){ std::cerr<<"Failed to create window\n"; glfwTerminate(); return -1; }
     glfwMakeContextCurrent(window);
     glfwSwapInterval(1);
@@ -316,12 +513,11 @@ int main(){
     glDebugMessageCallback(glDebugCallback,nullptr);
 #endif
 
-    // --- Extension scan (once) ---
-    scanExtensionsOnce(gHasNVX, gHasATI);
-    if (!gHasNVX && !gHasATI) {
-        std::cout << "[warn] No VRAM telemetry extension found (NVX/ATI). "
-                     "Governor will use density metric.\n";
-    }
+    // --- Governor library (telemetry scan, governor, admission); nothing streams here ---
+    VgConfig cfg; cfg.asyncUploads = false;
+    gVg.init(cfg);
+    Governor& gov = gVg.governor();
+    gTexPool.maxBytes = 2*kDummyShape.bytes();     // recycle at most two freed dummies
 
     // --- Geometry buffers ---
     GLuint vao,vbo,ebo;
@@ -330,9 +526,9 @@ int main(){
     glGenBuffers(1,&ebo);
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER,vbo);
-    glBufferData(GL_ARRAY_BUFFER,sizeof(cubeVerts),cubeVerts,GL_STATIC_DRAW);
+    trackedBufferData(MemTag::Geometry, GL_ARRAY_BUFFER, vbo, sizeof(cubeVerts), cubeVerts, GL_STATIC_DRAW);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,sizeof(cubeIdx),cubeIdx,GL_STATIC_DRAW);
+    trackedBufferData(MemTag::Geometry, GL_ELEMENT_ARRAY_BUFFER, ebo, sizeof(cubeIdx), cubeIdx, GL_STATIC_DRAW);
     glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,sizeof(V),(void*)0);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(1,2,GL_FLOAT,GL_FALSE,sizeof(V),(void*)(3*sizeof(float)));
@@ -342,63 +538,124 @@ int main(){
     int tw=0, th=0, ch=0;
     unsigned char* pixels = stbi_load("assets/checker.png",&tw,&th,&ch, STBI_rgb_alpha);
     if(!pixels){ std::cerr<<"Failed to load assets/checker.png\n"; return -1; }
-    GLuint tex=0; glGenTextures(1,&tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA8,tw,th,0,GL_RGBA,GL_UNSIGNED_BYTE,pixels);
+    GLuint tex = trackedTexStorage2D(MemTag::Governed, mipCountFor(tw,th), GL_RGBA8, tw, th);
+    glTexSubImage2D(GL_TEXTURE_2D,0,0,0,tw,th,GL_RGBA,GL_UNSIGNED_BYTE,pixels);
     glGenerateMipmap(GL_TEXTURE_2D);
     stbi_image_free(pixels);
 
     GLuint samp=0; glGenSamplers(1,&samp);
     glSamplerParameteri(samp,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
     glSamplerParameteri(samp,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-    float lodBias = 0.0f;
-    glSamplerParameterf(samp,GL_TEXTURE_LOD_BIAS,lodBias);
+    glSamplerParameterf(samp,GL_TEXTURE_LOD_BIAS,0.0f);
 
     // --- Program ---
-    GLuint prog = linkProgram(kVS,kFS);
+    auto withDensity = [](const char* body){ return std::string(kGLSLVersion) + kDensityNormGLSL + body; };
+    auto linkProgram = [](const char* vsSrc, const std::string& fsSrc){
+        GLuint vs=vgCompileShader(GL_VERTEX_SHADER,vsSrc), fs=vgCompileShader(GL_FRAGMENT_SHADER,fsSrc.c_str());
+        GLuint p = vs && fs ? vgLinkProgram(vs,fs) : 0;
+        if(vs) glDeleteShader(vs);
+        if(fs) glDeleteShader(fs);
+        return p;
+    };
+    GLuint prog = linkProgram(kVS,withDensity(kFS));
     glUseProgram(prog);
     glUniform1i(glGetUniformLocation(prog,"uTex"),0);
+    glUniform1f(glGetUniformLocation(prog,"uPixelScale"),1.0f);
     GLint uMVP = glGetUniformLocation(prog,"uMVP");
+    GLuint colorProg = linkProgram(kVS,std::string(kGLSLVersion) + kColorFS);
+    glUseProgram(colorProg);
+    glUniform1i(glGetUniformLocation(colorProg,"uTex"),0);
+    GLint uColorMVP = glGetUniformLocation(colorProg,"uMVP");
+    GLuint metricProg = linkProgram(kVS,withDensity(kMetricFS));
+    glUseProgram(metricProg);
+    glUniform1i(glGetUniformLocation(metricProg,"uTex"),0);
+    GLint uMetricMVP = glGetUniformLocation(metricProg,"uMVP");
+    GLint uMetricScale = glGetUniformLocation(metricProg,"uPixelScale");
+
+    // --- Density reduction path (0 if it fails to build: fall back to the mip path) ---
+    GLuint reduceProg = 0;
+    if (GLEW_VERSION_4_3){
+        GLuint cs = vgCompileShader(GL_COMPUTE_SHADER, kCS);
+        reduceProg = cs ? vgLinkCompute(cs) : 0;
+        if (cs) glDeleteShader(cs);
+    }
+    bool useCompute = reduceProg != 0;
+    if (useCompute){ glUseProgram(reduceProg); glUniform1i(glGetUniformLocation(reduceProg,"uMetric"),0); }
+    std::cout << "[metric] " << (useCompute ? "compute reduction (mean/min/max/p90)" : "mipmap average") << "\n";
 
-    // --- Offscreen FBO (color+metric) ---
+    // --- Offscreen FBOs: scene (color [+ full-res metric]) and reduced-res metric ---
+    // metricDiv 1: metric is an MRT attachment of the scene pass; 4 / 8: own pass at 1/div per axis (key M)
+    int metricDiv = 4;
     int fbW=0, fbH=0; glfwGetFramebufferSize(window,&fbW,&fbH);
-    FBO fbo; if (!createFBO(fbo, fbW, fbH)) { std::cerr<<"FBO creation failed\n"; return -1; }
+    FBO fbo, metricFbo;
+    if (!ensureFBO(fbo, fbW, fbH, true, metricDiv==1, !useCompute)) { std::cerr<<"FBO creation failed\n"; return -1; }
+    bool prevM = false;
 
     // --- Governor settings ---
+    // One object: the cube's sampler bias. Nothing streams, so the bias itself is the output.
     bool governorOn = true;
-    int totalMB=-1, freeMB=-1; bool vramOK=false;
-    queryVRAM_MB(totalMB, freeMB, vramOK);
-
-    // VRAM headroom target (if available)
-    int targetFreeMB = (vramOK && freeMB>0) ? std::max(256, std::min(freeMB, 1536)) : 1024;
-    int bandMB = 128;                 // hysteresis ±128MB
-    float kp_vram = 0.0035f;          // P-gain for MB error
-    float rate    = 0.04f;            // max |bias delta| per update
-
-    // Density target (used always; primary if no VRAM)
+    const TelemetrySample& tel0 = gVg.telemetry().sample(glfwGetTime());
+    gov.residency = ResidencyMode::BiasOnly;
+    const int cube = gov.add(Priority::Normal, -0.25f, 3.0f);     // hardware-reasonable range
+
+    // VRAM headroom target (from driver telemetry if available)
+    gov.targetFreeMB = (tel0.valid && tel0.freeMB>0) ? std::max(256, std::min(tel0.freeMB, 1536)) : 1024;
+    gov.hysteresisMB = 128;           // band ±128MB
+    gov.stepGradual  = 0.04f;         // bias delta per update outside the band
+    gov.evalDt       = 0.0;           // update every frame
+    const float rate = gov.stepGradual;
+
+    // Density target (used always; primary if no VRAM). With a histogram the keeper tracks the
+    // 90th percentile of covered pixels, which follows visible blur/aliasing better than the mean.
     float targetDensity = 0.35f;
+    float targetP90     = 0.50f;
     float bandDensity   = 0.03f;      // deadband around target
     float kp_den        = 0.75f * 0.02f; // P-gain for density error (scaled)
 
+    // Density sampling
+    DensityReadback readback; initReadback(readback);
+    int      sampleEvery   = 1;       // metric pass + readback every Nth frame (key N)
+    int      maxSampleAge  = 8;       // frames; older samples are not acted on
+    uint64_t frameIndex    = 0;
+    bool     prevN = false;
+
+    // GPU time: scene pass is the governed cost, metric pass is the governor's own
+    GpuTimer sceneTimer, metricTimer;
+    sceneTimer.init(); metricTimer.init();
+    gov.gpuBudgetMs = 8.0;            // scene GPU time; 0 disables
+    bool prevP = false, prevO = false;
+
     // --- Main loop ---
     while(!glfwWindowShouldClose(window)){
         glfwPollEvents();
 
         // Keys: load harness, toggle, targets, manual bias
-        if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) addDummyBatch(10);
-        if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS) freeDummyBatch(10);
+        // P / O once per press: every dummy is its own admission request
+        bool keyP = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS, keyO = glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS;
+        if (keyP && !prevP) addDummyBatch(10);
+        if (keyO && !prevO) freeDummyBatch(10);
+        prevP = keyP; prevO = keyO;
         if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS) governorOn = true;
         if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS) governorOn = false;
-        if (glfwGetKey(window, GLFW_KEY_PERIOD) == GLFW_PRESS) targetFreeMB += 256;
-        if (glfwGetKey(window, GLFW_KEY_COMMA)  == GLFW_PRESS) targetFreeMB = std::max(128, targetFreeMB - 256);
-        if (glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS) lodBias += 0.01f;
-        if (glfwGetKey(window, GLFW_KEY_LEFT_BRACKET)  == GLFW_PRESS) lodBias -= 0.01f;
-
-        // Handle resize (recreate FBO)
+        if (glfwGetKey(window, GLFW_KEY_PERIOD) == GLFW_PRESS) gov.targetFreeMB += 256;
+        if (glfwGetKey(window, GLFW_KEY_COMMA)  == GLFW_PRESS) gov.targetFreeMB = std::max(128, gov.targetFreeMB - 256);
+        if (glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS) gov.step(cube, +0.01f);
+        if (glfwGetKey(window, GLFW_KEY_LEFT_BRACKET)  == GLFW_PRESS) gov.step(cube, -0.01f);
+        bool keyN = glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS;
+        if (keyN && !prevN){ sampleEvery = sampleEvery >= 8 ? 1 : sampleEvery*2; std::cout<<"[metric] every "<<sampleEvery<<" frame(s)\n"; }
+        prevN = keyN;
+        bool keyM = glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+        if (keyM && !prevM){ metricDiv = metricDiv==1 ? 4 : metricDiv==4 ? 8 : 1; std::cout<<"[metric] 1/"<<metricDiv<<" resolution\n"; }
+        prevM = keyM;
+        ++frameIndex;
+        bool sampleThisFrame = (frameIndex % (uint64_t)sampleEvery) == 0;
+
+        // Handle resize (reuses storage up to the high-water mark)
         int ww=0, hh=0; glfwGetFramebufferSize(window,&ww,&hh);
-        if (ww != fbo.w || hh != fbo.h){
-            createFBO(fbo, ww, hh);
-        }
+        ensureFBO(fbo, ww, hh, true, metricDiv==1, !useCompute);
+        if (metricDiv > 1) ensureFBO(metricFbo, ww/metricDiv, hh/metricDiv, false, true, !useCompute);
+        else if (metricFbo.fbo) destroyFBO(metricFbo);
+        FBO& mf = metricDiv > 1 ? metricFbo : fbo;     // the target holding this frame's metric
 
         // Build MVP (column-major)
         glViewport(0,0,fbo.w,fbo.h);
@@ -413,61 +670,80 @@ int main(){
         mul44(proj, view, pv);
         mul44(pv, model, mvp);
 
-        // --- Draw scene into FBO with MRT (color + metric) ---
+        // --- Draw scene into FBO (with MRT metric at full res) ---
+        // Off-sample frames skip the metric attachment entirely.
+        sceneTimer.begin();
         glBindFramebuffer(GL_FRAMEBUFFER, fbo.fbo);
+        if (fbo.metric){
+            GLenum bufs[2] = { GL_COLOR_ATTACHMENT0, sampleThisFrame ? (GLenum)GL_COLOR_ATTACHMENT1 : (GLenum)GL_NONE };
+            glDrawBuffers(2, bufs);
+        }
         glEnable(GL_DEPTH_TEST);
-        glClearColor(0.07f,0.10f,0.15f,1.0f);
+        glClearColor(kClearColor[0],kClearColor[1],kClearColor[2],kClearColor[3]);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (fbo.metric && sampleThisFrame) clearMetric(fbo, useCompute);
 
-        glUseProgram(prog);
-        glUniformMatrix4fv(uMVP, 1, GL_FALSE, mvp);
+        bool mrtMetric = fbo.metric && sampleThisFrame;
+        glUseProgram(mrtMetric ? prog : colorProg);
+        glUniformMatrix4fv(mrtMetric ? uMVP : uColorMVP, 1, GL_FALSE, mvp);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, tex);
         glBindSampler(0, samp);
         glBindVertexArray(vao);
         glDrawElements(GL_TRIANGLES, (GLsizei)(sizeof(cubeIdx)/sizeof(unsigned)), GL_UNSIGNED_INT, 0);
-
-        // --- Compute frame-average density via mipmap on metricTex ---
-        glBindTexture(GL_TEXTURE_2D, fbo.metricTex);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        float avgDensity = 0.0f;
-        {
-            int lastLevel = fbo.metricMipCount - 1; // 1x1
-            glGetTexImage(GL_TEXTURE_2D, lastLevel, GL_RED, GL_FLOAT, &avgDensity);
-        }
-
-        // --- VRAM telemetry (if available) ---
-        queryVRAM_MB(totalMB, freeMB, vramOK);
-
-        // --- Controller: "best of both" ---------------------------------
-        // 1) If VRAM present and below threshold band -> bias up aggressively
-        if (governorOn && vramOK && freeMB >= 0){
-            int low  = targetFreeMB - bandMB;
-            int high = targetFreeMB + bandMB;
-            if (freeMB < low){
-                float err = float(low - freeMB);
-                float step = std::min(rate, kp_vram * err);
-                lodBias += step; // more blur
-            } else if (freeMB > high){
-                float err = float(freeMB - high);
-                float step = std::min(rate, kp_vram * err);
-                lodBias -= step; // sharper
+        sceneTimer.end();
+
+        // --- Frame density: [reduced-res metric pass,] then compute reduction, or mipmap the
+        //     metric texture and read its 1x1 (both async) ---
+        if (sampleThisFrame){
+            metricTimer.begin();
+            if (metricDiv > 1){
+                glBindFramebuffer(GL_FRAMEBUFFER, metricFbo.fbo);
+                glViewport(0,0,metricFbo.w,metricFbo.h);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                clearMetric(metricFbo, useCompute);
+                glUseProgram(metricProg);
+                glUniformMatrix4fv(uMetricMVP, 1, GL_FALSE, mvp);
+                glUniform1f(uMetricScale, (float)fbo.w / (float)metricFbo.w);
+                glDrawElements(GL_TRIANGLES, (GLsizei)(sizeof(cubeIdx)/sizeof(unsigned)), GL_UNSIGNED_INT, 0);
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            if (useCompute){
+                issueComputeReduction(readback, reduceProg, mf.metricTex, mf.w, mf.h, frameIndex);
+            } else {
+                glBindTexture(GL_TEXTURE_2D, mf.metricTex);
+                glGenerateMipmap(GL_TEXTURE_2D);
+                issueMipReadback(readback, mf.metricTex, mf.metricMipCount - 1, mipMeanScale(mf), frameIndex);
             }
+            metricTimer.end();
         }
+        bool freshSample = pollReadback(readback);
+        const DensitySample& dens = readback.latest;
+        float avgDensity = dens.mean;
+        float ctrlDensity = dens.hasHist ? dens.p90 : dens.mean;
+        float ctrlTarget  = dens.hasHist ? targetP90 : targetDensity;
+        int sampleAge = readback.hasSample ? (int)(frameIndex - readback.latestFrame) : -1;
 
-        // 2) Always run density keeper (small correction) so visual quality stabilizes
-        if (governorOn){
-            float err = avgDensity - targetDensity;
-            if (std::fabs(err) > bandDensity){
+        // --- Controller: "best of both" ---------------------------------
+        // 1) frame(): retire, telemetry (or the ledger model), then the VRAM band and the GPU
+        //    frame-time constraint step the cube, then waiting dummies are admitted. Retiring
+        //    dummies count as free: don't blur for memory that is on its way out.
+        gov.enabled = governorOn;
+        const VgFrameStats& st = gVg.frame(glfwGetTime(), sceneTimer.avgMs());
+        if (!st.waiting) gTexPool.trimTo(0);    // pooled dummies only pay off while more wait
+        bool gpuOver = gov.gpuBudgetMs > 0.0 && sceneTimer.hasResult() && sceneTimer.avgMs() > gov.gpuBudgetMs;
+        bool gpuNear = gov.gpuBudgetMs > 0.0 && sceneTimer.hasResult() && sceneTimer.avgMs() > gov.gpuBudgetMs*(1.0 - gov.gpuSlack);
+
+        // 2) Always run density keeper (small correction) so visual quality stabilizes.
+        //    Each sample is acted on once; it describes a bias from `sampleAge` frames ago.
+        if (governorOn && freshSample && sampleAge <= maxSampleAge){
+            float err = ctrlDensity - ctrlTarget;
+            if (std::fabs(err) > bandDensity && !(err < 0.f && gpuNear)){
                 // Small-step correction around target
-                float step = std::clamp(kp_den * err, -rate*0.5f, rate*0.5f);
-                lodBias += step;
+                gov.step(cube, std::clamp(kp_den * err, -rate*0.5f, rate*0.5f));
             }
         }
-
-        // Clamp bias to hardware-reasonable range
-        lodBias = std::clamp(lodBias, -0.25f, 3.0f);
-        glSamplerParameterf(samp, GL_TEXTURE_LOD_BIAS, lodBias);
+        glSamplerParameterf(samp, GL_TEXTURE_LOD_BIAS, gVg.bias(cube));
 
         // --- Blit color to default framebuffer ---
         glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.fbo);
@@ -480,12 +756,19 @@ int main(){
         double now = glfwGetTime();
         if (now - t0 > 0.7){
             std::cout
-                << "freeMB=" << (vramOK?freeMB:-1)
-                << "  targetFreeMB=" << targetFreeMB
+                << "freeMB=" << (st.telemetryValid?st.freeMB:-1)
+                << "  targetFreeMB=" << gov.targetFreeMB
                 << "  avgDensity=" << avgDensity
-                << "  targetDensity=" << targetDensity
-                << "  bias=" << lodBias
-                << "  dummyTex=" << gDummyTex.size()
+                << " (age " << sampleAge << "f, every " << sampleEvery << ", 1/" << metricDiv << " res)";
+            if (dens.hasHist)
+                std::cout << "  min/max/p90=" << dens.minD << "/" << dens.maxD << "/" << dens.p90
+                          << "  px=" << dens.pixels;
+            std::cout
+                << "  target" << (dens.hasHist ? "P90=" : "Density=") << ctrlTarget
+                << "  bias=" << gVg.bias(cube)
+                << "  gpu scene/metric=" << sceneTimer.avgMs() << "/" << metricTimer.avgMs() << "ms"
+                << (gpuOver ? " OVER" : "")
+                << "  dummyTex=" << gDummyTex.size() << " (+" << st.waiting << " waiting, " << st.retiringMB << "MB retiring)"
                 << "  gov:" << (governorOn ? "on" : "off")
                 << "\n";
             t0 = now;
@@ -494,14 +777,22 @@ int main(){
         glfwSwapBuffers(window);
     }
 
-    // Cleanup
-    for (GLuint t : gDummyTex) glDeleteTextures(1,&t);
+    // Cleanup (shutdown drains the retire queue and the pool)
+    trackedDeleteTextures((int)gDummyTex.size(), gDummyTex.data());
+    gVg.shutdown();
+    destroyReadback(readback);
+    sceneTimer.shutdown();
+    metricTimer.shutdown();
+    if (reduceProg) glDeleteProgram(reduceProg);
     destroyFBO(fbo);
+    destroyFBO(metricFbo);
+    glDeleteProgram(metricProg);
+    glDeleteProgram(colorProg);
     glDeleteSamplers(1,&samp);
-    glDeleteTextures(1,&tex);
+    trackedDeleteTextures(1,&tex);
     glDeleteProgram(prog);
-    glDeleteBuffers(1,&ebo);
-    glDeleteBuffers(1,&vbo);
+    trackedDeleteBuffers(1,&ebo);
+    trackedDeleteBuffers(1,&vbo);
     glDeleteVertexArrays(1,&vao);
     glfwDestroyWindow(window);
     glfwTerminate();
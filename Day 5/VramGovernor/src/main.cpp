@@ -1,7 +1,12 @@
 // Day 5R — Priority-aware VRAM Governor with REAL VRAM commitment (Day-4 style)
 // Forces driver to commit VRAM for each pad by FBO clear + mipgen.
 // Auto-switches from telemetry to fallback if driver counter doesn't move.
-// Hotkeys: B (alloc ~256MB), Shift+B (free), [ / ] (global bias nudge), R (reset), C (toggle telemetry manually)
+// Runs on the vram_governor library (Day 6): its Telemetry, Governor and allocation ledger; the
+// three panels are three governed objects (Low / Normal / High) in BiasOnly residency.
+// Fallback freeMB comes from the ledger (exact bytes incl. mips), not a pad count.
+// Controller: band (reactive), predictive (freeMB trend + announced pads), PID with anti-windup.
+// Hotkeys: B (alloc a ~341MB pad), Shift+B (free), [ / ] (global bias nudge), R (reset), C (toggle telemetry manually),
+//          P (cycle controller)
 
 #include <cstdio>
 #include <cstdlib>
@@ -14,13 +19,8 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-#ifndef GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX
-#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX         0x9047
-#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX    0x9048
-#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX  0x9049
-#define GL_GPU_MEMORY_INFO_EVICTION_COUNT_NVX            0x904A
-#define GL_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX            0x904B
-#endif
+#include "vram_governor.h"      // Governor, Telemetry, shader helpers
+#include "ledger.h"
 
 #ifndef GL_TEXTURE_MAX_LEVEL
 #define GL_TEXTURE_MAX_LEVEL 0x813D
@@ -32,23 +32,6 @@ static void glCheck(const char* where){
     if (e != GL_NO_ERROR) std::fprintf(stderr,"[GL] err=0x%X at %s\n",(unsigned)e, where);
 }
 
-static GLuint compile(GLenum type, const char* src){
-    GLuint s=glCreateShader(type);
-    glShaderSource(s,1,&src,nullptr);
-    glCompileShader(s);
-    GLint ok=0; glGetShaderiv(s,GL_COMPILE_STATUS,&ok);
-    if(!ok){ GLint len=0; glGetShaderiv(s,GL_INFO_LOG_LENGTH,&len); std::string log(len,'\0');
-        glGetShaderInfoLog(s,len,nullptr,log.data()); std::fprintf(stderr,"shader err:\n%s\n",log.c_str()); std::exit(1);}
-    return s;
-}
-static GLuint link(GLuint vs, GLuint fs){
-    GLuint p=glCreateProgram(); glAttachShader(p,vs); glAttachShader(p,fs); glLinkProgram(p);
-    GLint ok=0; glGetProgramiv(p,GL_LINK_STATUS,&ok);
-    if(!ok){ GLint len=0; glGetProgramiv(p,GL_INFO_LOG_LENGTH,&len); std::string log(len,'\0');
-        glGetProgramInfoLog(p,len,nullptr,log.data()); std::fprintf(stderr,"link err:\n%s\n",log.c_str()); std::exit(1);}
-    return p;
-}
-
 // ---------- Fullscreen tri-strip ----------
 static const float QUAD[] = {
     -1.f,-1.f, 0.f,0.f,   1.f,-1.f, 1.f,0.f,   1.f, 1.f, 1.f,1.f,
@@ -75,37 +58,40 @@ static std::vector<uint8_t> makeChecker(int w,int h,int chk=32){
     }
     return v;
 }
+
 static GLuint makeCheckerTex(int W=2048,int H=2048){
     auto pix = makeChecker(W,H,32);
-    GLuint t=0; glGenTextures(1,&t); glBindTexture(GL_TEXTURE_2D,t);
+    int levels = 1 + (int)std::floor(std::log2(std::max(W,H)));
+    GLuint t = trackedTexStorage2D(MemTag::Governed, levels, GL_RGBA8, W, H);
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
-    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA8,W,H,0,GL_RGBA,GL_UNSIGNED_BYTE,pix.data());
+    glTexSubImage2D(GL_TEXTURE_2D,0,0,0,W,H,GL_RGBA,GL_UNSIGNED_BYTE,pix.data());
     glGenerateMipmap(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D,0);
     return t;
 }
 
 // ---------- “Pad” textures that COMMIT VRAM (≈256MB each) ----------
-// 8192x8192 RGBA8 ≈ 256 MiB at base level; with mipmaps ≈ +33%.
+// 8192x8192 RGBA8 ≈ 256 MiB at base level; with mipmaps ≈ +33% (the ledger counts ~341 MiB).
 static const int PAD_W = 8192;
 static const int PAD_H = 8192;
+static int    padLevels(){ return 1 + (int)std::floor(std::log2(std::max(PAD_W,PAD_H))); }
+static double padMB(){ return chainBytes(GL_RGBA8, PAD_W, PAD_H, padLevels()) / (1024.0*1024.0); }   // what one pad commits
 
 struct Pad {
     GLuint tex=0, fbo=0;
+    size_t bytes=0;
 };
 static std::vector<Pad> gPads;
 
 static Pad createCommittedPad(){
     Pad P{};
-    glGenTextures(1,&P.tex);
-    glBindTexture(GL_TEXTURE_2D, P.tex);
-
     // Allocate immutable storage + full mip pyramid
-    int levels = 1 + (int)std::floor(std::log2(std::max(PAD_W,PAD_H)));
-    glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, PAD_W, PAD_H);
+    int levels = padLevels();
+    P.tex = trackedTexStorage2D(MemTag::Pad, levels, GL_RGBA8, PAD_W, PAD_H);
+    P.bytes = chainBytes(GL_RGBA8, PAD_W, PAD_H, levels);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels-1);
@@ -137,47 +123,16 @@ static Pad createCommittedPad(){
 
 static void destroyPad(Pad& P){
     if (P.fbo) glDeleteFramebuffers(1,&P.fbo);
-    if (P.tex) glDeleteTextures(1,&P.tex);
-    P.fbo=0; P.tex=0;
+    if (P.tex) trackedDeleteTextures(1,&P.tex);
+    P.fbo=0; P.tex=0; P.bytes=0;
 }
 
-// ---------- Telemetry / Fallback ----------
-enum class TelMode { NVX, ATI, FALLBACK };
-
-struct Telemetry {
-    TelMode mode = TelMode::FALLBACK;
-    bool nvx=false, ati=false;
-    bool useTelemetry=true;          // we will auto-flip this if frozen
-    int  fallbackBaseFreeMB = 2048;  // only used in fallback
-    int  padBlocks = 0;
-
-    void init(){
-        GLint n=0; glGetIntegerv(GL_NUM_EXTENSIONS,&n);
-        for(GLint i=0;i<n;++i){
-            const char* ext = (const char*)glGetStringi(GL_EXTENSIONS,(GLuint)i);
-            if(!ext) continue; std::string s(ext);
-            if(s=="GL_NVX_gpu_memory_info") nvx=true;
-            if(s=="GL_ATI_meminfo")         ati=true;
-        }
-        mode = nvx ? TelMode::NVX : (ati ? TelMode::ATI : TelMode::FALLBACK);
-        std::printf("[Init] Telemetry NVX=%d ATI=%d -> %s\n",
-            nvx?1:0, ati?1:0, mode==TelMode::NVX?"NVX":(mode==TelMode::ATI?"ATI":"FALLBACK"));
-    }
-
-    std::pair<bool,int> readFreeMB(){
-        if(useTelemetry){
-            if(mode==TelMode::NVX){
-                GLint kb=0; glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX,&kb);
-                if(glGetError()==GL_NO_ERROR && kb>0) return {true, kb/1024};
-            } else if(mode==TelMode::ATI){
-                GLint kb[4]={0,0,0,0}; glGetIntegerv(0x87FC, kb); // GL_TEXTURE_FREE_MEMORY_ATI
-                if(glGetError()==GL_NO_ERROR && kb[0]>0) return {true, kb[0]/1024};
-            }
-        }
-        int freeMB = std::max(0, fallbackBaseFreeMB - padBlocks * 256);
-        return {false, freeMB};
-    }
-};
+// ---------- Governor library ----------
+// Telemetry (NVX / ATI / DXGI / fallback on the ledger) and the governor; one object per panel.
+static VramGovernor gVg;
+static Telemetry& gTel = gVg.telemetry();
+static Governor&  gGov = gVg.governor();
+static int gPanel[3] = { -1, -1, -1 };     // Low, Normal, High
 
 // Auto-detect frozen telemetry: if two consecutive pad allocations
 // don’t move the telemetry by >=128 MB, switch to fallback automatically.
@@ -185,7 +140,7 @@ struct TelWatchdog {
     int lastMB = -1;
     int consecutiveNoMoves = 0;
     void onAllocCheck(Telemetry& tel){
-        auto [valid, nowMB] = tel.readFreeMB();
+        auto [valid, nowMB] = tel.readNow(glfwGetTime());
         if(!valid) return; // already fallback
         if(lastMB<0){ lastMB = nowMB; return; }
         int delta = lastMB - nowMB; // expected positive if memory decreased
@@ -202,58 +157,14 @@ struct TelWatchdog {
     }
 } gWatch;
 
-// ---------- Governor ----------
-struct Governor {
-    int   targetFreeMB = 1024;
-    int   hysteresisMB = 128;
-    int   spikeThreshMB = 256;
-    float biasLow=0.f, biasNorm=0.f, biasHigh=0.f;
-    float biasMin=0.f, biasMax=8.f;
-    float stepGradual=0.5f, stepSpike=1.25f;
-    float globalNudge=0.f;
-
-    int lastFreeMB=-1;
-    double lastEval=0.0, evalDt=0.25;
-    double lastPrint=0.0;
-
-    void clamp(){ auto C=[&](float& x){ x=std::clamp(x,biasMin,biasMax); };
-        C(biasLow); C(biasNorm); C(biasHigh); }
-    void reset(){ biasLow=biasNorm=biasHigh=0.f; globalNudge=0.f; lastFreeMB=-1; }
-
-    void escalate(){ if(biasLow<biasMax) biasLow+=stepGradual;
-                     else if(biasNorm<biasMax) biasNorm+=stepGradual;
-                     else if(biasHigh<biasMax) biasHigh+=stepGradual; clamp(); }
-    void deescalate(){ if(biasHigh>biasMin) biasHigh-=stepGradual;
-                       else if(biasNorm>biasMin) biasNorm-=stepGradual;
-                       else if(biasLow>biasMin) biasLow-=stepGradual; clamp(); }
-    void spike(){ biasLow += stepSpike; clamp(); }
-    void nudge(float d){ globalNudge = std::clamp(globalNudge+d, -4.f, 4.f); }
-
-    void evaluate(double now, int freeMB, bool telValid){
-        if(lastFreeMB<0){ lastFreeMB=freeMB; lastEval=now; return; }
-        if(now-lastEval < evalDt) return;
-        lastEval = now;
-
-        int delta = freeMB - lastFreeMB; // negative = drop
-        if(delta <= -spikeThreshMB) spike();
-        int lo = targetFreeMB - hysteresisMB;
-        int hi = targetFreeMB + hysteresisMB;
-        if(freeMB < lo) escalate();
-        else if(freeMB > hi) deescalate();
-        lastFreeMB = freeMB;
-
-        if(now-lastPrint>0.5){
-            lastPrint=now;
-            std::printf("freeMB=%4d (Δ %+4d) [%s] Bias L/N/H=%.2f/%.2f/%.2f global=%.2f\n",
-                freeMB, delta, telValid?"telemetry":"fallback",
-                biasLow,biasNorm,biasHigh,globalNudge);
-        }
-    }
-} gGov;
+// Biases back to 0, nudge cleared, controller state dropped.
+static void resetGovernor(){
+    gGov.resetBiases(); gGov.globalNudge = 0.f; gGov.lastFreeMB = -1;
+    gGov.trend.clear(); gGov.setControl(gGov.control());
+}
 
 // ---------- GL State ----------
 static GLuint gProg=0, gVAO=0, gVBO=0, gSceneTex=0;
-static Telemetry gTel;
 static bool gRunning=true;
 
 // ---------- Draw three panels ----------
@@ -273,32 +184,37 @@ static void keyCB(GLFWwindow*, int key,int, int action,int mods){
     switch(key){
         case GLFW_KEY_ESCAPE: gRunning=false; break;
         case GLFW_KEY_B: {
-            // Make and commit a pad; check telemetry right after
+            // Announce, make and commit a pad; check telemetry right after
+            gGov.announce(padMB(), glfwGetTime());
             Pad P = createCommittedPad();
             gPads.push_back(P);
-            gTel.padBlocks = (int)gPads.size();
             glFinish();                 // ensure work is flushed so NVX can update
             gWatch.onAllocCheck(gTel);  // auto-fallback if frozen
-            std::printf("[Pad] +%dMB  pads=%d\n", 256, (int)gPads.size());
+            std::printf("[Pad] +%zuMB  pads=%d  ledger=%zuMB\n", P.bytes>>20, (int)gPads.size(), gLedger.total()>>20);
         } break;
         case GLFW_KEY_LEFT_BRACKET:  gGov.nudge(-0.125f); break;
         case GLFW_KEY_RIGHT_BRACKET: gGov.nudge(+0.125f); break;
         case GLFW_KEY_R: {
             for(auto& P: gPads) destroyPad(P);
-            gPads.clear(); gTel.padBlocks=0; gGov.reset();
+            gPads.clear(); resetGovernor();
             std::printf("[Reset] pads cleared, biases reset.\n");
         } break;
         case GLFW_KEY_C: {
             gTel.useTelemetry = !gTel.useTelemetry;
             std::printf("[Toggle] useTelemetry=%s\n", gTel.useTelemetry?"true":"false");
         } break;
+        case GLFW_KEY_P:
+            gGov.setControl(gGov.control()==ControlMode::Band ? ControlMode::Predictive
+                          : gGov.control()==ControlMode::Predictive ? ControlMode::PID : ControlMode::Band);
+            std::printf("[Toggle] control=%s\n", controlName(gGov.control()));
+            break;
         case GLFW_KEY_LEFT_SHIFT:
         case GLFW_KEY_RIGHT_SHIFT: break;
         default:
             // Shift+B to free one
             if((mods & GLFW_MOD_SHIFT) && key==GLFW_KEY_B){
-                if(!gPads.empty()){ destroyPad(gPads.back()); gPads.pop_back(); gTel.padBlocks=(int)gPads.size();
-                    std::printf("[Pad] -%dMB  pads=%d\n", 256, (int)gPads.size()); }
+                if(!gPads.empty()){ size_t mb=gPads.back().bytes>>20; destroyPad(gPads.back()); gPads.pop_back();
+                    std::printf("[Pad] -%zuMB  pads=%d  ledger=%zuMB\n", mb, (int)gPads.size(), gLedger.total()>>20); }
             }
         break;
     }
@@ -329,25 +245,32 @@ int main(){
 
     // Geometry
     glGenBuffers(1,&gVBO); glBindBuffer(GL_ARRAY_BUFFER,gVBO);
-    glBufferData(GL_ARRAY_BUFFER,sizeof(QUAD),QUAD,GL_STATIC_DRAW);
+    trackedBufferData(MemTag::Geometry, GL_ARRAY_BUFFER, gVBO, sizeof(QUAD), QUAD, GL_STATIC_DRAW);
     glGenVertexArrays(1,&gVAO); glBindVertexArray(gVAO);
     glEnableVertexAttribArray(0); glVertexAttribPointer(0,2,GL_FLOAT,GL_FALSE,sizeof(float)*4,(void*)0);
     glEnableVertexAttribArray(1); glVertexAttribPointer(1,2,GL_FLOAT,GL_FALSE,sizeof(float)*4,(void*)(sizeof(float)*2));
     glBindVertexArray(0); glBindBuffer(GL_ARRAY_BUFFER,0);
 
-    GLuint vs=compile(GL_VERTEX_SHADER,VS), fs=compile(GL_FRAGMENT_SHADER,FS);
-    gProg=link(vs,fs); glDeleteShader(vs); glDeleteShader(fs);
+    GLuint vs=vgCompileShader(GL_VERTEX_SHADER,VS), fs=vgCompileShader(GL_FRAGMENT_SHADER,FS);
+    gProg = vs && fs ? vgLinkProgram(vs,fs) : 0;
+    if(vs) glDeleteShader(vs);
+    if(fs) glDeleteShader(fs);
+    if(!gProg) return 1;
 
     gSceneTex = makeCheckerTex(2048,2048);
 
-    // Telemetry: start by trusting it; watchdog will switch to fallback if frozen
-    gTel.init();
-    // Nice baseline if we fall back later; seed from NVX total if available
-    GLint kbTotal=0; glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &kbTotal);
-    if(glGetError()==GL_NO_ERROR && kbTotal>0) gTel.fallbackBaseFreeMB = (kbTotal/1024)*9/10;
-    else gTel.fallbackBaseFreeMB = 6000; // harmless default
+    // Telemetry: start by trusting it; watchdog will switch to fallback if frozen. The fallback
+    // baseline is seeded from the NVX total when available (VramGovernor::init).
+    VgConfig cfg;
+    cfg.asyncUploads = false;       // nothing streams: the panels only move their sampler bias
+    cfg.verbose = true;
+    gVg.init(cfg);
+    // One object per panel, biases only; one step per tick walks Low, then Normal, then High.
+    gGov.residency = ResidencyMode::BiasOnly;
+    gGov.stepBudgetPerTick = 1;
+    for(int p=0;p<3;++p) gPanel[p] = gGov.add((Priority)p, 0.f, 8.f);
 
-    std::puts("Hotkeys: B (+256MB), Shift+B (-256MB), [ / ] nudge, R reset, C toggle telemetry");
+    std::puts("Hotkeys: B (+pad), Shift+B (-pad), [ / ] nudge, R reset, C toggle telemetry, P controller");
 
     while(!glfwWindowShouldClose(win) && gRunning){
         glfwPollEvents();
@@ -357,30 +280,30 @@ int main(){
         glClearColor(0.11f,0.12f,0.14f,1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        auto [valid, freeMB] = gTel.readFreeMB();
-        double t = glfwGetTime();
-        gGov.evaluate(t, freeMB, valid);
+        const VgFrameStats& st = gVg.frame(glfwGetTime());
+        bool valid = st.telemetryValid; int freeMB = st.freeMB;
 
         // Panels: Left=Low, Center=Normal, Right=High
         int third = std::max(1, W/3);
-        drawPanel(0,0, third, H, gGov.biasLow  + gGov.globalNudge, gSceneTex);
-        drawPanel(third,0, third, H, gGov.biasNorm + gGov.globalNudge, gSceneTex);
-        drawPanel(third*2,0, W - third*2, H, gGov.biasHigh + gGov.globalNudge, gSceneTex);
+        drawPanel(0,0, third, H, gVg.bias(gPanel[0]), gSceneTex);
+        drawPanel(third,0, third, H, gVg.bias(gPanel[1]), gSceneTex);
+        drawPanel(third*2,0, W - third*2, H, gVg.bias(gPanel[2]), gSceneTex);
 
         // HUD in title
         char title[256];
         std::snprintf(title,sizeof(title),
             "Day5R | freeMB=%d [%s] | Bias L/N/H=%.2f/%.2f/%.2f | pads=%zu",
-            freeMB, valid?"telemetry":"fallback", gGov.biasLow,gGov.biasNorm,gGov.biasHigh, gPads.size());
+            freeMB, valid?"telemetry":"fallback", gGov.bias(gPanel[0]),gGov.bias(gPanel[1]),gGov.bias(gPanel[2]), gPads.size());
         glfwSetWindowTitle(win, title);
 
         glfwSwapBuffers(win);
     }
 
     for(auto& P: gPads) destroyPad(P);
-    glDeleteTextures(1,&gSceneTex);
+    gVg.shutdown();
+    trackedDeleteTextures(1,&gSceneTex);
     glDeleteVertexArrays(1,&gVAO);
-    glDeleteBuffers(1,&gVBO);
+    trackedDeleteBuffers(1,&gVBO);
     glDeleteProgram(gProg);
     glfwDestroyWindow(win);
     glfwTerminate();
@@ -0,0 +1,116 @@
+// Admission — ask the governor before allocating
+// - request(mb, priority, alloc) runs `alloc` right away if free memory (less what is already
+//   announced) stays above floorMB after it
+// - Otherwise it plans one bias step on lower-priority objects; if their predicted release
+//   covers the shortfall the steps are taken, applyShed makes them resident (the app frees the
+//   mips) and `alloc` runs. Nothing is degraded unless it buys the whole request
+// - Otherwise the request waits in a queue that service() retries each tick, highest
+//   priority and oldest first
+// - Every grant is announced to the governor, so its forecast counts it before telemetry does
+// - No GL: the app supplies the allocation and the residency sync as callbacks
+#pragma once
+
+#include <cstdio>
+#include <cmath>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+#include "governor.h"
+
+enum class Admission { Granted, GrantedAfterShed, Deferred };
+inline const char* admissionName(Admission a){
+    return a==Admission::Granted ? "granted" : a==Admission::GrantedAfterShed ? "granted after shed" : "deferred";
+}
+
+class AdmissionControl {
+public:
+    using AllocFn = std::function<void()>;
+
+    int   floorMB = 256;        // free VRAM a grant must leave; below it the driver starts paging
+    int   maxShedSteps = 32;    // objects one request may degrade
+    std::function<void()> applyShed;   // apply the governor's new biases to residency now
+
+    explicit AdmissionControl(Governor& g) : g_(g) {}
+
+    Admission request(double mb, Priority p, double now, AllocFn alloc, const char* what="alloc"){
+        Admission a = admit(mb, p, now, true);
+        if(a==Admission::Deferred){
+            queue_.push_back({mb, p, now, std::move(alloc), what});
+            std::printf("[Admit] %s %.0fMB (%s) deferred, %zu waiting\n", what, mb, priorityName(p), queue_.size());
+        } else {
+            if(a==Admission::GrantedAfterShed) std::printf("[Admit] %s %.0fMB (%s) granted after shed\n", what, mb, priorityName(p));
+            alloc();
+        }
+        return a;
+    }
+    // Grant-or-refuse for allocations the caller simply retries later (nothing is queued).
+    bool tryAdmit(double mb, Priority p, double now, bool allowShed=false){
+        return admit(mb, p, now, allowShed) != Admission::Deferred;
+    }
+
+    // Retry the queue: priority order, FIFO within a priority, stopping a priority at the
+    // first request that still doesn't fit so later ones don't overtake it.
+    void service(double now){
+        VG_ZONE("admission.service");
+        for(int p=Governor::kPriorities-1; p>=0; --p){
+            for(auto it=queue_.begin(); it!=queue_.end(); ){
+                if((int)it->prio!=p){ ++it; continue; }
+                if(admit(it->mb, it->prio, now, true)==Admission::Deferred) break;
+                std::printf("[Admit] %s %.0fMB (%s) granted after %.2fs\n", it->what, it->mb, priorityName(it->prio), now-it->since);
+                AllocFn fn = std::move(it->alloc);
+                it = queue_.erase(it);
+                fn();
+            }
+        }
+    }
+    size_t waiting() const { return queue_.size(); }
+    double waitingMB() const { double s=0; for(const auto& r : queue_) s+=r.mb; return s; }
+    void clear(){ queue_.clear(); }
+    // Withdraw up to n of the most recent waiting requests (nothing was announced for them).
+    size_t cancelNewest(size_t n){
+        size_t k = std::min(n, queue_.size());
+        queue_.erase(queue_.end() - (std::ptrdiff_t)k, queue_.end());
+        return k;
+    }
+
+private:
+    struct Request { double mb; Priority prio; double since; AllocFn alloc; const char* what; };
+
+    static const char* priorityName(Priority p){ return p==Priority::Low?"low":p==Priority::Normal?"normal":"high"; }
+
+    double headroomMB() const { return g_.sampleFreeMB() - g_.pendingMB() - floorMB; }
+
+    Admission admit(double mb, Priority p, double now, bool allowShed){
+        if(g_.sampleFreeMB() < 0 || mb <= headroomMB()){ g_.announce(mb, now); return Admission::Granted; }
+        if(!allowShed || p==Priority::Low) return Admission::Deferred;
+
+        // One whole-level step per object, lowest priority first, best MB-per-quality first.
+        double need = mb - headroomMB(), freed = 0.0;
+        plan_.clear();
+        for(int q=0; q<(int)p && freed<need; ++q){
+            ids_.clear();
+            g_.candidates((Priority)q, true, maxShedSteps - (int)plan_.size(), ids_);
+            for(int id : ids_){
+                float b = g_.bias(id);
+                float target = std::min(g_.biasMax(id), std::floor(b) + 1.f);
+                double mbFreed = g_.estMB(id) - g_.predictMB(id, target);
+                if(mbFreed <= 0.0) continue;
+                plan_.push_back({id, target - b}); freed += mbFreed;
+                if(freed >= need) break;
+            }
+        }
+        if(freed < need) return Admission::Deferred;
+        for(const auto& s : plan_) g_.step(s.id, s.delta);
+        if(applyShed) applyShed();
+        g_.announce(std::max(0.0, mb - freed), now);
+        return Admission::GrantedAfterShed;
+    }
+
+    struct Step { int id; float delta; };
+    Governor& g_;
+    std::deque<Request> queue_;
+    std::vector<int>  ids_;
+    std::vector<Step> plan_;
+};
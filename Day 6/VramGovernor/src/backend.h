@@ -0,0 +1,65 @@
+// GpuBackend — what the governor loop needs from a graphics API
+// - Budget telemetry, governed textures (a full mip chain of which [top .. levels-1] is
+//   resident), committed pressure allocations ("pads"), a per-frame pump and a grid draw
+// - The Governor / AdmissionControl never see API objects: they get freeMB from
+//   sampleBudget(), footprints from residentBytes(), and call setResidentTop() through the app
+// - GlBackend (gl_backend.h) wraps Telemetry + residency.h; VkBackend (vk_backend.h, built
+//   with VG_VULKAN) uses VK_EXT_memory_budget, a block suballocator and a transfer queue
+// - Handles are small ints, indices into the backend's own tables
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "residency.h"      // LevelSource
+
+struct BudgetSample {
+    bool        valid = false;
+    int         freeMB = 0, totalMB = -1;
+    const char* source = "none";    // telemetry mode / API that produced it
+    double      time = 0.0;         // when it was read (a backend may return a cached sample)
+};
+
+// One visible texture in the grid: NDC rect and the bias to sample it with.
+struct GridDraw { int tex; float x0, y0, x1, y1, bias; };
+
+class GpuBackend {
+public:
+    virtual ~GpuBackend() = default;
+
+    // Storage whose retirement is done, in bytes: deleted through the driver (GL), or back in
+    // its suballocation block (Vulkan). Either way sampleBudget() counts it as free from then on.
+    std::function<void(size_t bytes)> onFreed;
+
+    virtual const char* name() const = 0;
+    virtual std::string device() const = 0;
+    virtual bool init(int fallbackMB) = 0;      // fallbackMB > 0: ignore real telemetry
+    virtual void shutdown() = 0;
+
+    virtual BudgetSample sampleBudget(double now) = 0;
+
+    // Governed textures (RGBA8, full chain for w x h); -1 on failure.
+    virtual int    createTexture(int w, int h, LevelSource src, int top) = 0;
+    virtual bool   setResidentTop(int tex, int top) = 0;     // true if storage changed
+    virtual int    residentTop(int tex) const = 0;
+    virtual int    levels(int tex) const = 0;
+    virtual size_t bytesAt(int tex, int top) const = 0;      // footprint with `top` resident
+    virtual void   destroyTexture(int tex) = 0;
+
+    // Pressure allocations: a committed dim x dim RGBA8 chain; -1 on failure.
+    virtual int    createPad(int dim) = 0;
+    virtual void   destroyPad(int pad) = 0;
+
+    // Per frame: reclaim retired storage, collect finished transfers.
+    virtual void   beginFrame() = 0;
+    // Governor verdict for this frame's residency changes (no recycling under pressure).
+    virtual void   setPressure(bool underPressure) = 0;
+    virtual double retiringMB() const = 0;
+    virtual double allocatedMB() const = 0;     // everything this backend holds
+    virtual void   drawGrid(const std::vector<GridDraw>& draws) = 0;
+    virtual void   present() = 0;
+    virtual double gpuMs() const = 0;           // last timed frame (0 if untimed)
+    virtual double avgGpuMs() const = 0;
+};
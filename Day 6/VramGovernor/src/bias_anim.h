@@ -0,0 +1,107 @@
+// Bias animation — per-object bias transitions interpolated on the GPU
+// - A GL_RGBA32F texture buffer holds (from, to, start time, 1/duration) per object; the draw
+//   shader fetches its object's entry and eases from -> to against a single uTime uniform
+// - The CPU writes an entry only when an object's target changes (one glBufferSubData over
+//   the dirty range), so a settled scene uploads nothing and the governor can jump straight
+//   to the target while the screen still moves smoothly
+// - A retarget mid-transition starts from the value on screen, so it never jumps
+// - settled() mirrors the shader so residency can drop a mip only once nothing samples it
+// - duration 0: biases apply on the next frame, as before
+// - Times are seconds since init(now) (feed uTime through time()), so the float start times
+//   keep sub-millisecond precision however long the process has been up
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "ledger.h"
+
+// Prepended to the draw VS; current() below is its C++ twin (smoothstep in time).
+inline const char* kBiasAnimGLSL = R"(
+uniform samplerBuffer uBiasAnim;
+uniform float uTime;
+float animatedBias(int id){
+    vec4 a = texelFetch(uBiasAnim, id);     // from, to, start, 1/duration
+    float t = a.w > 0.0 ? clamp((uTime - a.z) * a.w, 0.0, 1.0) : 1.0;
+    return mix(a.x, a.y, t*t*(3.0 - 2.0*t));
+})";
+
+class BiasAnimator {
+public:
+    float duration = 0.2f;      // seconds; keep under the governor's evalDt so held drops land in time
+
+    void init(double now){
+        epoch_ = now;
+        glGenBuffers(1,&buf_);
+        glGenTextures(1,&tex_);
+    }
+    void shutdown(){
+        if(tex_) glDeleteTextures(1,&tex_);
+        if(buf_) trackedDeleteBuffers(1,&buf_);
+        tex_=buf_=0; cap_=0; e_.clear();
+    }
+
+    // uTime for `now`.
+    float time(double now) const { return (float)(now - epoch_); }
+
+    // Retarget object i (grows the table as ids appear); a no-op if `bias` is already the target.
+    // An object's first target is where it starts, without a transition.
+    void setTarget(int i, float bias, double now){
+        if(i >= (int)e_.size()) e_.resize(i+1, Entry{0.f, 0.f, 0.f, kUnset});
+        Entry& e = e_[i];
+        if(e.invDur == kUnset){ e = { bias, bias, 0.f, 0.f }; markDirty(i); return; }
+        if(e.to == bias) return;
+        e = { current(i, now), bias, time(now), duration > 0.f ? 1.f/duration : 0.f };
+        markDirty(i);
+    }
+    float current(int i, double now) const {
+        const Entry& e = e_[i];
+        float t = e.invDur > 0.f ? std::clamp((time(now) - e.start) * e.invDur, 0.f, 1.f) : 1.f;
+        return e.from + (e.to - e.from) * t*t*(3.f - 2.f*t);
+    }
+    bool settled(int i, double now) const {
+        return i >= (int)e_.size() || e_[i].invDur <= 0.f || (time(now) - e_[i].start) * e_[i].invDur >= 1.f;
+    }
+
+    // Upload what changed since the last frame and bind the table to texture `unit`.
+    void bind(int unit){
+        glBindBuffer(GL_TEXTURE_BUFFER, buf_);
+        size_t bytes = e_.size()*sizeof(Entry);
+        if(bytes > cap_){
+            cap_ = std::max<size_t>(bytes*2, 64*sizeof(Entry));
+            trackedBufferData(MemTag::Geometry, GL_TEXTURE_BUFFER, buf_, cap_, nullptr, GL_DYNAMIC_DRAW);
+            dirtyLo_ = 0; dirtyHi_ = (int)e_.size();
+            glBindTexture(GL_TEXTURE_BUFFER, tex_);
+            glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buf_);
+        }
+        if(dirtyHi_ > dirtyLo_){
+            glBufferSubData(GL_TEXTURE_BUFFER, (GLintptr)(dirtyLo_*sizeof(Entry)),
+                            (GLsizeiptr)((dirtyHi_-dirtyLo_)*sizeof(Entry)), &e_[dirtyLo_]);
+            uploads_ += dirtyHi_ - dirtyLo_;
+        }
+        dirtyLo_ = INT32_MAX; dirtyHi_ = 0;
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_BUFFER, tex_);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    // Entries written to the GPU since the last call (HUD).
+    int takeUploads(){ int n = uploads_; uploads_ = 0; return n; }
+
+private:
+    struct Entry { float from, to, start, invDur; };
+    static constexpr float kUnset = -1.f;      // invDur of a slot no setTarget has reached yet (reads as settled)
+    void markDirty(int i){ dirtyLo_ = std::min(dirtyLo_, i); dirtyHi_ = std::max(dirtyHi_, i+1); }
+
+    std::vector<Entry> e_;
+    double epoch_ = 0.0;
+    GLuint buf_=0, tex_=0;
+    size_t cap_=0;
+    int    dirtyLo_=INT32_MAX, dirtyHi_=0, uploads_=0;
+};
+
+inline BiasAnimator gBiasAnim;
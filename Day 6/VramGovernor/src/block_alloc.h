@@ -0,0 +1,110 @@
+// BlockAllocator — suballocates governed resources out of large device-memory blocks
+// - One pool per memory type; each pool is a list of blocks (default 256 MB), each with a
+//   sorted free list. Allocation is first fit with alignment; frees merge with both neighbours
+// - API-agnostic: the owner creates/destroys the actual device memory through newBlock /
+//   releaseBlock, so the bookkeeping runs (and can be checked) without a GPU
+// - Requests larger than a block get a dedicated block of their own size
+// - An empty block is released unless it is the pool's last one (keeps a warm block around
+//   so a mip-tail change doesn't bounce vkAllocateMemory)
+// - Only optimal-tiling images live in these pools, so bufferImageGranularity never applies
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+struct BlockAllocation {
+    int    pool = -1, block = -1;
+    size_t offset = 0, size = 0;
+    bool   valid() const { return block >= 0; }
+};
+
+class BlockAllocator {
+public:
+    size_t blockBytes = size_t(256) << 20;
+    // Create device memory of `bytes` for (pool, block); false = out of memory.
+    std::function<bool(int pool, int block, size_t bytes)> newBlock;
+    std::function<void(int pool, int block)> releaseBlock;
+
+    BlockAllocation alloc(int pool, size_t size, size_t align){
+        if(pool >= (int)pools_.size()) pools_.resize(pool+1);
+        auto& P = pools_[pool];
+        align = std::max<size_t>(align, 1);
+        for(int b=0;b<(int)P.size();++b){
+            if(!P[b].live) continue;
+            size_t off = 0;
+            if(take(P[b], size, align, off)) return commit(pool, b, off, size);
+        }
+        // New block: reuse a dead slot so block ids stay small
+        size_t bytes = std::max(blockBytes, size);
+        int b = 0;
+        while(b < (int)P.size() && P[b].live) ++b;
+        if(!newBlock || !newBlock(pool, b, bytes)) return {};
+        if(b == (int)P.size()) P.emplace_back();
+        P[b] = Block{};
+        P[b].live = true; P[b].bytes = bytes; P[b].free.push_back({0, bytes});
+        reserved_ += bytes;
+        size_t off = 0;
+        take(P[b], size, align, off);
+        return commit(pool, b, off, size);
+    }
+
+    void free(const BlockAllocation& A){
+        if(!A.valid()) return;
+        Block& B = pools_[A.pool][A.block];
+        auto it = std::lower_bound(B.free.begin(), B.free.end(), A.offset,
+                                   [](const Range& r, size_t o){ return r.offset < o; });
+        it = B.free.insert(it, {A.offset, A.size});
+        if(it+1 != B.free.end() && it->offset + it->size == (it+1)->offset){ it->size += (it+1)->size; B.free.erase(it+1); }
+        if(it != B.free.begin() && (it-1)->offset + (it-1)->size == it->offset){ (it-1)->size += it->size; B.free.erase(it); }
+        B.used -= A.size; used_ -= A.size;
+        if(B.used == 0 && liveBlocks(A.pool) > 1){
+            if(releaseBlock) releaseBlock(A.pool, A.block);
+            reserved_ -= B.bytes;
+            B = Block{};
+        }
+    }
+
+    // Release every block (owner shuts down after freeing its resources).
+    void clear(){
+        for(int p=0;p<(int)pools_.size();++p)
+            for(int b=0;b<(int)pools_[p].size();++b)
+                if(pools_[p][b].live && releaseBlock) releaseBlock(p, b);
+        pools_.clear(); used_ = reserved_ = 0;
+    }
+
+    size_t usedBytes() const { return used_; }          // live allocations
+    size_t reservedBytes() const { return reserved_; }  // device memory held in blocks
+    int    blockCount() const { int n=0; for(int p=0;p<(int)pools_.size();++p) n += liveBlocks(p); return n; }
+
+private:
+    struct Range { size_t offset, size; };
+    struct Block { bool live=false; size_t bytes=0, used=0; std::vector<Range> free; };
+
+    static bool take(Block& B, size_t size, size_t align, size_t& off){
+        for(size_t i=0;i<B.free.size();++i){
+            Range r = B.free[i];
+            size_t o = (r.offset + align - 1) / align * align, pad = o - r.offset;
+            if(r.size < pad + size) continue;
+            B.free.erase(B.free.begin()+i);
+            // Keep the alignment gap and the remainder as free ranges (in order)
+            if(r.size > pad + size) B.free.insert(B.free.begin()+i, {o + size, r.size - pad - size});
+            if(pad) B.free.insert(B.free.begin()+i, {r.offset, pad});
+            off = o;
+            return true;
+        }
+        return false;
+    }
+    BlockAllocation commit(int pool, int b, size_t off, size_t size){
+        pools_[pool][b].used += size; used_ += size;
+        return {pool, b, off, size};
+    }
+    int liveBlocks(int pool) const {
+        int n=0; for(const auto& B : pools_[pool]) n += B.live ? 1 : 0; return n;
+    }
+
+    std::vector<std::vector<Block>> pools_;
+    size_t used_ = 0, reserved_ = 0;
+};
@@ -0,0 +1,188 @@
+// Decode pool — background image decode with work stealing
+// - Requests carry a path, the mip range wanted, and the priority of the requesting object
+// - Each worker owns per-priority deques: it pops its own newest work, idles by stealing the
+//   oldest work of the highest priority from the other workers
+// - Decoding uses the bundled stb_image; mips are box-filtered on the worker
+// - Results are handed back through a callback on the decode thread (e.g. into gUploads)
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+#include "stb_image.h"
+#include "trace.h"
+
+struct DecodedLevel {
+    int level = 0;              // full-chain level (0 = file resolution)
+    int w = 0, h = 0;
+    std::vector<uint8_t> rgba;
+};
+
+struct DecodeRequest {
+    std::string path;
+    int mipFrom = 0, mipTo = 1;     // full-chain levels [mipFrom, mipTo)
+    int priority = 1;               // 0=Low .. 2=High (GovObject::priority)
+    std::function<bool()> stillWanted;      // optional: skip stale work before decoding
+    std::function<void()> task;             // optional: run this instead of decoding (e.g. a cache bake)
+    std::function<void(bool ok, std::vector<DecodedLevel>&& levels)> done;  // decode thread
+};
+
+// 2x2 box filter, odd edges clamp to the last texel.
+inline std::vector<uint8_t> downsampleRGBA(const std::vector<uint8_t>& src, int w, int h, int& ow, int& oh){
+    ow = std::max(1, w/2); oh = std::max(1, h/2);
+    std::vector<uint8_t> dst((size_t)ow*oh*4);
+    for(int y=0;y<oh;++y){
+        int y0=std::min(h-1,2*y), y1=std::min(h-1,2*y+1);
+        for(int x=0;x<ow;++x){
+            int x0=std::min(w-1,2*x), x1=std::min(w-1,2*x+1);
+            for(int c=0;c<4;++c){
+                int s = src[((size_t)y0*w+x0)*4+c] + src[((size_t)y0*w+x1)*4+c]
+                      + src[((size_t)y1*w+x0)*4+c] + src[((size_t)y1*w+x1)*4+c];
+                dst[((size_t)y*ow+x)*4+c] = (uint8_t)((s+2)/4);
+            }
+        }
+    }
+    return dst;
+}
+
+// Synchronous decode of levels [mipFrom, mipTo); used by the pool workers.
+inline bool decodeLevels(const std::string& path, int mipFrom, int mipTo, std::vector<DecodedLevel>& out){
+    int w=0,h=0,ch=0;
+    unsigned char* px = stbi_load(path.c_str(), &w,&h,&ch, STBI_rgb_alpha);
+    if(!px){ std::fprintf(stderr,"[Decode] failed: %s (%s)\n", path.c_str(), stbi_failure_reason()); return false; }
+    std::vector<uint8_t> cur(px, px + (size_t)w*h*4);
+    stbi_image_free(px);
+    for(int l=0; l<mipTo; ++l){
+        bool last = (l+1>=mipTo) || (w==1 && h==1);
+        if(l>=mipFrom){
+            if(last) out.push_back({l, w, h, std::move(cur)});
+            else     out.push_back({l, w, h, cur});
+        }
+        if(last) break;
+        int nw, nh; cur = downsampleRGBA(cur, w, h, nw, nh); w=nw; h=nh;
+    }
+    return true;
+}
+
+class DecodePool {
+public:
+    static constexpr int kPriorities = 3;
+
+    void init(int threads = 0){
+        if(threads<=0) threads = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+        stop_ = false;
+        queues_.clear();
+        for(int i=0;i<threads;++i) queues_.push_back(std::make_unique<WorkerQueue>());
+        for(int i=0;i<threads;++i) workers_.emplace_back([this,i]{
+            char name[16]; std::snprintf(name, sizeof(name), "decode %d", i);
+            gTrace.setThreadName(name);
+            workerLoop(i);
+        });
+        std::printf("[Decode] %d worker(s)\n", threads);
+    }
+
+    void shutdown(){
+        { std::lock_guard<std::mutex> lk(idleM_); stop_ = true; }
+        idleCv_.notify_all();
+        for(auto& t : workers_) if(t.joinable()) t.join();
+        workers_.clear(); queues_.clear();
+    }
+
+    bool running() const { return !workers_.empty(); }
+    int  pending() const { return pending_.load(); }
+    int  steals()  const { return steals_.load(); }
+
+    void submit(DecodeRequest rq){
+        int p = rq.priority = std::clamp(rq.priority, 0, kPriorities-1);
+        size_t n = queues_.size();
+        WorkerQueue& q = *queues_[next_.fetch_add(1) % n];
+        { std::lock_guard<std::mutex> lk(q.m); q.byPrio[p].push_back(std::move(rq)); }
+        ++pending_;
+        { std::lock_guard<std::mutex> lk(idleM_); }
+        idleCv_.notify_one();
+    }
+
+private:
+    struct WorkerQueue {
+        std::mutex m;
+        std::deque<DecodeRequest> byPrio[kPriorities];
+    };
+
+    // Own queue: newest first (cache-warm). Victims: oldest first, so owner and thief rarely collide.
+    bool popOwn(int i, DecodeRequest& out){
+        WorkerQueue& q = *queues_[i];
+        std::lock_guard<std::mutex> lk(q.m);
+        for(int p=kPriorities-1; p>=0; --p){
+            if(q.byPrio[p].empty()) continue;
+            out = std::move(q.byPrio[p].back()); q.byPrio[p].pop_back();
+            return true;
+        }
+        return false;
+    }
+    bool steal(int thief, DecodeRequest& out){ return stealAbove(thief, -1, out); }
+
+    void workerLoop(int i){
+        while(!stop_){
+            DecodeRequest rq;
+            bool got = popOwn(i, rq);
+            // Don't sit on Low work while another worker holds High work.
+            if(got && rq.priority < kPriorities-1 && queues_.size()>1){
+                DecodeRequest better;
+                if(stealAbove(i, rq.priority, better)){ requeue(i, std::move(rq)); rq = std::move(better); }
+            }
+            if(!got) got = steal(i, rq);
+            if(!got){
+                std::unique_lock<std::mutex> lk(idleM_);
+                idleCv_.wait(lk, [&]{ return stop_ || pending_.load()>0; });
+                if(stop_) return;
+                continue;
+            }
+            --pending_;
+            if(rq.stillWanted && !rq.stillWanted()) continue;
+            VG_ZONE("decode.task");
+            if(rq.task){ rq.task(); continue; }
+            std::vector<DecodedLevel> levels;
+            bool ok = decodeLevels(rq.path, rq.mipFrom, rq.mipTo, levels);
+            if(rq.done) rq.done(ok, std::move(levels));
+        }
+    }
+    // Highest priority anywhere wins over locality.
+    bool stealAbove(int thief, int prio, DecodeRequest& out){
+        for(int p=kPriorities-1; p>prio; --p){
+            for(size_t k=1; k<queues_.size(); ++k){
+                WorkerQueue& q = *queues_[(thief + k) % queues_.size()];
+                std::lock_guard<std::mutex> lk(q.m);
+                if(q.byPrio[p].empty()) continue;
+                out = std::move(q.byPrio[p].front()); q.byPrio[p].pop_front();
+                ++steals_;
+                return true;
+            }
+        }
+        return false;
+    }
+    void requeue(int i, DecodeRequest&& rq){
+        WorkerQueue& q = *queues_[i];
+        std::lock_guard<std::mutex> lk(q.m);
+        q.byPrio[rq.priority].push_back(std::move(rq));
+    }
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<unsigned> next_{0};
+    std::atomic<int> pending_{0}, steals_{0};
+    std::mutex idleM_;
+    std::condition_variable idleCv_;
+    std::atomic<bool> stop_{true};
+};
+
+inline DecodePool gDecode;
@@ -0,0 +1,188 @@
+// Density — per-object screen coverage and required mip level
+// - A reduced-resolution RG16F target receives, per pixel, the mip level the full-resolution
+//   texture would be sampled at (before bias) and the id of the object that covers it
+// - The target is read back through a PBO ring + fences and reduced on the CPU per object,
+//   a few frames late and without ever blocking
+// - The governor uses coverage to spend quality where it is least visible and the required
+//   mip to avoid keeping (or streaming back) levels the sampler never touches
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "ledger.h"
+
+// Fragment stage of the metric pass (pairs with the demo's quad VS).
+inline const char* kDensityFS = R"(#version 330 core
+in vec2 vUV;
+layout(location=0) out vec2 outMetric;
+uniform vec2  uBaseSize;    // level-0 size of the object's full chain
+uniform float uPixelScale;  // full-res pixels per metric pixel
+uniform float uId;
+void main(){
+    vec2 dx = dFdx(vUV) * uBaseSize, dy = dFdy(vUV) * uBaseSize;
+    float rho = max(length(dx), length(dy)) / uPixelScale;   // texels per full-res pixel
+    outMetric = vec2(clamp(log2(max(rho, 1e-8)), -8.0, 16.0), uId + 1.0);
+})";
+
+struct ObjDensity {
+    int   pixels = 0;           // metric pixels covered
+    float coverage = 0.f;       // fraction of the framebuffer
+    float requiredMip = 0.f;    // average pre-bias mip level over the covered pixels
+    float finestMip = 0.f;      // finest level any covered pixel asks for
+};
+
+class DensityProbe {
+public:
+    static constexpr int kRing = 3;
+    int downscale   = 4;        // metric target is framebuffer / downscale
+    int sampleEvery = 4;        // frames between metric passes
+
+    bool hasSample() const { return sampleFrame_ != 0; }
+    uint64_t sampleFrame() const { return sampleFrame_; }
+    // Indexed by object id; `pixels==0` means off screen at the last sample.
+    const std::vector<ObjDensity>& results() const { return results_; }
+
+    void init(GLuint prog){
+        prog_ = prog;
+        locBase_  = glGetUniformLocation(prog_, "uBaseSize");
+        locScale_ = glGetUniformLocation(prog_, "uPixelScale");
+        locId_    = glGetUniformLocation(prog_, "uId");
+        glGenBuffers(kRing, pbo_);
+    }
+
+    void shutdown(){
+        for(auto& f : fence_) if(f){ glDeleteSync(f); f=nullptr; }
+        trackedDeleteBuffers(kRing, pbo_);
+        destroyTarget();
+        inFlight_ = 0;
+    }
+
+    // Starts a metric pass if one is due this frame (and a slot is free); false otherwise.
+    bool begin(uint64_t frame, int fbW, int fbH){
+        poll();
+        if(frame % (uint64_t)std::max(1, sampleEvery) != 0 || inFlight_ == kRing) return false;
+        fbW_ = fbW; fbH_ = fbH;
+        int w = std::max(1, fbW/downscale), h = std::max(1, fbH/downscale);
+        if(w!=w_ || h!=h_) createTarget(w, h);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        glViewport(0,0,w_,h_);
+        const float zero[4] = {0,0,0,0};
+        glClearBufferfv(GL_COLOR, 0, zero);
+        glUseProgram(prog_);
+        glUniform1f(locScale_, (float)downscale);
+        frame_ = frame;
+        return true;
+    }
+
+    // Viewport in framebuffer pixels, as used for the visible draw.
+    void drawObject(int id, int baseW, int baseH, int x, int y, int w, int h, GLuint vao){
+        glViewport(x/downscale, y/downscale, std::max(1, w/downscale), std::max(1, h/downscale));
+        glUniform2f(locBase_, (float)baseW, (float)baseH);
+        glUniform1f(locId_, (float)id);
+        glBindVertexArray(vao);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glBindVertexArray(0);
+    }
+
+    // Queue the async readback of this frame's target.
+    void end(){
+        int i = head_;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[i]);
+        size_t bytes = (size_t)w_*h_*2*sizeof(float);
+        if(slotBytes_[i] != bytes){
+            trackedBufferData(MemTag::Readback, GL_PIXEL_PACK_BUFFER, pbo_[i], bytes, nullptr, GL_STREAM_READ);
+            slotBytes_[i] = bytes;
+        }
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0,0,w_,h_, GL_RG, GL_FLOAT, (void*)0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        fence_[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot_[i] = { frame_, w_, h_, fbW_, fbH_ };
+        head_ = (head_+1) % kRing; ++inFlight_;
+    }
+
+private:
+    struct Slot { uint64_t frame; int w, h, fbW, fbH; };
+
+    // Reduce every finished slot (oldest first); the newest one wins.
+    void poll(){
+        while(inFlight_ > 0){
+            int i = (head_ - inFlight_ + kRing) % kRing;
+            GLenum st = glClientWaitSync(fence_[i], 0, 0);
+            if(st!=GL_ALREADY_SIGNALED && st!=GL_CONDITION_SATISFIED) break;
+            glDeleteSync(fence_[i]); fence_[i]=nullptr; --inFlight_;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[i]);
+            const Slot& S = slot_[i];
+            auto* px = (const float*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)((size_t)S.w*S.h*2*sizeof(float)), GL_MAP_READ_BIT);
+            if(px){ reduce(px, S); glUnmapBuffer(GL_PIXEL_PACK_BUFFER); }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+    }
+
+    void reduce(const float* px, const Slot& S){
+        std::vector<double> sum;
+        results_.clear();
+        for(size_t p=0, n=(size_t)S.w*S.h; p<n; ++p){
+            float lambda = px[2*p], tag = px[2*p+1];
+            if(tag < 0.5f) continue;
+            size_t id = (size_t)std::lround(tag) - 1;
+            if(id >= results_.size()){ results_.resize(id+1); sum.resize(id+1, 0.0); }
+            ObjDensity& d = results_[id];
+            d.finestMip = d.pixels ? std::min(d.finestMip, lambda) : lambda;
+            ++d.pixels; sum[id] += lambda;
+        }
+        double scale2 = (double)S.fbW*S.fbH / ((double)S.w*S.h);
+        for(size_t id=0; id<results_.size(); ++id){
+            ObjDensity& d = results_[id];
+            if(!d.pixels) continue;
+            d.requiredMip = (float)(sum[id] / d.pixels);
+            d.coverage = (float)(d.pixels*scale2 / ((double)S.fbW*S.fbH));
+        }
+        sampleFrame_ = S.frame;
+    }
+
+    void createTarget(int w, int h){
+        destroyTarget();
+        w_=w; h_=h;
+        glGenTextures(1,&tex_);
+        glBindTexture(GL_TEXTURE_2D, tex_);
+        trackedTexImage2D(MemTag::Target, tex_, 0, GL_RG16F, w, h, GL_RG, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glGenFramebuffers(1,&fbo_);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex_, 0);
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER)!=GL_FRAMEBUFFER_COMPLETE)
+            std::fprintf(stderr,"[Density] metric FBO incomplete\n");
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    void destroyTarget(){
+        if(fbo_) glDeleteFramebuffers(1,&fbo_);
+        if(tex_) trackedDeleteTextures(1,&tex_);
+        fbo_=0; tex_=0; w_=h_=0;
+    }
+
+    GLuint prog_=0, fbo_=0, tex_=0;
+    GLint  locBase_=-1, locScale_=-1, locId_=-1;
+    int    w_=0, h_=0, fbW_=0, fbH_=0;
+    uint64_t frame_=0, sampleFrame_=0;
+
+    GLuint pbo_[kRing] = {};
+    GLsync fence_[kRing] = {};
+    size_t slotBytes_[kRing] = {};
+    Slot   slot_[kRing] = {};
+    int    head_=0, inFlight_=0;
+
+    std::vector<ObjDensity> results_;
+};
+
+inline DensityProbe gDensity;
@@ -0,0 +1,196 @@
+// GlBackend — the GL 3.3 path behind GpuBackend
+// - Hidden GLFW window + offscreen 1280x720 target; Telemetry (NVX / ATI / DXGI / fallback)
+//   for the budget, residency.h for governed textures, the ledger for allocatedMB
+// - Pads are 8K chains cleared through an FBO and finished before admission counts them
+// - Retirement goes through gRetire; its onFreed is forwarded so the governor hears about
+//   freed space the same way on both backends
+#pragma once
+
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "backend.h"
+#include "residency.h"
+#include "telemetry.h"
+#include "ledger.h"
+#include "gputimer.h"
+#include "vram_governor.h"      // vgCompileShader / vgLinkProgram
+
+class GlBackend : public GpuBackend {
+public:
+    int fbW = 1280, fbH = 720;
+
+    const char* name() const override { return "gl"; }
+    std::string device() const override { return renderer_; }
+
+    bool init(int fallbackMB) override {
+        if(!glfwInit()){ std::fprintf(stderr,"GLFW init failed\n"); return false; }
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+        win_ = glfwCreateWindow(64,64,"vram_bench",nullptr,nullptr);
+        if(!win_){ std::fprintf(stderr,"Window create failed\n"); glfwTerminate(); return false; }
+        glfwMakeContextCurrent(win_);
+        glfwSwapInterval(0);
+        glewExperimental = GL_TRUE;
+        if(glewInit()!=GLEW_OK){ std::fprintf(stderr,"GLEW init failed\n"); return false; }
+        renderer_ = (const char*)glGetString(GL_RENDERER);
+        std::printf("[GL] %s | %s\n", renderer_.c_str(), (const char*)glGetString(GL_VERSION));
+
+        gAsyncUploads = false;          // synchronous stream-in keeps runs deterministic
+        tel_.init();
+        gRetire.onFreed = [this](size_t bytes){ if(onFreed) onFreed(bytes); };
+        if(fallbackMB > 0){ tel_.useTelemetry = false; tel_.fallbackBaseFreeMB = fallbackMB; }
+        else {
+            GLint kb=0; glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &kb);
+            tel_.fallbackBaseFreeMB = (glGetError()==GL_NO_ERROR && kb>0) ? (kb/1024)*9/10 : 6000;
+        }
+
+        // Offscreen target + quad
+        glGenTextures(1,&colorTex_); glBindTexture(GL_TEXTURE_2D,colorTex_);
+        trackedTexImage2D(MemTag::Target, colorTex_, 0, GL_RGBA8, fbW, fbH, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glGenFramebuffers(1,&fbo_); glBindFramebuffer(GL_FRAMEBUFFER,fbo_);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTex_, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+        const float quad[] = { -1,-1, 1,-1, 1,1,  -1,-1, 1,1, -1,1 };
+        glGenVertexArrays(1,&vao_); glBindVertexArray(vao_);
+        glGenBuffers(1,&vbo_); glBindBuffer(GL_ARRAY_BUFFER,vbo_);
+        trackedBufferData(MemTag::Geometry, GL_ARRAY_BUFFER, vbo_, sizeof(quad), quad, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0); glVertexAttribPointer(0,2,GL_FLOAT,GL_FALSE,0,(void*)0);
+        glBindVertexArray(0);
+        prog_ = compileProgram();
+        if(!prog_) return false;
+        locRect_ = glGetUniformLocation(prog_,"uRect"); locBias_ = glGetUniformLocation(prog_,"uBias");
+        glUseProgram(prog_); glUniform1i(glGetUniformLocation(prog_,"uTex"),0);
+        gpu_.init();
+        return true;
+    }
+
+    void shutdown() override {
+        if(!win_) return;
+        for(int p=0;p<(int)pads_.size();++p) destroyPad(p);
+        for(auto& T : tex_) destroyGovTexture(T);
+        gRetire.drain();
+        gTexPool.trimTo(0);
+        gpu_.shutdown(); tel_.shutdown();
+        glDeleteFramebuffers(1,&fbo_); trackedDeleteTextures(1,&colorTex_);
+        glDeleteVertexArrays(1,&vao_); trackedDeleteBuffers(1,&vbo_); glDeleteProgram(prog_);
+        glfwDestroyWindow(win_); win_ = nullptr;
+        glfwTerminate();
+    }
+
+    BudgetSample sampleBudget(double now) override {
+        const TelemetrySample& s = tel_.sample(now);
+        return { s.valid, s.freeMB, s.totalMB, tel_.useTelemetry ? telModeName(tel_.mode) : "FALLBACK", s.time };
+    }
+
+    int createTexture(int w, int h, LevelSource src, int top) override {
+        GovTexture T; T.baseW=w; T.baseH=h; T.source=std::move(src);
+        createGovTexture(T, top);
+        if(!T.tex) return -1;
+        tex_.push_back(std::move(T));
+        return (int)tex_.size()-1;
+    }
+    bool   setResidentTop(int t, int top) override {
+        bool changed = ::setResidentTop(tex_[t], top);
+        if(changed && pressure_) gTexPool.trimTo(0);
+        return changed;
+    }
+    int    residentTop(int t) const override { return tex_[t].residentTop; }
+    int    levels(int t) const override { return tex_[t].levels; }
+    size_t bytesAt(int t, int top) const override { return residentBytes(tex_[t], std::clamp(top, 0, tex_[t].levels-1)); }
+    void   destroyTexture(int t) override { destroyGovTexture(tex_[t]); }
+
+    int createPad(int dim) override {
+        int levels = mipLevelsFor(dim, dim);
+        Pad P{ trackedTexStorage2D(MemTag::Pad, levels, GL_RGBA8, dim, dim), 0, dim };
+        if(!P.tex) return -1;
+        glGenFramebuffers(1,&P.fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, P.fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, P.tex, 0);
+        glViewport(0,0,dim,dim);
+        glClearColor(0.1f,0.1f,0.1f,1.f); glClear(GL_COLOR_BUFFER_BIT);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glFinish();
+        pads_.push_back(P);
+        return (int)pads_.size()-1;
+    }
+    void destroyPad(int p) override {
+        Pad& P = pads_[p];
+        if(!P.tex) return;
+        if(P.fbo) glDeleteFramebuffers(1,&P.fbo);
+        gRetire.retire(P.tex, chainBytes(GL_RGBA8, P.dim, P.dim, mipLevelsFor(P.dim, P.dim)));
+        P = Pad{};
+    }
+
+    void beginFrame() override { gRetire.pump(); }
+    void setPressure(bool underPressure) override {
+        pressure_ = underPressure;
+        if(underPressure) gTexPool.trimTo(0);
+        gRetire.recycle = !underPressure;
+    }
+    double retiringMB() const override { return gRetire.queuedBytes()/(1024.0*1024.0); }
+    double allocatedMB() const override { return gLedger.total()/(1024.0*1024.0); }
+
+    void drawGrid(const std::vector<GridDraw>& draws) override {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        glViewport(0,0,fbW,fbH);
+        gpu_.begin();
+        glClearColor(0.1f,0.11f,0.13f,1.f); glClear(GL_COLOR_BUFFER_BIT);
+        glUseProgram(prog_); glBindVertexArray(vao_); glActiveTexture(GL_TEXTURE0);
+        for(const auto& d : draws){
+            if(!tex_[d.tex].tex) continue;
+            glUniform4f(locRect_, d.x0, d.y0, d.x1, d.y1);
+            glUniform1f(locBias_, d.bias);
+            glBindTexture(GL_TEXTURE_2D, tex_[d.tex].tex);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        }
+        gpu_.end();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    void   present() override { glfwSwapBuffers(win_); glfwPollEvents(); }
+    double gpuMs() const override { return gpu_.lastMs(); }
+    double avgGpuMs() const override { return gpu_.avgMs(); }
+
+private:
+    struct Pad { GLuint tex=0, fbo=0; int dim=0; };
+
+    static constexpr const char* kVS = R"(#version 330 core
+layout(location=0) in vec2 aPos;
+uniform vec4 uRect;
+out vec2 vUV;
+void main(){ vUV=aPos*0.5+0.5; gl_Position=vec4(mix(uRect.xy, uRect.zw, vUV),0.0,1.0); })";
+    static constexpr const char* kFS = R"(#version 330 core
+in vec2 vUV; out vec4 fragColor;
+uniform sampler2D uTex; uniform float uBias;
+void main(){ fragColor = vec4(texture(uTex, vUV*4.0, uBias).rgb, 1.0); })";
+
+    static GLuint compileProgram(){
+        GLuint vs=vgCompileShader(GL_VERTEX_SHADER,kVS), fs=vgCompileShader(GL_FRAGMENT_SHADER,kFS);
+        GLuint p = vs && fs ? vgLinkProgram(vs,fs) : 0;
+        if(vs) glDeleteShader(vs);
+        if(fs) glDeleteShader(fs);
+        return p;
+    }
+
+    GLFWwindow* win_ = nullptr;
+    std::string renderer_;
+    Telemetry   tel_;
+    GpuTimer    gpu_;
+    std::vector<GovTexture> tex_;
+    std::vector<Pad>        pads_;
+    GLuint colorTex_=0, fbo_=0, vao_=0, vbo_=0, prog_=0;
+    GLint  locRect_=-1, locBias_=-1;
+    bool   pressure_ = false;
+};
@@ -0,0 +1,715 @@
+// Governor — priority-bucket bias governor over a structure-of-arrays object store
+// - Per-object state (priority, bias, footprint, visibility, screen density) lives in contiguous
+//   arrays indexed by object id; the app owns everything else (textures, placement)
+// - Each priority keeps two ordered sets: objects that can still escalate and objects that can
+//   still restore. An object is re-keyed (O(log N)) only when an input to its order changes
+// - A tick visits only the objects it steps, bounded by stepBudgetPerTick
+// - Which objects step is a pluggable GovernorPolicy: the priority buckets (default) or a
+//   cost/benefit knapsack that picks the cheapest steps closing the gap to targetFreeMB
+// - The controller either reacts to measured free memory (band), acts on a forecast of it
+//   (trend + allocations the app announced), or runs a PID on the forecast error
+// - Frees in flight (storage retired but not yet deleted, deletions telemetry hasn't seen) count
+//   as free memory, so a mass release doesn't read as pressure while it drains
+// - Optional GPU frame-time budget as a second constraint: over budget escalates even with
+//   headroom to spare (oversubscription shows up as GPU time first), near it blocks restores
+// - Optional region of interest: objects away from it are held at a bias floor (levels or pages
+//   released regardless of pressure); objects it touches weigh roiWeight times more
+// - Optional budget domains (global -> view -> object group): the global budget is split by
+//   weight (and caps) down the tree, and only domains over their share escalate, so a heavy
+//   view degrades itself instead of its neighbours
+// - No GL: the app feeds footprint/density in and reads bias/wanted residency out
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <set>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "trace.h"
+
+enum class Priority : int { Low=0, Normal=1, High=2 };
+
+// BiasOnly: bias is a sampler LOD offset, the full chain stays allocated.
+// MipTail : each whole bias level above 0 also evicts one top mip from VRAM.
+// Sparse  : the whole part drops levels as in MipTail; the fractional part decommits that share
+//           of the finest resident level's pages (ARB_sparse_texture), so every step frees memory
+enum class ResidencyMode { BiasOnly, MipTail, Sparse };
+
+// Band      : step while measured freeMB is outside targetFreeMB +- hysteresisMB
+// Predictive: same band, on the forecast: freeMB projected leadTime ahead along its trend,
+//             minus allocations announced but not yet visible in telemetry
+// PID       : PID on the forecast's distance to targetFreeMB; the output is the step size
+enum class ControlMode { Band, Predictive, PID };
+inline const char* controlName(ControlMode m){
+    return m==ControlMode::Band ? "band" : m==ControlMode::Predictive ? "predictive" : "pid";
+}
+
+// Least-squares slope (MB/s) of freeMB samples over a sliding time window.
+class FreeTrend {
+public:
+    double window = 1.0;   // seconds
+
+    void add(double t, double mb){
+        s_.push_back({t, mb});
+        while(s_.size() > 2 && s_.front().first < t - window) s_.pop_front();
+    }
+    void clear(){ s_.clear(); }
+    double slope() const {
+        size_t n = s_.size();
+        if(n < 3) return 0.0;
+        double t0 = s_.front().first, st=0, sm=0, stt=0, stm=0;
+        for(const auto& [t, mb] : s_){ double x = t - t0; st+=x; sm+=mb; stt+=x*x; stm+=x*mb; }
+        double d = n*stt - st*st;
+        return d > 1e-9 ? (n*stm - st*sm) / d : 0.0;
+    }
+private:
+    std::deque<std::pair<double,double>> s_;
+};
+
+class Governor;
+
+// Decides which objects take a bias step this tick. `needMB` is how far free memory is below
+// targetFreeMB; `spareMB` how far it is above (what a restore may spend).
+class GovernorPolicy {
+public:
+    virtual ~GovernorPolicy() = default;
+    virtual const char* name() const = 0;
+    virtual void escalate(Governor& g, double needMB) = 0;
+    virtual void deescalate(Governor& g, double spareMB) = 0;
+};
+
+class Governor {
+public:
+    static constexpr int kPriorities = 3;
+
+    Governor();
+    Governor(const Governor&) = delete;
+    Governor& operator=(const Governor&) = delete;
+
+    // Global goals
+    int   targetFreeMB = 1024;
+    int   hysteresisMB = 128;
+    int   spikeThreshMB= 256;
+
+    // dynamics
+    float stepGradual   = 0.5f;
+    float stepSpike     = 1.25f;
+    int   stepBudgetPerTick = 4; // number of object-steps per tick
+
+    // residency
+    ResidencyMode residency = ResidencyMode::MipTail;
+    float restoreSlack = 0.25f;  // bias must fall this far below a level before its mip streams back
+    float sparseStep   = 0.25f;  // Sparse: bias per knapsack candidate (a quarter of a level's pages)
+
+    // ordering: density updates that move an object's key by less than this (relative) are ignored
+    double rekeyTolerance = 0.02;
+
+    // policy (BucketPolicy unless replaced) and the quality weights cost-aware policies use
+    std::unique_ptr<GovernorPolicy> policy;
+    float priorityWeight[kPriorities] = { 1.f, 4.f, 16.f };
+    float unknownCoverage = 0.05f;  // assumed screen share before the first density sample
+
+    // control
+    double leadTime   = 0.5;    // seconds the trend is projected ahead (Predictive/PID)
+    double pendingTtl = 1.0;    // announced allocations count until seen or this old
+    FreeTrend trend;
+    struct PidGains {
+        float kp = 0.002f;      // bias levels per MB short of targetFreeMB
+        float ki = 0.001f;      // per MB*s
+        float kd = 0.f;         // the trend is already in the forecast
+        float rate = 1.25f;     // max step per tick
+        float deadband = 0.05f; // smaller outputs don't step
+    } pid;
+
+    // Region of interest: per-object overlap comes from the app (setRoi).
+    float roiFloor   = 2.f;     // bias floor for objects entirely outside the ROI
+    float roiWeight  = 8.f;     // quality weight multiplier for objects inside it
+
+    // GPU time of the governed passes (ms, fed by the app); 0 disables the constraint
+    double gpuBudgetMs = 0.0;
+    double gpuSlack    = 0.15;  // restores wait until GPU time is this fraction under budget
+    void   setGpuTime(double ms){ gpuMs_ = ms; }
+    double gpuTime() const { return gpuMs_; }
+
+    // time
+    bool   underPressure=false; // freeMB (or its forecast) below the hysteresis band at the last tick
+    int    lastFreeMB=-1;
+    double lastEval=0.0;
+    double evalDt=0.25;
+    double lastPrint=0.0;
+    bool   verbose=true;
+    bool   enabled=true;        // false: evaluate() keeps sampling but never steps (manual mode)
+
+    // debug/global
+    float globalNudge=0.f;
+
+    // ---------- object store ----------
+    int add(Priority p, float biasMin=0.f, float biasMax=8.f, bool visible=true){
+        int i = (int)prio_.size();
+        prio_.push_back(p); bias_.push_back(std::clamp(0.f, biasMin, biasMax));
+        biasMin_.push_back(biasMin); biasMax_.push_back(biasMax);
+        visible_.push_back(visible ? 1 : 0);
+        estMB_.push_back(0.f); residentTop_.push_back(0); levels_.push_back(1); committed_.push_back(1.f); roi_.push_back(1.f);
+        domain_.push_back(0); shrink_.push_back(4.f); coverage_.push_back(-1.f); requiredMip_.push_back(0.f); finestMip_.push_back(0.f);
+        key_.push_back(0.0);
+        link(i);
+        return i;
+    }
+    void reserve(size_t n){
+        prio_.reserve(n); bias_.reserve(n); biasMin_.reserve(n); biasMax_.reserve(n); visible_.reserve(n);
+        estMB_.reserve(n); residentTop_.reserve(n); levels_.reserve(n); committed_.reserve(n); roi_.reserve(n);
+        domain_.reserve(n); shrink_.reserve(n); coverage_.reserve(n); requiredMip_.reserve(n); finestMip_.reserve(n); key_.reserve(n);
+    }
+
+    size_t   size()             const { return prio_.size(); }
+    Priority priority(int i)    const { return prio_[i]; }
+    float    bias(int i)        const { return bias_[i]; }
+    bool     visible(int i)     const { return visible_[i]!=0; }
+    float    estMB(int i)       const { return estMB_[i]; }
+    float    coverage(int i)    const { return coverage_[i]; }
+    float    requiredMip(int i) const { return requiredMip_[i]; }
+    size_t   visibleCount(Priority p) const { return sets_[0].up[(int)p].size() + atMax_[(int)p]; }
+    double   residentMB()       const { return residentMB_; }
+
+    void setVisible(int i, bool v){
+        if(visible(i)==v) return;
+        unlink(i); visible_[i] = v ? 1 : 0; link(i);
+    }
+    void setPriority(int i, Priority p){
+        if(prio_[i]==p) return;
+        unlink(i); prio_[i] = p; link(i);
+    }
+    // Footprint as resident right now (after residency was applied). `committed`: share of the
+    // residentTop level that is backed by pages (sparse textures; 1 otherwise).
+    void setFootprint(int i, float mb, int residentTop, int levels, float committed=1.f){
+        residentMB_ += (double)mb - estMB_[i];
+        addDomainMB(domain_[i], (double)mb - estMB_[i]);
+        committed_[i] = committed;
+        if(estMB_[i]==mb && residentTop_[i]==residentTop && levels_[i]==levels) return;
+        unlink(i); estMB_[i]=mb; residentTop_[i]=residentTop; levels_[i]=levels; link(i);
+    }
+    // Footprint ratio between consecutive levels: 4 for 2D chains, 8 for 3D bricks.
+    void setLevelShrink(int i, float s){ shrink_[i] = s; }
+    // coverage < 0: unknown; 0: off screen.
+    void setDensity(int i, float coverage, float requiredMip, float finestMip){
+        coverage_[i]=coverage; requiredMip_[i]=requiredMip; finestMip_[i]=finestMip;
+        double k = orderKey(i), old = key_[i];      // unlink() files by the stored key
+        if(std::fabs(k-old) <= rekeyTolerance*std::max(std::fabs(k), std::fabs(old))) return;
+        unlink(i); link(i);
+    }
+    // inside: 1 where the sharp region touches object i, 0 beyond its feather. A raised floor
+    // lifts the bias at once; a lowered one is unwound by normal restores.
+    void setRoi(int i, float inside){
+        inside = std::clamp(inside, 0.f, 1.f);
+        if(roi_[i]==inside) return;
+        unlink(i); roi_[i] = inside;
+        bias_[i] = std::clamp(bias_[i], biasMin(i), biasMax_[i]);
+        link(i);
+    }
+    float roi(int i) const { return roi_[i]; }
+    bool  roiEnabled() const { return roiOn_; }
+    void  setRoiEnabled(bool on){
+        if(on==roiOn_) return;
+        for(int i=0;i<(int)size();++i) unlink(i);
+        roiOn_ = on;
+        for(int i=0;i<(int)size();++i){ bias_[i] = std::clamp(bias_[i], biasMin(i), biasMax_[i]); link(i); }
+    }
+
+    // ---------- budget domains ----------
+    // Domain 0 is the whole governor: its budget is the resident MB that leaves targetFreeMB
+    // free, its hysteresis hysteresisMB. A domain's children split its budget by weight; a
+    // child's share is capped at capMB and what it leaves goes to its uncapped siblings.
+    struct BudgetDomain {
+        const char* name = "";
+        int      parent = -1, depth = 0;
+        float    weight = 1.f;              // share of the parent's budget, relative to siblings
+        double   capMB = 0.0;               // ceiling on that share (0: none)
+        int      hysteresisMB = 64;
+        Priority priority = Priority::Normal;   // over budget: Low domains step first; restore: High first
+        // Updated every policy tick
+        double   residentMB = 0.0, budgetMB = 0.0;
+        int      state = 0;                 // +1 above budget+hysteresis, -1 below budget-hysteresis
+    };
+    int addDomain(const char* name, int parent=0, float weight=1.f, double capMB=0.0,
+                  Priority p=Priority::Normal, int hysteresisMB=64){
+        BudgetDomain d;
+        d.name=name; d.parent=parent; d.depth=domains_[parent].depth+1;
+        d.weight=weight; d.capMB=capMB; d.priority=p; d.hysteresisMB=hysteresisMB;
+        domains_.push_back(d); children_.emplace_back(); sets_.emplace_back();
+        children_[parent].push_back((int)domains_.size()-1);
+        return (int)domains_.size()-1;
+    }
+    void setDomain(int i, int d){
+        if(domain_[i]==d) return;
+        unlink(i);
+        addDomainMB(domain_[i], -estMB_[i]); domain_[i] = d; addDomainMB(d, estMB_[i]);
+        link(i);
+    }
+    int    domainOf(int i) const { return domain_[i]; }
+    size_t domainCount() const { return domains_.size(); }
+    const BudgetDomain& domain(int d) const { return domains_[d]; }
+    bool   domainsEnabled() const { return domainsOn_ && domains_.size() > 1; }
+    void   setDomainsEnabled(bool on){ domainsOn_ = on; }
+    bool   inDomain(int i, int d) const { return isAncestor(d, domain_[i]); }
+    void printDomains() const {
+        for(size_t d=0; d<domains_.size(); ++d){
+            const BudgetDomain& D = domains_[d];
+            std::printf("[Domain] %*s%-10s resident %7.1f / budget %7.1f MB (w %.1f%s) %s\n", 2*D.depth, "", D.name,
+                D.residentMB, D.budgetMB, D.weight, D.capMB > 0.0 ? ", capped" : "",
+                D.state > 0 ? "OVER" : D.state < 0 ? "under" : "");
+        }
+    }
+
+    // Warm start (profile.h): place object i at bias b directly.
+    void setBias(int i, float b){ unlink(i); bias_[i] = std::clamp(b, biasMin(i), biasMax_[i]); link(i); }
+
+    void resetBiases(){
+        VG_ZONE("governor.rebuild");
+        for(int i=0;i<(int)size();++i){ unlink(i); bias_[i]=std::clamp(0.f, biasMin(i), biasMax_[i]); link(i); }
+    }
+
+    // Finest level the sampler touches for this object at its current bias (trilinear reads
+    // floor(lambda) and up); levels above it are resident for nothing.
+    int sampledTop(int i) const {
+        if(coverage_[i] < 0.f) return 0;
+        if(coverage_[i] <= 0.f) return levels_[i]-1;
+        return std::clamp((int)std::floor(finestMip_[i] + std::max(0.f, bias_[i])), 0, levels_[i]-1);
+    }
+    bool freeToDrop(int i) const { return sampledTop(i) > residentTop_[i]; }
+
+    // Finest mip level that should be resident for object i at its bias. Levels finer than
+    // what the screen actually samples are never streamed back.
+    int wantedTop(int i) const {
+        if(residency==ResidencyMode::BiasOnly) return 0;
+        float b = bias_[i]; int currentTop = residentTop_[i];
+        int want = (int)std::floor(std::max(0.f, b));
+        if(residency==ResidencyMode::MipTail && want < currentTop && b > (float)currentTop - restoreSlack) want = currentTop;
+        if(want < currentTop) want = std::min(currentTop, std::max(want, sampledTop(i)));
+        return want;
+    }
+
+    // Sparse: share of wantedTop's pages to keep committed (the rest of the fractional bias).
+    float wantedCommit(int i) const {
+        if(residency!=ResidencyMode::Sparse) return 1.f;
+        float b = std::max(0.f, bias_[i]);
+        if(wantedTop(i) > (int)std::floor(b)) return 1.f;      // held coarser by the sampled level
+        return std::clamp(1.f - (b - std::floor(b)), 1.f/16.f, 1.f);
+    }
+
+    // Resident MB object i would settle at if its bias were `b` (MipTail; BiasOnly frees nothing).
+    double predictMB(int i, float b) const {
+        if(residency==ResidencyMode::BiasOnly) return estMB_[i];
+        if(residency==ResidencyMode::Sparse){
+            // The top level is ~3/4 of the chain from it down; only `committed` of it is paged in.
+            int cur = residentTop_[i];
+            double full = estMB_[i] / (0.25 + 0.75*committed_[i]);        // chain from cur, fully committed
+            float bb = std::max(0.f, b);
+            int top = std::clamp((int)std::floor(bb), 0, levels_[i]-1);
+            if(top < cur) top = std::min(cur, std::max(top, sampledTop(i)));
+            double c = top > (int)std::floor(bb) ? 1.0 : std::clamp(1.0 - (bb - std::floor(bb)), 1.0/16.0, 1.0);
+            return full * std::pow((double)shrink_[i], (double)(cur - top)) * (0.25 + 0.75*c);
+        }
+        int cur = residentTop_[i], top = cur;
+        int want = (int)std::floor(std::max(0.f, b));
+        if(want > cur) top = want;
+        else if(want < cur && b <= (float)cur - restoreSlack) top = std::max(want, sampledTop(i));
+        top = std::clamp(top, 0, levels_[i]-1);
+        return estMB_[i] * std::pow((double)shrink_[i], (double)(cur - top));     // each level is ~1/4 of the rest (1/8 in 3D)
+    }
+    // Visible quality lost per bias level on object i.
+    double qualityWeight(int i) const {
+        float cov = coverage_[i] < 0.f ? unknownCoverage : coverage_[i];
+        return priorityWeight[(int)prio_[i]] * cov * roiScale(i);
+    }
+    // Effective floor: the object's own minimum, raised outside the ROI.
+    float biasMin(int i) const {
+        return roiOn_ ? std::min(biasMax_[i], std::max(biasMin_[i], (1.f - roi_[i]) * roiFloor)) : biasMin_[i];
+    }
+    int   residentTop(int i) const { return residentTop_[i]; }
+    float biasMax(int i) const { return biasMax_[i]; }
+
+    // Appends up to `maxCount` escalation candidates of a bucket (best MB per quality first), or
+    // restore candidates (most visible quality per MB first); `out` may already hold others.
+    void candidates(Priority pr, bool up, int maxCount, std::vector<int>& out) const {
+        int p = (int)pr;
+        size_t start = out.size();
+        auto room = [&]{ return (int)(out.size() - start) < maxCount; };
+        // Inside a domain pass only that domain's objects are candidates: walk its own sets.
+        const DomainSets& S = sets_[scope_ < 0 ? 0 : scope_];
+        if(up){ for(auto it=S.up[p].begin();    it!=S.up[p].end()    && room(); ++it) out.push_back(it->second); }
+        else  { for(auto it=S.down[p].rbegin(); it!=S.down[p].rend() && room(); ++it) out.push_back(it->second); }
+    }
+    // Move object i's bias by `delta` (clamped); returns true if it changed.
+    bool step(int i, float delta){
+        unlink(i);
+        float old = bias_[i];
+        bias_[i] = std::clamp(bias_[i] + delta, biasMin(i), biasMax_[i]);
+        link(i);
+        return bias_[i] != old;
+    }
+    // Bucket walk: steps the first `budget` candidates of one priority.
+    void applySteps(Priority pr, float delta, int& budget){
+        pick_.clear();
+        candidates(pr, delta > 0, budget, pick_);
+        for(int i : pick_) if(step(i, delta)) --budget;
+    }
+
+    void nudge(float d){ globalNudge = std::clamp(globalNudge+d, -4.f, 4.f); }
+
+    ControlMode control() const { return control_; }
+    void setControl(ControlMode m){ control_ = m; pidInteg_ = 0.0; pidPrimed_ = false; }
+    double pidIntegral() const { return pidInteg_; }
+    void   setPidIntegral(double v){ pidInteg_ = v; }
+
+    // The app is about to commit `mb` (a pad, a texture stream-in). It counts against the
+    // forecast until free memory has dropped by most of it, or pendingTtl has passed.
+    void announce(double mb, double now){
+        if(mb > 0.0 && sampleFree_ >= 0) pending_.push_back({mb, (double)sampleFree_, now + pendingTtl});
+    }
+    double pendingMB() const {
+        double s = 0.0;
+        for(const auto& a : pending_) s += a.mb;
+        return s;
+    }
+    // Releases: storage the app has queued for deletion (waiting on the GPU) and storage deleted
+    // but not yet visible in telemetry. Both count as free, so frees in flight don't make the
+    // governor escalate; a deletion counts until free memory has risen by most of it, or pendingTtl.
+    void setRetiringMB(double mb){ retiringMB_ = mb; }
+    void announceFree(double mb, double now){
+        if(mb > 0.0 && sampleFree_ >= 0) freeing_.push_back({mb, (double)sampleFree_, now + pendingTtl});
+    }
+    double releasingMB() const {
+        double s = retiringMB_;
+        for(const auto& a : freeing_) s += a.mb;
+        return s;
+    }
+    int    sampleFreeMB() const { return sampleFree_; }   // latest freeMB passed to evaluate (-1: none yet)
+    double forecastFreeMB() const { return sampleFree_ + trend.slope()*leadTime - pendingMB(); }
+    // Bias step the policies apply this tick: stepGradual, or the PID output in PID mode.
+    float stepSize() const { return stepNow_; }
+
+    // Call every frame; the trend and announcements are sampled on every call, the policy
+    // runs every evalDt.
+    void evaluate(double now, int freeMB, bool telValid){
+        VG_ZONE("governor.evaluate");
+        trend.add(now, freeMB);
+        sampleFree_ = freeMB;
+        settlePending(now, freeMB);
+        if(lastFreeMB<0 || !enabled){ lastFreeMB=freeMB; lastEval=now; return; }
+        if(now-lastEval < evalDt) return;
+        double dt = now - lastEval;
+        lastEval = now;
+
+        int delta = freeMB - lastFreeMB; // negative = drop
+        lastFreeMB = freeMB;
+
+        if (delta <= -spikeThreshMB) spikeTourniquet();
+
+        int lo = targetFreeMB - hysteresisMB;
+        int hi = targetFreeMB + hysteresisMB;
+
+        // A rising forecast never delays a measured shortfall.
+        double ctrl = (control_==ControlMode::Band ? (double)freeMB : std::min((double)freeMB, forecastFreeMB())) + releasingMB();
+        gpuOver_ = gpuBudgetMs > 0.0 && gpuMs_ > gpuBudgetMs;
+        gpuNear_ = gpuBudgetMs > 0.0 && gpuMs_ > gpuBudgetMs*(1.0 - gpuSlack);
+        stepNow_ = stepGradual;
+        underPressure = ctrl < lo || gpuOver_;
+        if(domainsEnabled()) updateDomains(ctrl);
+        {
+            VG_ZONE("governor.steps");
+            if      (control_==ControlMode::PID) pidTick(ctrl, dt);
+            else if (domainsEnabled()){
+                if(gpuOver_) policy->escalate(*this, 0.0);          // frame time is not per domain
+                domainSteps(true);
+                if(!gpuNear_) domainSteps(false);
+            }
+            else if (ctrl < lo) policy->escalate(*this, targetFreeMB - ctrl);
+            else if (gpuOver_)  policy->escalate(*this, 0.0);
+            else if (ctrl > hi && !gpuNear_) policy->deescalate(*this, ctrl - targetFreeMB);
+        }
+
+        if(verbose && now-lastPrint>0.5){
+            lastPrint=now;
+            std::printf("freeMB=%4d (Δ %+4d) [%s] objs=%zu  L/N/H=%zu/%zu/%zu  resident=%.1fMB  nudge=%.2f  policy=%s  ctl=%s fc=%.0f pend=%.0f rel=%.0f  gpu=%.2f/%.1fms%s\n",
+                freeMB, delta, telValid?"telemetry":"fallback", size(),
+                visibleCount(Priority::Low), visibleCount(Priority::Normal), visibleCount(Priority::High),
+                residentMB_, globalNudge, policy->name(), controlName(control_), ctrl, pendingMB(), releasingMB(),
+                gpuMs_, gpuBudgetMs, gpuOver_ ? " OVER" : "");
+        }
+    }
+
+private:
+    // Within each bucket, most MB per unit of visible quality first: off-screen objects and
+    // objects whose finest resident level goes unsampled, then MB per screen coverage.
+    // Falls back to largest memory first until density samples arrive.
+    double orderKey(int i) const {
+        if(coverage_[i] < 0.f) return estMB_[i] / roiScale(i);
+        if(coverage_[i] <= 0.f || freeToDrop(i)) return 1e9 + estMB_[i];
+        return estMB_[i] / ((coverage_[i] + 1e-3) * roiScale(i));
+    }
+    double roiScale(int i) const { return roiOn_ ? 1.0 + (roiWeight - 1.0) * roi_[i] : 1.0; }
+
+    // Sets hold (-key, id): ascending order = largest key first, ties by id. An object is filed
+    // in its domain's sets and in every ancestor's, so sets_[0] holds everything and a domain
+    // pass reads its candidates without filtering.
+    using Entry = std::pair<double,int>;
+    struct DomainSets { std::set<Entry> up[kPriorities], down[kPriorities]; };
+    void unlink(int i){
+        if(!visible_[i]) return;
+        int p = (int)prio_[i];
+        Entry e{-key_[i], i};
+        if(!sets_[0].up[p].count(e)) --atMax_[p];
+        for(int d=domain_[i]; d>=0; d=domains_[d].parent){ sets_[d].up[p].erase(e); sets_[d].down[p].erase(e); }
+    }
+    void link(int i){
+        if(!visible_[i]) return;
+        int p = (int)prio_[i];
+        key_[i] = orderKey(i);
+        Entry e{-key_[i], i};
+        bool up = bias_[i] < biasMax_[i], down = bias_[i] > biasMin(i);
+        if(!up) ++atMax_[p];
+        for(int d=domain_[i]; d>=0; d=domains_[d].parent){
+            if(up)   sets_[d].up[p].insert(e);
+            if(down) sets_[d].down[p].insert(e);
+        }
+    }
+
+    void settlePending(double now, int freeMB){
+        pending_.erase(std::remove_if(pending_.begin(), pending_.end(), [&](const Pending& a){
+            return now >= a.expires || freeMB <= a.baseFree - 0.75*a.mb;
+        }), pending_.end());
+        freeing_.erase(std::remove_if(freeing_.begin(), freeing_.end(), [&](const Pending& a){
+            return now >= a.expires || freeMB >= a.baseFree + 0.75*a.mb;
+        }), freeing_.end());
+    }
+
+    bool canStep(bool up) const {
+        for(int p=0; p<kPriorities; ++p) if(!(up ? sets_[0].up[p] : sets_[0].down[p]).empty()) return true;
+        return false;
+    }
+
+    // Error = MB short of targetFreeMB; output = per-object bias step (+ escalates), clamped
+    // to pid.rate. The integrator holds while the output saturates or every object it would
+    // move is already clamped at biasMin/biasMax (it may always unwind).
+    void pidTick(double ctrlMB, double dt){
+        double e = targetFreeMB - ctrlMB;
+        double d = pidPrimed_ ? (e - pidErr_) / std::max(dt, 1e-3) : 0.0;
+        pidErr_ = e; pidPrimed_ = true;
+        double u   = pid.kp*e + pid.ki*pidInteg_ + pid.kd*d;
+        double out = std::clamp(u, -(double)pid.rate, (double)pid.rate);
+        bool pinned = out != u || (u > 0 && !canStep(true)) || (u < 0 && !canStep(false));
+        if(!pinned || e*pidInteg_ < 0) pidInteg_ += e*dt;
+        if(gpuOver_ && out < pid.deadband) out = stepGradual;      // frame-time constraint
+        if(std::fabs(out) < pid.deadband || (out < 0 && gpuNear_)) return;
+        stepNow_ = (float)std::fabs(out);
+        if(domainsEnabled()) domainSteps(out > 0);     // the PID sizes the step, the domains place it
+        else if(out > 0) policy->escalate(*this, std::max(0.0, e));
+        else        policy->deescalate(*this, std::max(0.0, -e));
+    }
+
+    void addDomainMB(int d, double mb){
+        for(; d>=0; d=domains_[d].parent) domains_[d].residentMB += mb;
+    }
+    bool isAncestor(int a, int d) const {
+        for(; d>=0; d=domains_[d].parent) if(d==a) return true;
+        return false;
+    }
+
+    // Budgets top-down from the control value (domains are stored parents first), then states.
+    void updateDomains(double ctrlMB){
+        domains_[0].hysteresisMB = hysteresisMB;
+        domains_[0].budgetMB = std::max(0.0, domains_[0].residentMB + ctrlMB - targetFreeMB);
+        for(size_t d=0; d<domains_.size(); ++d){
+            const auto& kids = children_[d];
+            if(kids.empty()) continue;
+            double left = domains_[d].budgetMB;
+            fixed_.assign(kids.size(), 0);
+            // Water-fill: a child whose weighted share exceeds its cap is pinned there, repeat.
+            for(bool again=true; again; ){
+                again = false;
+                double w = 0.0;
+                for(size_t k=0; k<kids.size(); ++k) if(!fixed_[k]) w += domains_[kids[k]].weight;
+                for(size_t k=0; k<kids.size() && !again; ++k){
+                    if(fixed_[k]) continue;
+                    BudgetDomain& c = domains_[kids[k]];
+                    c.budgetMB = w > 0.0 ? left * c.weight / w : 0.0;
+                    if(c.capMB > 0.0 && c.budgetMB > c.capMB){ c.budgetMB = c.capMB; left -= c.capMB; fixed_[k] = 1; again = true; }
+                }
+            }
+        }
+        for(auto& D : domains_)
+            D.state = D.residentMB > D.budgetMB + D.hysteresisMB ? 1 : D.residentMB < D.budgetMB - D.hysteresisMB ? -1 : 0;
+    }
+
+    // One policy pass per domain in the wanted state, scoped to its objects: deepest first, then
+    // by domain priority. A domain whose descendant already stepped this tick is skipped (that
+    // covers its overage or spends its spare), and a restore never runs in a domain with an
+    // over-budget domain above or below it.
+    void domainSteps(bool up){
+        order_.clear(); stepped_.clear();
+        for(int d=0; d<(int)domains_.size(); ++d) if(domains_[d].state == (up ? 1 : -1)) order_.push_back(d);
+        std::sort(order_.begin(), order_.end(), [&](int a, int b){
+            const BudgetDomain &A = domains_[a], &B = domains_[b];
+            if(A.depth != B.depth) return A.depth > B.depth;
+            if(A.priority != B.priority) return up ? A.priority < B.priority : A.priority > B.priority;
+            return a < b;
+        });
+        for(int d : order_){
+            bool skip = false;
+            for(int e : stepped_) skip |= isAncestor(d, e);
+            if(!up) for(int e=0; e<(int)domains_.size() && !skip; ++e)
+                skip = domains_[e].state > 0 && (isAncestor(d, e) || isAncestor(e, d));
+            if(skip) continue;
+            const BudgetDomain& D = domains_[d];
+            scope_ = d;
+            if(up) policy->escalate(*this, D.residentMB - D.budgetMB);
+            else   policy->deescalate(*this, D.budgetMB - D.residentMB);
+            stepped_.push_back(d);
+        }
+        scope_ = -1;
+    }
+
+    void spikeTourniquet(){
+        // Hit the Low bucket first, stronger step; budget-limited
+        int budget = stepBudgetPerTick;
+        applySteps(Priority::Low, +stepSpike, budget);
+    }
+
+    std::vector<Priority> prio_;
+    std::vector<float>    bias_, biasMin_, biasMax_;
+    std::vector<uint8_t>  visible_;
+    std::vector<float>    estMB_;
+    std::vector<int>      residentTop_, levels_;
+    std::vector<float>    committed_;
+    std::vector<float>    roi_;
+    bool   roiOn_ = false;
+    std::vector<int>      domain_;
+    std::vector<float>    shrink_;
+    std::vector<BudgetDomain> domains_;
+    std::vector<std::vector<int>> children_;
+    bool   domainsOn_ = true;
+    int    scope_ = -1;                    // domain the current policy pass is limited to
+    std::vector<int>  order_, stepped_;
+    std::vector<char> fixed_;
+    std::vector<float>    coverage_, requiredMip_, finestMip_;
+    std::vector<double>   key_;            // key each object is filed under
+    double residentMB_ = 0.0;
+
+    std::vector<DomainSets> sets_;         // per domain (parallel to domains_)
+    size_t atMax_[kPriorities] = {};       // visible objects at biasMax (not in the up sets)
+    std::vector<int> pick_;
+
+    struct Pending { double mb, baseFree, expires; };
+    ControlMode control_ = ControlMode::Band;
+    std::vector<Pending> pending_, freeing_;
+    double retiringMB_ = 0.0;
+    int    sampleFree_ = -1;
+    float  stepNow_ = 0.5f;
+    double pidInteg_ = 0.0, pidErr_ = 0.0;
+    bool   pidPrimed_ = false;
+    double gpuMs_ = 0.0;
+    bool   gpuOver_ = false, gpuNear_ = false;
+};
+
+// =================== Policies ===================
+// The original walk: Low -> Normal -> High on escalation, High -> Normal -> Low on restore,
+// stepSize() per object until stepBudgetPerTick is spent. Ignores how much each step frees.
+class BucketPolicy : public GovernorPolicy {
+public:
+    const char* name() const override { return "buckets"; }
+    void escalate(Governor& g, double) override {
+        int budget = g.stepBudgetPerTick;
+        g.applySteps(Priority::Low,    +g.stepSize(), budget);
+        g.applySteps(Priority::Normal, +g.stepSize(), budget);
+        g.applySteps(Priority::High,   +g.stepSize(), budget);
+    }
+    void deescalate(Governor& g, double) override {
+        int budget = g.stepBudgetPerTick;
+        g.applySteps(Priority::High,   -g.stepSize(), budget);
+        g.applySteps(Priority::Normal, -g.stepSize(), budget);
+        g.applySteps(Priority::Low,    -g.stepSize(), budget);
+    }
+};
+
+// Greedy knapsack over candidate steps. Each candidate moves one object's bias to the next
+// whole level (the smallest step that changes residency; sparseStep when pages can be
+// decommitted) and reports MB freed and quality cost
+// (levels * priority weight * coverage). Escalation takes the best MB-per-cost steps until the
+// gap to targetFreeMB is covered; restore takes the best quality-per-MB steps that fit in the
+// spare headroom. Candidates come from the front of each bucket's ordered set, so a tick stays
+// O(candidatesPerBucket) rather than O(N).
+class KnapsackPolicy : public GovernorPolicy {
+public:
+    int candidatesPerBucket = 64;
+    int maxStepsPerTick     = 32;
+
+    const char* name() const override { return "knapsack"; }
+
+    void escalate(Governor& g, double needMB) override {
+        gather(g, true);
+        for(auto& c : cand_){
+            float b = g.bias(c.id);
+            float target = std::min(g.biasMax(c.id), g.residency==ResidencyMode::Sparse ? b + g.sparseStep : std::floor(b) + 1.f);
+            c.delta = target - b;
+            c.mb    = g.estMB(c.id) - g.predictMB(c.id, target);
+            c.cost  = std::max(1e-6, (double)c.delta * g.qualityWeight(c.id));
+        }
+        if(!pickBest(needMB)){ BucketPolicy().escalate(g, needMB); return; }   // nothing frees memory
+        for(const auto& c : chosen_) g.step(c.id, c.delta);
+    }
+
+    void deescalate(Governor& g, double spareMB) override {
+        gather(g, false);
+        for(auto& c : cand_){
+            float b = g.bias(c.id);
+            float level  = std::min(std::floor(b), (float)g.residentTop(c.id));   // restore one level below
+            float target = std::max(g.biasMin(c.id), g.residency==ResidencyMode::Sparse ? b - g.sparseStep : level - g.restoreSlack);
+            c.delta = target - b;
+            c.mb    = g.predictMB(c.id, target) - g.estMB(c.id);            // MB it will cost
+            c.cost  = std::max(1e-6, c.mb);
+            c.gain  = (double)-c.delta * g.qualityWeight(c.id);
+        }
+        // Best quality per MB first, as long as it fits.
+        std::sort(cand_.begin(), cand_.end(), [](const Cand& a, const Cand& b){ return a.gain/a.cost > b.gain/b.cost; });
+        double spent = 0.0; int steps = 0;
+        for(const auto& c : cand_){
+            if(steps >= maxStepsPerTick) break;
+            if(c.delta >= 0.f || spent + std::max(0.0, c.mb) > spareMB) continue;
+            g.step(c.id, c.delta); spent += std::max(0.0, c.mb); ++steps;
+        }
+    }
+
+private:
+    struct Cand { int id; float delta=0.f; double mb=0.0, cost=1.0, gain=0.0; };
+
+    void gather(const Governor& g, bool up){
+        ids_.clear(); cand_.clear();
+        for(int p=0; p<Governor::kPriorities; ++p) g.candidates((Priority)p, up, candidatesPerBucket, ids_);
+        for(int id : ids_) cand_.push_back({id});
+    }
+    // Cheapest MB-per-cost cover of `needMB`; false if no candidate frees anything.
+    bool pickBest(double needMB){
+        chosen_.clear();
+        std::sort(cand_.begin(), cand_.end(), [](const Cand& a, const Cand& b){ return a.mb/a.cost > b.mb/b.cost; });
+        double freed = 0.0;
+        for(const auto& c : cand_){
+            if(freed >= needMB || (int)chosen_.size() >= maxStepsPerTick) break;
+            if(c.mb <= 0.0 || c.delta <= 0.f) continue;
+            chosen_.push_back(c); freed += c.mb;
+        }
+        return !chosen_.empty();
+    }
+
+    std::vector<int>  ids_;
+    std::vector<Cand> cand_, chosen_;
+};
+
+inline Governor::Governor() : policy(std::make_unique<BucketPolicy>()) {
+    domains_.push_back({}); domains_[0].name = "global";
+    children_.emplace_back(); sets_.emplace_back();
+}
@@ -0,0 +1,218 @@
+// Governor tick cost at 1k / 10k / 100k objects (no GL, no window)
+// - "eval"   : Governor::evaluate alone (incremental ordered sets)
+// - "tick"   : eval + the app-side feedback a frame would do: footprint for every object
+//              (cheap when unchanged) and a density sample for 1% of them
+// - "rebuild": the previous scheme, clearing the buckets and sorting them every tick
+// Then, per policy and controller, how many ticks a 200-object scene needs to climb back to the headroom band
+// and what that cost in weighted visible quality (sum of bias * priority weight * coverage).
+// Then, isolation: two views share the budget and one of them loads 100 more (High priority)
+// objects; mean bias in each view afterwards, with one global target and with a domain per view.
+// Last, a check that the knapsack sees every bucket: a full Low bucket plus one large, barely
+// visible High object that is the best MB per quality; it must be the one stepped (exit 1 if not).
+// Usage: governor_bench [ticks]
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "governor.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct Scene {
+    std::vector<Priority> prio;
+    std::vector<float> mb, coverage, finestMip;
+    std::vector<int>   levels;
+};
+
+static Scene makeScene(size_t n, unsigned seed){
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pr(0,2), lv(8,13);
+    std::uniform_real_distribution<float> cov(0.f, 0.01f), mip(0.f, 4.f);
+    Scene s;
+    for(size_t i=0;i<n;++i){
+        int levels = lv(rng);
+        s.prio.push_back((Priority)pr(rng));
+        s.levels.push_back(levels);
+        s.mb.push_back((float)((1u<<levels)*(1u<<levels)*4*4/3) / (1024.f*1024.f));
+        s.coverage.push_back(cov(rng));
+        s.finestMip.push_back(mip(rng));
+    }
+    return s;
+}
+
+// Pressure pattern: 40 ticks below the band, 40 above.
+static int freeMBAt(int tick){ return (tick/40)%2==0 ? 512 : 1600; }
+
+static double benchIncremental(const Scene& s, int ticks, bool withFeedback){
+    Governor g; g.verbose=false; g.evalDt=0.0; g.reserve(s.prio.size());
+    for(size_t i=0;i<s.prio.size();++i){
+        int id = g.add(s.prio[i]);
+        g.setFootprint(id, s.mb[i], 0, s.levels[i]);
+        g.setDensity(id, s.coverage[i], s.finestMip[i], s.finestMip[i]);
+    }
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> pick(0, s.prio.size()-1);
+    std::uniform_real_distribution<float> jitter(0.5f, 1.5f);
+    size_t densityPerTick = std::max<size_t>(1, s.prio.size()/100);
+
+    g.evaluate(0.0, freeMBAt(0), true);
+    auto t0 = Clock::now();
+    for(int t=1;t<=ticks;++t){
+        g.evaluate((double)t, freeMBAt(t), true);
+        if(!withFeedback) continue;
+        for(int i=0;i<(int)g.size();++i){
+            int top = g.wantedTop(i);
+            float mb = s.mb[i] / (float)(1u << (2*std::min(top, 8)));
+            g.setFootprint(i, mb, top, s.levels[i]);
+        }
+        for(size_t k=0;k<densityPerTick;++k){
+            size_t i = pick(rng);
+            g.setDensity((int)i, s.coverage[i]*jitter(rng), s.finestMip[i], s.finestMip[i]);
+        }
+    }
+    return std::chrono::duration<double, std::micro>(Clock::now()-t0).count() / ticks;
+}
+
+// The old per-tick path: rebuild three bucket vectors and sort each by key.
+static double benchRebuild(const Scene& s, int ticks){
+    struct Obj { Priority prio; float bias, mb, coverage; };
+    std::vector<Obj> objs;
+    for(size_t i=0;i<s.prio.size();++i) objs.push_back({s.prio[i], 0.f, s.mb[i], s.coverage[i]});
+    std::vector<int> buckets[3];
+    auto key = [&](const Obj& o){ return o.mb / (o.coverage + 1e-3f); };
+    auto t0 = Clock::now();
+    for(int t=1;t<=ticks;++t){
+        for(auto& b : buckets) b.clear();
+        for(int i=0;i<(int)objs.size();++i) buckets[(int)objs[i].prio].push_back(i);
+        for(auto& b : buckets)
+            std::sort(b.begin(), b.end(), [&](int a,int c){ return key(objs[a]) > key(objs[c]); });
+        float d = freeMBAt(t) < 896 ? 0.5f : -0.5f;
+        int budget = 4;
+        for(auto& b : buckets) for(int i : b){
+            if(budget<=0) break;
+            float old = objs[i].bias;
+            objs[i].bias = std::clamp(objs[i].bias + d, 0.f, 8.f);
+            if(objs[i].bias != old) --budget;
+        }
+    }
+    return std::chrono::duration<double, std::micro>(Clock::now()-t0).count() / ticks;
+}
+
+struct Convergence { int ticks; double quality; int steps; };
+
+// budget: stepBudgetPerTick for the bucket walk (the knapsack uses its own maxStepsPerTick).
+static Convergence converge(bool knapsack, int budget, ControlMode control){
+    Scene s = makeScene(200, 99u);
+    Governor g; g.verbose=false; g.evalDt=0.0; g.stepBudgetPerTick=budget;
+    if(knapsack) g.policy = std::make_unique<KnapsackPolicy>();
+    g.setControl(control);
+    for(size_t i=0;i<s.prio.size();++i){
+        int id = g.add(s.prio[i]);
+        g.setFootprint(id, s.mb[i], 0, s.levels[i]);
+        g.setDensity(id, s.coverage[i], s.finestMip[i], s.finestMip[i]);
+    }
+    g.targetFreeMB = (int)(0.5*g.residentMB());
+    double capacity = g.targetFreeMB + 0.7*g.residentMB();     // 30% of the footprint must go
+    int lo = g.targetFreeMB - g.hysteresisMB;
+    Convergence c{-1, 0.0, 0};
+    std::vector<float> before(g.size(), 0.f);
+    for(int t=0; t<100 && c.ticks<0; ++t){
+        int freeMB = (int)(capacity - g.residentMB());
+        if(t>0 && freeMB >= lo){ c.ticks = t; break; }
+        g.evaluate((double)t, freeMB, true);
+        for(int i=0;i<(int)g.size();++i){
+            if(g.bias(i)!=before[i]){ ++c.steps; before[i]=g.bias(i); }
+            int top = g.wantedTop(i);
+            g.setFootprint(i, s.mb[i] / (float)(1u << (2*std::min(top, 8))), top, s.levels[i]);
+        }
+    }
+    for(int i=0;i<(int)g.size();++i) c.quality += g.bias(i) * g.qualityWeight(i);
+    return c;
+}
+
+struct Isolation { double biasA, biasB; };
+
+static Isolation isolation(bool domains){
+    Scene s = makeScene(200, 5u), heavy = makeScene(100, 6u);
+    Governor g; g.verbose=false; g.evalDt=0.0;
+    g.setDomainsEnabled(domains);
+    int view[2] = { g.addDomain("view A"), g.addDomain("view B") };
+    std::vector<int> inView;
+    auto addTo = [&](int v, Priority p, const Scene& sc, size_t k){
+        int id = g.add(p);
+        g.setDomain(id, view[v]); inView.push_back(v);
+        g.setFootprint(id, sc.mb[k], 0, sc.levels[k]);
+        g.setDensity(id, sc.coverage[k], sc.finestMip[k], sc.finestMip[k]);
+    };
+    for(size_t i=0;i<s.prio.size();++i) addTo((int)(i%2), s.prio[i], s, i);
+    g.targetFreeMB = (int)(0.5*g.residentMB());
+    double capacity = g.targetFreeMB + 1.1*g.residentMB();     // fits the first scene with 10% spare
+    std::vector<float> mb = s.mb; std::vector<int> levels = s.levels;
+    for(int t=0; t<200; ++t){
+        if(t==20) for(size_t k=0;k<heavy.prio.size();++k){       // view B loads a heavy study
+            addTo(1, Priority::High, heavy, k);
+            mb.push_back(heavy.mb[k]); levels.push_back(heavy.levels[k]);
+        }
+        g.evaluate((double)t, (int)(capacity - g.residentMB()), true);
+        for(int i=0;i<(int)g.size();++i){
+            int top = g.wantedTop(i);
+            g.setFootprint(i, mb[i] / (float)(1u << (2*std::min(top, 8))), top, levels[i]);
+        }
+    }
+    double sum[2] = {0,0}; int n[2] = {0,0};
+    for(int i=0;i<(int)g.size();++i){ sum[inView[i]] += g.bias(i); ++n[inView[i]]; }
+    return { sum[0]/n[0], sum[1]/n[1] };
+}
+
+// Bias the High object ends up with after one knapsack tick.
+static float knapsackHighPick(){
+    Governor g; g.verbose=false; g.evalDt=0.0;
+    auto k = std::make_unique<KnapsackPolicy>(); k->maxStepsPerTick = 1;
+    int perBucket = k->candidatesPerBucket;
+    g.policy = std::move(k);
+    for(int i=0;i<2*perBucket;++i){
+        int id = g.add(Priority::Low);
+        g.setFootprint(id, 4.f, 0, 10);
+        g.setDensity(id, 1.f, 0.f, 0.f);
+    }
+    int high = g.add(Priority::High);
+    g.setFootprint(high, 2000.f, 0, 12);
+    g.setDensity(high, 0.01f, 0.f, 0.f);
+    g.targetFreeMB = 1024;
+    g.evaluate(0.0, 0, true);       // first sample only primes the tick
+    g.evaluate(1.0, 0, true);
+    return g.bias(high);
+}
+
+int main(int argc, char** argv){
+    int ticks = argc>1 ? std::max(1, std::atoi(argv[1])) : 400;
+    std::printf("%8s  %12s  %12s  %12s\n", "objects", "eval us", "tick us", "rebuild us");
+    for(size_t n : {1000u, 10000u, 100000u}){
+        Scene s = makeScene(n, 1234u);
+        double e = benchIncremental(s, ticks, false);
+        double t = benchIncremental(s, ticks, true);
+        double r = benchRebuild(s, ticks);
+        std::printf("%8zu  %12.2f  %12.2f  %12.2f\n", n, e, t, r);
+    }
+    std::printf("\n%12s  %14s  %12s  %8s\n", "policy", "ticks to band", "quality cost", "steps");
+    struct Row { const char* name; bool knapsack; int budget; ControlMode control; };
+    for(Row r : { Row{"buckets", false, 4, ControlMode::Band}, Row{"buckets x32", false, 32, ControlMode::Band},
+                  Row{"buckets pid", false, 4, ControlMode::PID}, Row{"knapsack", true, 4, ControlMode::Band},
+                  Row{"knapsack pid", true, 4, ControlMode::PID} }){
+        Convergence c = converge(r.knapsack, r.budget, r.control);
+        std::printf("%12s  %14d  %12.4f  %8d\n", r.name, c.ticks, c.quality, c.steps);
+    }
+    std::printf("(-1: not within 100 ticks)\n");
+    std::printf("\n%12s  %12s  %12s\n", "isolation", "view A bias", "view B bias");
+    for(bool d : {false, true}){
+        Isolation r = isolation(d);
+        std::printf("%12s  %12.3f  %12.3f\n", d ? "domains" : "global", r.biasA, r.biasB);
+    }
+    float high = knapsackHighPick();
+    std::printf("\nknapsack pick: High best-ratio object %s (bias %.2f)\n", high > 0.f ? "stepped" : "MISSED", high);
+    return high > 0.f ? 0 : 1;
+}
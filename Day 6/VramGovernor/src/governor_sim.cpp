@@ -0,0 +1,160 @@
+// Governor against VramSim (no GL, no window, no wall clock)
+// - One scenario: 300 textures, a 1 GB allocation spike, a slow external ramp, visibility
+//   churn and a release, replayed on a fixed tick so every run with the same seed is identical
+// - Scored on what matters when tuning: time spent oversubscribed (true free < 0), time below
+//   the band, time to recover after each pressure event, bias reversals (oscillation) and the
+//   average weighted quality lost
+// - --sweep runs the grid stepGradual x stepSpike x hysteresisMB x stepBudgetPerTick and prints
+//   the best settings first
+// Usage: governor_sim [--sweep] [--seconds=30] [--seed=1] [--policy=buckets|knapsack]
+//                     [--control=band|predictive|pid] [--residency=miptail|sparse] [--csv=path]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "governor.h"
+#include "vram_sim.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct Params {
+    float stepGradual = 0.5f, stepSpike = 1.25f;
+    int   hysteresisMB = 128, stepBudget = 4;
+    bool  knapsack = false;
+    ControlMode control = ControlMode::Band;
+    ResidencyMode residency = ResidencyMode::MipTail;
+};
+
+struct Result {
+    double oomSec=0, belowSec=0, recoverSec=0, quality=0;
+    int    reversals=0, steps=0, events=0, unrecovered=0;
+    long   ticks=0;
+    double score() const { return oomSec*100.0 + belowSec*10.0 + recoverSec + unrecovered*30.0 + quality*0.1 + reversals*0.002; }
+};
+
+static const double kDt = 1.0/60.0;
+
+static Result run(const Params& P, double seconds, unsigned seed, std::FILE* csv){
+    Governor g; g.verbose=false;
+    g.stepGradual = P.stepGradual; g.stepSpike = P.stepSpike;
+    g.hysteresisMB = P.hysteresisMB; g.stepBudgetPerTick = P.stepBudget;
+    if(P.knapsack) g.policy = std::make_unique<KnapsackPolicy>();
+    g.setControl(P.control);
+    g.residency = P.residency;
+
+    VramSim sim(seed);
+    std::mt19937 rng(seed*7919u + 1u);
+    std::uniform_int_distribution<int> pr(0,2), lv(9,12);
+    std::uniform_real_distribution<float> cov(0.0005f, 0.02f), u(0.f, 1.f);
+    for(int i=0;i<300;++i) sim.add(g, (Priority)pr(rng), 1 << lv(rng), cov(rng));
+    sim.budgetMB = sim.residentMB() * 0.9 + g.targetFreeMB;     // everything at full res doesn't fit
+
+    Result r;
+    std::vector<float> prevBias(g.size(), 0.f);
+    std::vector<int>   prevDir(g.size(), 0);
+    std::vector<double> eventAt;
+    int lo = g.targetFreeMB - 128;      // fixed, so runs with different hysteresis score alike
+    if(csv) std::fprintf(csv, "t,trueFreeMB,reportedMB,externalMB,residentMB,steps\n");
+
+    for(long k=0; k*kDt < seconds; ++k){
+        double t = k*kDt;
+        // Scenario
+        if(k == (long)(2.0/kDt))  { sim.externalMB += 1024; eventAt.push_back(t); g.announce(1024, t); }
+        if(t >= 6.0 && t < 12.0)    sim.externalMB += 40.0*kDt;                    // 240 MB ramp
+        if(k == (long)(6.0/kDt))    eventAt.push_back(t);
+        if(k % (long)(3.0/kDt) == 0 && k > 0)
+            for(int i=0;i<(int)g.size();++i) sim.setVisible(g, i, u(rng) > 0.25f);
+        if(k == (long)(16.0/kDt)) { sim.externalMB = std::max(0.0, sim.externalMB - 1024); eventAt.push_back(t); }
+        if(k == (long)(20.0/kDt)) { sim.externalMB += 1536; eventAt.push_back(t); }  // unannounced
+
+        g.evaluate(t, sim.reportedMB(), true);
+        sim.tick(g, t);
+
+        int steps = 0; double q = 0;
+        for(int i=0;i<(int)g.size();++i){
+            float b = g.bias(i);
+            if(b != prevBias[i]){
+                int dir = b > prevBias[i] ? 1 : -1;
+                if(prevDir[i] && dir != prevDir[i]) ++r.reversals;
+                prevDir[i] = dir; prevBias[i] = b; ++steps;
+            }
+            if(g.visible(i)) q += b * g.qualityWeight(i);
+        }
+        double f = sim.freeMB();
+        if(f < 0)  r.oomSec += kDt;
+        if(f < lo) r.belowSec += kDt;
+        r.steps += steps; r.quality += q; ++r.ticks;
+        // An event is recovered once the true free memory is back in (or above) the band.
+        for(auto it = eventAt.begin(); it != eventAt.end(); ){
+            if(t > *it && f >= lo){ r.recoverSec += t - *it; ++r.events; it = eventAt.erase(it); } else ++it;
+        }
+        if(csv) std::fprintf(csv, "%.4f,%.1f,%d,%.1f,%.1f,%d\n", t, f, sim.reportedMB(), sim.externalMB, sim.residentMB(), steps);
+    }
+    r.unrecovered = (int)eventAt.size();
+    r.quality /= std::max<long>(1, r.ticks);
+    return r;
+}
+
+static void printRow(const char* label, const Params& P, const Result& r){
+    std::printf("%-10s %5.2f %5.2f %5d %4d  %7.2f %7.2f %7.2f %4d %7.3f %6d %8.1f\n", label,
+        P.stepGradual, P.stepSpike, P.hysteresisMB, P.stepBudget,
+        r.oomSec, r.belowSec, r.recoverSec, r.unrecovered, r.quality, r.reversals, r.score());
+}
+static void printHeader(){
+    std::printf("%-10s %5s %5s %5s %4s  %7s %7s %7s %4s %7s %6s %8s\n",
+        "", "grad", "spike", "hyst", "bud", "oom s", "below s", "recov s", "miss", "quality", "revers", "score");
+}
+
+int main(int argc, char** argv){
+    Params base; bool sweep=false; double seconds=30.0; unsigned seed=1; const char* csvPath=nullptr;
+    for(int i=1;i<argc;++i){
+        const char* a = argv[i];
+        if(!std::strcmp(a,"--sweep")) sweep = true;
+        else if(!std::strncmp(a,"--seconds=",10)) seconds = std::max(1.0, std::atof(a+10));
+        else if(!std::strncmp(a,"--seed=",7)) seed = (unsigned)std::atoi(a+7);
+        else if(!std::strcmp(a,"--policy=knapsack")) base.knapsack = true;
+        else if(!std::strcmp(a,"--policy=buckets")) base.knapsack = false;
+        else if(!std::strcmp(a,"--control=band")) base.control = ControlMode::Band;
+        else if(!std::strcmp(a,"--control=predictive")) base.control = ControlMode::Predictive;
+        else if(!std::strcmp(a,"--control=pid")) base.control = ControlMode::PID;
+        else if(!std::strcmp(a,"--residency=miptail")) base.residency = ResidencyMode::MipTail;
+        else if(!std::strcmp(a,"--residency=sparse")) base.residency = ResidencyMode::Sparse;
+        else if(!std::strncmp(a,"--csv=",6)) csvPath = a+6;
+        else { std::fprintf(stderr,"usage: %s [--sweep] [--seconds=S] [--seed=N] [--policy=buckets|knapsack] [--control=band|predictive|pid] [--residency=miptail|sparse] [--csv=path]\n", argv[0]); return 2; }
+    }
+
+    std::FILE* csv = csvPath ? std::fopen(csvPath, "w") : nullptr;
+    auto t0 = Clock::now();
+    Result r = run(base, seconds, seed, csv);
+    double sec = std::chrono::duration<double>(Clock::now()-t0).count();
+    if(csv) std::fclose(csv);
+    printHeader();
+    printRow("current", base, r);
+    std::printf("(%ld ticks in %.3fs: %.0f ticks/s)\n", r.ticks, sec, r.ticks/std::max(sec,1e-9));
+    if(!sweep) return 0;
+
+    std::vector<std::pair<Result,Params>> all;
+    t0 = Clock::now();
+    for(float sg : {0.25f, 0.5f, 1.0f})
+    for(float ss : {0.75f, 1.25f, 2.0f})
+    for(int hy : {64, 128, 256})
+    for(int bu : {2, 4, 8, 16}){
+        Params P = base; P.stepGradual=sg; P.stepSpike=ss; P.hysteresisMB=hy; P.stepBudget=bu;
+        all.push_back({run(P, seconds, seed, nullptr), P});
+    }
+    sec = std::chrono::duration<double>(Clock::now()-t0).count();
+    std::sort(all.begin(), all.end(), [](const auto& a, const auto& b){ return a.first.score() < b.first.score(); });
+    std::printf("\nsweep: %zu runs in %.2fs (policy=%s control=%s residency=%s seed=%u)\n", all.size(), sec,
+        base.knapsack ? "knapsack" : "buckets", controlName(base.control),
+        base.residency==ResidencyMode::Sparse ? "sparse" : "miptail", seed);
+    printHeader();
+    for(size_t i=0;i<all.size() && i<10;++i) printRow(i==0 ? "best" : "", all[i].second, all[i].first);
+    printRow("worst", all.back().second, all.back().first);
+    return 0;
+}
@@ -0,0 +1,133 @@
+// GpuTimer — GL_TIME_ELAPSED around one pass, read back without stalling
+// - A ring of kRing query objects; a result is collected once GL_QUERY_RESULT_AVAILABLE says
+//   so (typically 1-3 frames later). If every query is still in flight the frame goes untimed
+// - Time-elapsed queries can't nest: scopes must not overlap
+// GpuTrace — named GPU zones for the trace (timestamp queries, so they may nest)
+// - Start/end GL_TIMESTAMP pairs from a fixed pool, collected when available and mapped onto
+//   the CPU trace clock with an offset measured at capture start
+#pragma once
+
+#include <cstdint>
+
+#include <GL/glew.h>
+
+#include "trace.h"
+
+class GpuTimer {
+public:
+    static constexpr int kRing = 4;
+    float smoothing = 0.9f;     // EMA weight of the previous average
+
+    void init(){ glGenQueries(kRing, q_); }
+    void shutdown(){ glDeleteQueries(kRing, q_); inFlight_ = 0; }
+
+    void begin(){
+        poll();
+        if(inFlight_ == kRing) return;
+        glBeginQuery(GL_TIME_ELAPSED, q_[head_]);
+        active_ = true;
+    }
+    void end(){
+        if(!active_) return;
+        glEndQuery(GL_TIME_ELAPSED);
+        head_ = (head_+1) % kRing; ++inFlight_; active_ = false;
+    }
+
+    bool   hasResult() const { return samples_ > 0; }
+    double lastMs() const { return lastMs_; }
+    double avgMs()  const { return avgMs_; }
+
+private:
+    void poll(){
+        while(inFlight_ > 0){
+            int i = (head_ - inFlight_ + kRing) % kRing;
+            GLuint ready = 0;
+            glGetQueryObjectuiv(q_[i], GL_QUERY_RESULT_AVAILABLE, &ready);
+            if(!ready) break;
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(q_[i], GL_QUERY_RESULT, &ns);
+            lastMs_ = ns * 1e-6;
+            avgMs_  = samples_++ ? smoothing*avgMs_ + (1.0-smoothing)*lastMs_ : lastMs_;
+            --inFlight_;
+        }
+    }
+
+    GLuint q_[kRing] = {};
+    int    head_ = 0, inFlight_ = 0;
+    bool   active_ = false;
+    double lastMs_ = 0.0, avgMs_ = 0.0;
+    uint64_t samples_ = 0;
+};
+
+class GpuTrace {
+public:
+    static constexpr int kSlots = 128;
+
+    void init(){ glGenQueries(2*kSlots, q_); }
+    void shutdown(){ glDeleteQueries(2*kSlots, q_); inFlight_ = 0; }
+
+    // Call once per frame on the render thread (before any zone of that frame).
+    void collect(){
+        if(gTrace.enabled() && !calibrated_) calibrate();
+        if(!gTrace.enabled()) calibrated_ = false;
+        while(inFlight_ > 0){
+            int i = (head_ - inFlight_ + kSlots) % kSlots;
+            if(open_[i]) break;                      // zone still recording
+            GLuint ready = 0;
+            glGetQueryObjectuiv(q_[2*i+1], GL_QUERY_RESULT_AVAILABLE, &ready);
+            if(!ready) break;
+            GLuint64 a=0, b=0;
+            glGetQueryObjectui64v(q_[2*i],   GL_QUERY_RESULT, &a);
+            glGetQueryObjectui64v(q_[2*i+1], GL_QUERY_RESULT, &b);
+            gTrace.gpuRing().push({name_[i], (int64_t)a - offset_, (int64_t)(b - a), 0.0});
+            --inFlight_;
+        }
+    }
+    // -1 when tracing is off or every slot is in flight.
+    int begin(const char* name){
+        if(!gTrace.enabled() || !calibrated_ || inFlight_ == kSlots) return -1;
+        int i = head_;
+        head_ = (head_+1) % kSlots; ++inFlight_;
+        name_[i] = name; open_[i] = true;
+        glQueryCounter(q_[2*i], GL_TIMESTAMP);
+        return i;
+    }
+    void end(int i){
+        if(i < 0) return;
+        glQueryCounter(q_[2*i+1], GL_TIMESTAMP);
+        open_[i] = false;
+    }
+
+private:
+    void calibrate(){
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        offset_ = (int64_t)gpuNow - gTrace.now();
+        calibrated_ = true;
+    }
+
+    GLuint      q_[2*kSlots] = {};
+    const char* name_[kSlots] = {};
+    bool        open_[kSlots] = {};
+    int         head_ = 0, inFlight_ = 0;
+    int64_t     offset_ = 0;
+    bool        calibrated_ = false;
+};
+
+inline GpuTrace gGpuTrace;
+
+class GpuTraceZone {
+public:
+    explicit GpuTraceZone(const char* name) : slot_(gGpuTrace.begin(name)) {}
+    ~GpuTraceZone(){ gGpuTrace.end(slot_); }
+    GpuTraceZone(const GpuTraceZone&) = delete;
+    GpuTraceZone& operator=(const GpuTraceZone&) = delete;
+private:
+    int slot_;
+};
+
+#if VG_TRACE
+#define VG_GPU_ZONE(name) GpuTraceZone VG_CAT(vgGpuZone_, __LINE__)(name)
+#else
+#define VG_GPU_ZONE(name) ((void)0)
+#endif
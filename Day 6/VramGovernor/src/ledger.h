@@ -0,0 +1,166 @@
+// Ledger — every GL allocation the demo makes, with its exact size
+// - Textures, buffers and renderbuffers are created and deleted through the tracked_* helpers,
+//   which record bytes per format / level / sample count under a subsystem tag
+// - Totals are atomics: any thread can read them; the map itself is render-thread only
+// - The FALLBACK telemetry model reports base - ledger total instead of guessing, and
+//   print() gives the per-subsystem breakdown
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+// ---------- Format sizes ----------
+inline size_t bytesPerTexel(GLenum format){
+    switch(format){
+        case GL_R8:      return 1;
+        case GL_R16: case GL_R16F: case GL_RG8: return 2;
+        case GL_RGBA8: case GL_SRGB8_ALPHA8: case GL_RG16F: case GL_R32F:
+        case GL_DEPTH24_STENCIL8: case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32F: return 4;
+        case GL_RGBA16F: case GL_RG32F: return 8;
+        case GL_RGBA32F: return 16;
+        default:         return 4;
+    }
+}
+inline int blockBytesFor(GLenum format){
+    switch(format){
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return 8;
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:   return 16;
+        default:                              return 0;
+    }
+}
+inline bool   isCompressed(GLenum format){ return blockBytesFor(format)!=0; }
+inline size_t levelBytes(GLenum format, int w, int h){
+    if(int bb = blockBytesFor(format)) return (size_t)((w+3)/4) * (size_t)((h+3)/4) * bb;
+    return (size_t)w*h*bytesPerTexel(format);
+}
+inline size_t chainBytes3D(GLenum format, int w, int h, int d, int levels){
+    size_t b=0;
+    for(int l=0;l<levels;++l) b += levelBytes(format, std::max(1,w>>l), std::max(1,h>>l)) * (size_t)std::max(1,d>>l);
+    return b;
+}
+// `levels` levels starting at w x h, each at `samples` samples per texel.
+inline size_t chainBytes(GLenum format, int w, int h, int levels, int samples=1){
+    size_t b=0;
+    for(int l=0;l<levels;++l) b += levelBytes(format, std::max(1,w>>l), std::max(1,h>>l));
+    return b * (size_t)std::max(1, samples);
+}
+
+// ---------- Ledger ----------
+enum class MemTag : int { Governed, Pool, Pad, Target, Readback, Staging, Geometry, Retiring, Count };
+inline const char* memTagName(MemTag t){
+    static const char* n[] = { "governed", "pool", "pad", "target", "readback", "staging", "geometry", "retiring" };
+    return n[(int)t];
+}
+
+class AllocLedger {
+public:
+    static constexpr int kTags = (int)MemTag::Count;
+    enum class Kind : uint64_t { Texture=1, Buffer=2, Renderbuffer=3 };
+
+    // Set (or re-specify) one level of an object; buffers and renderbuffers use level 0.
+    void track(Kind k, GLuint name, MemTag tag, size_t bytes, int level=0){
+        Entry& e = live_[key(k,name)];
+        if(e.levels.empty()) e.tag = tag;
+        else if(e.tag != tag) retag(k, name, tag);
+        if((int)e.levels.size() <= level) e.levels.resize(level+1, 0);
+        add(e.tag, (int64_t)bytes - (int64_t)e.levels[level]);
+        e.levels[level] = bytes;
+    }
+    void retag(Kind k, GLuint name, MemTag tag){
+        auto it = live_.find(key(k,name));
+        if(it==live_.end() || it->second.tag==tag) return;
+        size_t b = it->second.bytes();
+        add(it->second.tag, -(int64_t)b); it->second.tag = tag; add(tag, (int64_t)b);
+    }
+    void untrack(Kind k, GLuint name){
+        auto it = live_.find(key(k,name));
+        if(it==live_.end()) return;
+        add(it->second.tag, -(int64_t)it->second.bytes());
+        live_.erase(it);
+    }
+
+    size_t total() const { return (size_t)total_.load(std::memory_order_relaxed); }
+    size_t bytes(MemTag t) const { return (size_t)byTag_[(int)t].load(std::memory_order_relaxed); }
+    size_t objects() const { return live_.size(); }
+
+    void print() const {
+        std::printf("[Ledger] %.1f MB in %zu objects:", total()/(1024.0*1024.0), objects());
+        for(int t=0;t<kTags;++t) if(bytes((MemTag)t)) std::printf("  %s=%.1f", memTagName((MemTag)t), bytes((MemTag)t)/(1024.0*1024.0));
+        std::printf("\n");
+    }
+
+private:
+    struct Entry {
+        MemTag tag = MemTag::Governed;
+        std::vector<size_t> levels;
+        size_t bytes() const { size_t b=0; for(size_t l : levels) b+=l; return b; }
+    };
+    static uint64_t key(Kind k, GLuint name){ return ((uint64_t)k << 32) | name; }
+    void add(MemTag t, int64_t d){
+        byTag_[(int)t].fetch_add(d, std::memory_order_relaxed);
+        total_.fetch_add(d, std::memory_order_relaxed);
+    }
+
+    std::unordered_map<uint64_t, Entry> live_;
+    std::atomic<int64_t> byTag_[kTags] = {};
+    std::atomic<int64_t> total_{0};
+};
+
+inline AllocLedger gLedger;
+
+// ---------- Tracked allocation (render thread) ----------
+using LedgerKind = AllocLedger::Kind;
+
+// New immutable 2D texture, left bound to GL_TEXTURE_2D.
+inline GLuint trackedTexStorage2D(MemTag tag, int levels, GLenum format, int w, int h){
+    GLuint t=0; glGenTextures(1,&t); glBindTexture(GL_TEXTURE_2D,t);
+    glTexStorage2D(GL_TEXTURE_2D, levels, format, w, h);
+    gLedger.track(LedgerKind::Texture, t, tag, chainBytes(format, w, h, levels));
+    return t;
+}
+// New immutable 3D texture, left bound to GL_TEXTURE_3D.
+inline GLuint trackedTexStorage3D(MemTag tag, int levels, GLenum format, int w, int h, int d){
+    GLuint t=0; glGenTextures(1,&t); glBindTexture(GL_TEXTURE_3D,t);
+    glTexStorage3D(GL_TEXTURE_3D, levels, format, w, h, d);
+    gLedger.track(LedgerKind::Texture, t, tag, chainBytes3D(format, w, h, d, levels));
+    return t;
+}
+// glTexImage2D on the texture bound to GL_TEXTURE_2D (`tex`).
+inline void trackedTexImage2D(MemTag tag, GLuint tex, int level, GLenum internalFormat, int w, int h,
+                              GLenum format, GLenum type, const void* data){
+    glTexImage2D(GL_TEXTURE_2D, level, (GLint)internalFormat, w, h, 0, format, type, data);
+    gLedger.track(LedgerKind::Texture, tex, tag, levelBytes(internalFormat, w, h), level);
+}
+inline void trackedRenderbufferStorage(MemTag tag, GLuint rb, int samples, GLenum format, int w, int h){
+    glBindRenderbuffer(GL_RENDERBUFFER, rb);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, format, w, h);
+    gLedger.track(LedgerKind::Renderbuffer, rb, tag, chainBytes(format, w, h, 1, samples));
+}
+// glBufferData / glBufferStorage on `buf`, which must be bound to `target`.
+inline void trackedBufferData(MemTag tag, GLenum target, GLuint buf, size_t bytes, const void* data, GLenum usage){
+    glBufferData(target, (GLsizeiptr)bytes, data, usage);
+    gLedger.track(LedgerKind::Buffer, buf, tag, bytes);
+}
+inline void trackedBufferStorage(MemTag tag, GLenum target, GLuint buf, size_t bytes, const void* data, GLbitfield flags){
+    glBufferStorage(target, (GLsizeiptr)bytes, data, flags);
+    gLedger.track(LedgerKind::Buffer, buf, tag, bytes);
+}
+
+inline void trackedDeleteTextures(int n, const GLuint* t){
+    for(int i=0;i<n;++i) gLedger.untrack(LedgerKind::Texture, t[i]);
+    glDeleteTextures(n, t);
+}
+inline void trackedDeleteBuffers(int n, const GLuint* b){
+    for(int i=0;i<n;++i) gLedger.untrack(LedgerKind::Buffer, b[i]);
+    glDeleteBuffers(n, b);
+}
+inline void trackedDeleteRenderbuffers(int n, const GLuint* r){
+    for(int i=0;i<n;++i) gLedger.untrack(LedgerKind::Renderbuffer, r[i]);
+    glDeleteRenderbuffers(n, r);
+}
@@ -3,7 +3,59 @@
 // - Governor manages an array of objects grouped by priority buckets
 // - Escalation: Low -> Normal -> High ; Recovery: High -> Normal -> Low
 // - Per-tick step budget to avoid popping; spike "tourniquet" on Low
-// Hotkeys: B (+~256MB pad), Shift+B (free pad), [ / ] (global nudge), R (reset), C (toggle telemetry)
+// - Mip-tail residency: integer bias levels drop/restore the top mips of the texture for real
+// - Every object owns its texture; footprints are computed from format/size/resident mips
+// - Texture data streams in through a persistent-mapped PBO ring under a per-frame byte budget
+// - Image-backed objects decode on a work-stealing pool at their own priority
+// - Textures load from a pre-mipped BC7/BC1 cache (cache/*.vtc) when present; missing or stale
+//   entries are baked in the background for the next run
+// - A low-res metric pass attributes screen coverage and required mip to each object; escalation
+//   drops small-on-screen objects first and levels the sampler doesn't touch are not streamed back
+// - Optional knapsack policy picks the steps that free the most MB per unit of visible quality
+// - GPU timer queries around the grid draw and the metric pass; grid time is a second governor
+//   constraint (frame-time budget) and both, plus the governor's CPU time, show in the title
+// - Every GL allocation goes through the ledger (exact bytes per subsystem); the fallback
+//   telemetry model is built on it
+// - Telemetry is sampled at a fixed rate and cached (NVX incl. eviction counters, ATI, DXGI on
+//   Windows, fallback model); other threads read a lock-free snapshot
+// - Controller modes: reactive band, predictive (freeMB trend + announced pads/stream-ins), PID
+// - Pads and mip stream-ins go through admission control first: granted, granted after degrading
+//   lower-priority objects, or deferred until memory frees up (never paged out by the driver)
+// - Scoped CPU/GPU trace zones (telemetry, governor, admission, residency, uploads, decode,
+//   draws) captured on demand and written as Chrome trace JSON
+// - ARB_sparse_texture backend: governed textures commit/release pages, and a fractional bias
+//   releases that share of the finest resident level's pages (the draw shader stays inside them)
+// - ROI mode (Day 2's sharp circle, following the mouse) as a governor input: objects it doesn't
+//   touch are held at a bias floor, so their top mips/pages are released; one sample per
+//   fragment with the ROI falloff folded into the bias
+// - A shared-context resource thread creates, clears, mips and deletes pads and deletes released
+//   texture storage; results come back fenced, so a pad no longer stalls the frame
+// - Releases (pads, evicted mips, reset) are retired: fenced, then pooled or deleted a few per
+//   frame; the governor counts what is still queued as free
+// - Budget domains: each grid column is a view, each row in it an object group; with domains on
+//   only a view (group) over its share of the global budget escalates
+// - A 16-bit volume (slice stack or phantom) in a fourth column: 64^3 bricks as 3D textures, each
+//   a governed object at its own mip level in a "volume" domain, ray-marched (MIP) and measured
+//   by a voxels-per-pixel variant of the metric pass
+// - Bias changes animate on the GPU (per-object from/to/start in a texture buffer, eased in the
+//   draw shader), so the governor steps up to 32 objects a tick without popping; mip drops wait
+//   until the transition has finished
+// - Warm start: biases, resident levels and controller state are saved per GPU + scene on exit
+//   (profiles/) and reloaded before any texture is created, so objects start at their converged
+//   mip range
+// - The per-frame governor block is the vram_governor library's (VramGovernor::frame): the 2D
+//   objects are its textures, the bias animation holds drops through holdRelease and the volume
+//   bricks are synced from its onSync hook
+// CLI: --bake <image> [bc7|bc1|rgba] (bake offline and exit), --cache=<bc7|bc1|rgba|off>, --sparse=off,
+//      --volume=<dir of 16-bit PNG slices|phantom|off>, --slice-spacing=<mm>, --volume-format=<r16|r16f>,
+//      --bias-anim=<seconds> (0: no smoothing, original step budget), --profile=off
+// Hotkeys: B (+~341MB pad, 8K RGBA8 with mips), Shift+B (free pad), [ / ] (global nudge), R (reset), C (toggle telemetry),
+//          M (cycle residency mode: mip-tail eviction / LOD bias only / sparse pages when available),
+//          K (toggle step policy: priority buckets / cost-benefit knapsack),
+//          P (cycle controller: band / predictive / PID), L (print allocation ledger),
+//          G (cycle GPU budget: off / 4 / 8 / 16 ms), T (start / stop trace capture -> trace_NNN.json),
+//          O (toggle ROI mode), D (toggle budget domains), V (show / hide the volume),
+//          A (toggle bias animation)
 
 #include <cstdio>
 #include <cstdlib>
@@ -13,40 +65,45 @@
 #include <vector>
 #include <algorithm>
 #include <numeric>
+#include <filesystem>
+#include <cstddef>
+#include <chrono>
+#include <memory>
+#include <functional>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-#ifndef GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX
-#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX         0x9047
-#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX    0x9048
-#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX  0x9049
-#define GL_GPU_MEMORY_INFO_EVICTION_COUNT_NVX            0x904A
-#define GL_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX            0x904B
-#endif
+#include "upload.h"
+#include "resource_thread.h"
+#include "decode_pool.h"
+#include "residency.h"
+#include "density.h"
+#include "volume.h"
+#include "bias_anim.h"
+#include "profile.h"
+#include "governor.h"
+#include "admission.h"
+#include "telemetry.h"
+#include "ledger.h"
+#include "gputimer.h"
+#include "trace.h"
+#include "vram_governor.h"      // the governor loop, shader helpers, stb_image's implementation
 
 #ifndef GL_TEXTURE_MAX_LEVEL
 #define GL_TEXTURE_MAX_LEVEL 0x813D
 #endif
 
 // =================== GL helpers ===================
+// The demo has no fallback shaders: a build error ends it.
 static GLuint compile(GLenum type, const char* src){
-    GLuint s = glCreateShader(type);
-    glShaderSource(s,1,&src,nullptr);
-    glCompileShader(s);
-    GLint ok=0; glGetShaderiv(s,GL_COMPILE_STATUS,&ok);
-    if(!ok){ GLint len=0; glGetShaderiv(s,GL_INFO_LOG_LENGTH,&len);
-        std::string log(len,'\0'); glGetShaderInfoLog(s,len,nullptr,log.data());
-        std::fprintf(stderr,"[Shader] compile error:\n%s\n", log.c_str()); std::exit(1); }
+    GLuint s = vgCompileShader(type, src);
+    if(!s) std::exit(1);
     return s;
 }
 static GLuint link(GLuint vs, GLuint fs){
-    GLuint p = glCreateProgram();
-    glAttachShader(p,vs); glAttachShader(p,fs); glLinkProgram(p);
-    GLint ok=0; glGetProgramiv(p,GL_LINK_STATUS,&ok);
-    if(!ok){ GLint len=0; glGetProgramiv(p,GL_INFO_LOG_LENGTH,&len);
-        std::string log(len,'\0'); glGetProgramInfoLog(p,len,nullptr,log.data());
-        std::fprintf(stderr,"[Program] link error:\n%s\n", log.c_str()); std::exit(1); }
+    GLuint p = vgLinkProgram(vs, fs);
+    if(!p) std::exit(1);
     return p;
 }
 
@@ -61,12 +118,43 @@ layout(location=1) in vec2 aUV;
 out vec2 vUV;
 void main(){ vUV=aUV; gl_Position=vec4(aPos,0.0,1.0); })";
 
+// Batched draw: the unit quad is placed by a per-instance NDC rect and sampled at its
+// object's animated bias (plus the global nudge). Compiled after kBiasAnimGLSL.
+static const char* VS_INST = R"(
+layout(location=0) in vec2 aPos;
+layout(location=1) in vec2 aUV;
+layout(location=2) in vec4 aRect;   // x0,y0,x1,y1 in NDC
+layout(location=3) in float aId;    // governor object id
+layout(location=4) in vec2 aCommit; // sparse: finest committed level above BASE_LEVEL, committed share of its height
+out vec2 vUV; flat out float vBias; flat out vec2 vCommit;
+void main(){
+    vUV=aUV; vBias=animatedBias(int(aId + 0.5)); vCommit=aCommit;
+    gl_Position=vec4(mix(aRect.xy, aRect.zw, aPos*0.5+0.5),0.0,1.0);
+})";
+
 static const char* FS = R"(#version 330 core
-in vec2 vUV; out vec4 fragColor;
+in vec2 vUV; flat in float vBias; flat in vec2 vCommit; out vec4 fragColor;
 uniform sampler2D uTex;
-uniform float uBias;
+uniform float uNudge;
+uniform vec4  uRoi;         // centre (fb px), radius, feather; radius < 0: off
+uniform float uRoiFloor;
 void main(){
-    vec3 c = texture(uTex, vUV, uBias).rgb;
+    float bias = vBias;
+    if(uRoi.z >= 0.0) bias = max(bias, uRoiFloor * smoothstep(uRoi.z, uRoi.z + uRoi.w, distance(gl_FragCoord.xy, uRoi.xy)));
+    vec2 size = vec2(textureSize(uTex, 0));
+    vec2 t = vUV * size;
+    float lambda = log2(max(max(length(dFdx(t)), length(dFdy(t))), 1e-8));
+    vec3 c;
+    if(vCommit.x < 0.0) c = texture(uTex, vUV, bias + uNudge).rgb;
+    else {
+        // Sparse: the committed band of the partial level is [0, vCommit.y) in v, one texel
+        // margin for the bilinear footprint; outside it sample the next (fully committed) level.
+        // size and textureLod are both relative to BASE_LEVEL, and so is vCommit.x.
+        float v = fract(vUV.y), m = exp2(vCommit.x) / size.y;
+        bool inBand = vCommit.y >= 1.0 || (v > m && v < vCommit.y - m);
+        float minLod = inBand ? vCommit.x : vCommit.x + 1.0;
+        c = textureLod(uTex, vUV, max(lambda + floor(bias) + uNudge, minLod)).rgb;
+    }
     fragColor = vec4(c,1.0);
 })";
 
@@ -78,95 +166,149 @@ static std::vector<uint8_t> makeChecker(int w,int h,int chk=32){
     }
     return v;
 }
-static GLuint makeCheckerTex(int W=2048,int H=2048){
-    auto pix = makeChecker(W,H,32);
-    GLuint t=0; glGenTextures(1,&t); glBindTexture(GL_TEXTURE_2D,t);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
-    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA8,W,H,0,GL_RGBA,GL_UNSIGNED_BYTE,pix.data());
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D,0);
-    return t;
+// Level source for the checker: a box-filtered 32px checker is a (32>>level)px checker,
+// collapsing to flat grey once the squares are smaller than a texel.
+static LevelSource checkerSource(int chk=32){
+    return [chk](int level,int w,int h){
+        int c = chk >> level;
+        if(c>=1) return makeChecker(w,h,c);
+        std::vector<uint8_t> v((size_t)w*h*4, 130);
+        for(size_t i=3;i<v.size();i+=4) v[i]=255;
+        return v;
+    };
+}
+static GovTexture makeCheckerTex(int W=2048,int H=2048,int chk=32,int top=0){
+    GovTexture T; T.baseW=W; T.baseH=H; T.source=checkerSource(chk);
+    createGovTexture(T, top);
+    return T;
+}
+// Image-backed texture: only the header is read here, pixels decode on gDecode.
+// Falls back to a procedural checker if the file can't be opened.
+static GovTexture makeImageTex(const char* path, int priority, int top=0){
+    int w=0,h=0,ch=0;
+    if(!stbi_info(path,&w,&h,&ch)){
+        std::fprintf(stderr,"[Decode] %s not found, using procedural checker\n", path);
+        return makeCheckerTex(2048,2048,32,top);
+    }
+    GovTexture T; T.baseW=w; T.baseH=h; T.imagePath=path; T.priority=priority;
+    T.source = [p=std::string(path)](int level,int,int){      // synchronous path (no pool)
+        std::vector<DecodedLevel> out; decodeLevels(p, level, level+1, out);
+        return out.empty() ? std::vector<uint8_t>() : std::move(out.back().rgba);
+    };
+    createGovTexture(T, top);
+    return T;
+}
+
+// =================== Texture cache ===================
+static bool        gUseCache = true;
+static bool        gNoSparse = false;
+static bool        gCacheFmtForced = false;
+static CacheFormat gCacheFmt = CacheFormat::BC7;
+
+static bool cacheFormatSupported(CacheFormat f){
+    if(f==CacheFormat::BC7) return GLEW_ARB_texture_compression_bptc;
+    if(f==CacheFormat::BC1) return GLEW_EXT_texture_compression_s3tc;
+    return true;
+}
+// Best supported format unless one was asked for on the command line.
+static void pickCacheFormat(){
+    if(gCacheFmtForced && !cacheFormatSupported(gCacheFmt)){
+        std::fprintf(stderr,"[Cache] %s not supported here, using rgba\n", cacheFormatName(gCacheFmt));
+        gCacheFmt = CacheFormat::RGBA8;
+    }
+    if(!gCacheFmtForced)
+        gCacheFmt = cacheFormatSupported(CacheFormat::BC7) ? CacheFormat::BC7
+                  : (cacheFormatSupported(CacheFormat::BC1) ? CacheFormat::BC1 : CacheFormat::RGBA8);
+    if(gUseCache) std::printf("[Cache] format=%s dir=%s\n", cacheFormatName(gCacheFmt), gCacheDir.c_str());
+}
+
+// Map the baked cache entry if it is current; otherwise build the texture the normal way and
+// queue a Low-priority bake on gDecode so the next run starts from the cache. `top`: finest
+// level to create (a warm start from the profile skips levels that would be dropped at once).
+static GovTexture makeGovernedTex(const char* image, int W, int H, int priority, int top=0){
+    const int chk = 32;
+    std::string name; uint64_t key=0;
+    if(image){ name = std::filesystem::path(image).stem().string(); key = sourceKeyForFile(image); }
+    else {
+        name = "checker_" + std::to_string(W) + "x" + std::to_string(H);
+        key  = sourceKey(name + ":" + std::to_string(chk));
+    }
+    if(gUseCache && key){
+        std::string path = cachePathFor(name, gCacheFmt);
+        GovTexture T; T.priority = priority;
+        if(createGovTextureFromCache(T, MappedTexCache::open(path, key), top)){
+            std::printf("[Cache] %s\n", path.c_str());
+            return T;
+        }
+        DecodeRequest rq; rq.priority = 0;
+        if(image) rq.task = [img=std::string(image), path, f=gCacheFmt]{ bakeImageCache(img, path, f); };
+        else      rq.task = [W,H,chk,key,path, f=gCacheFmt]{ bakeTexCache(path, f, key, levelsFromSource(W,H,checkerSource(chk))); };
+        gDecode.submit(std::move(rq));
+    }
+    return image ? makeImageTex(image, priority, top) : makeCheckerTex(W,H,chk,top);
 }
 
 // =================== Pad allocator (real commit) ===================
-struct Pad { GLuint tex=0, fbo=0; };
+struct Pad { GLuint tex=0; };
 static const int PAD_W=8192, PAD_H=8192;
 static std::vector<Pad> gPads;
 
-static Pad createCommittedPad(){
-    Pad P{};
-    glGenTextures(1,&P.tex);
-    glBindTexture(GL_TEXTURE_2D, P.tex);
-    int levels = 1 + (int)std::floor(std::log2(std::max(PAD_W,PAD_H)));
-    glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, PAD_W, PAD_H);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels-1);
-
-    glGenFramebuffers(1,&P.fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, P.fbo);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, P.tex, 0);
-    GLenum st = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-    if (st != GL_FRAMEBUFFER_COMPLETE) {
-        std::fprintf(stderr,"[FBO] incomplete 0x%X\n", st);
-    }
-    glClearColor(0.12f,0.13f,0.15f,1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glBindTexture(GL_TEXTURE_2D, P.tex);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindFramebuffer(GL_FRAMEBUFFER,0);
-    glBindTexture(GL_TEXTURE_2D,0);
-    return P;
+static int padLevels(){ return 1 + (int)std::floor(std::log2(std::max(PAD_W,PAD_H))); }
+static double padMB(){ return chainBytes(GL_RGBA8, PAD_W, PAD_H, padLevels()) / (1024.0*1024.0); }   // ~341: mips add a third
+
+static int gPadsCreating = 0;
+
+// Runs on the resource thread (the FBO is per-context, so it lives and dies there);
+// `done(tex)` gets the finished pad on the render thread.
+static void createCommittedPad(std::function<void(GLuint)> done){
+    ++gPadsCreating;
+    auto tex = std::make_shared<GLuint>(0);
+    gRes.post([tex]{
+        int levels = padLevels();
+        glGenTextures(1, tex.get());
+        glBindTexture(GL_TEXTURE_2D, *tex);
+        glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, PAD_W, PAD_H);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels-1);
+
+        GLuint fbo=0;
+        glGenFramebuffers(1,&fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *tex, 0);
+        GLenum st = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (st != GL_FRAMEBUFFER_COMPLETE) {
+            std::fprintf(stderr,"[FBO] incomplete 0x%X\n", st);
+        }
+        glClearColor(0.12f,0.13f,0.15f,1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindFramebuffer(GL_FRAMEBUFFER,0);
+        glDeleteFramebuffers(1,&fbo);
+        glBindTexture(GL_TEXTURE_2D,0);
+    }, [tex, done=std::move(done)]{
+        --gPadsCreating;
+        gLedger.track(LedgerKind::Texture, *tex, MemTag::Pad, chainBytes(GL_RGBA8, PAD_W, PAD_H, padLevels()));
+        done(*tex);
+    });
 }
 static void destroyPad(Pad& P){
-    if(P.fbo) glDeleteFramebuffers(1,&P.fbo);
-    if(P.tex) glDeleteTextures(1,&P.tex);
-    P.fbo=0; P.tex=0;
+    gRetire.retire(P.tex, chainBytes(GL_RGBA8, PAD_W, PAD_H, padLevels()));
+    P.tex=0;
 }
 
+// =================== Governor library ===================
+// Owns the governor, admission, telemetry and the 2D objects' textures (vram_governor.h).
+static VramGovernor gVg;
+
 // =================== Telemetry & fallback ===================
-enum class TelMode { NVX, ATI, FALLBACK };
-struct Telemetry {
-    TelMode mode = TelMode::FALLBACK;
-    bool nvx=false, ati=false;
-    bool useTelemetry=true;
-    int  fallbackBaseFreeMB = 2048;
-    int  padBlocks=0;
-
-    void init(){
-        GLint n=0; glGetIntegerv(GL_NUM_EXTENSIONS,&n);
-        for(GLint i=0;i<n;++i){
-            const char* e=(const char*)glGetStringi(GL_EXTENSIONS,(GLuint)i);
-            if(!e) continue; std::string s(e);
-            if(s=="GL_NVX_gpu_memory_info") nvx=true;
-            if(s=="GL_ATI_meminfo") ati=true;
-        }
-        mode = nvx ? TelMode::NVX : (ati ? TelMode::ATI : TelMode::FALLBACK);
-        std::printf("[Init] Telemetry NVX=%d ATI=%d -> %s\n",
-            nvx?1:0, ati?1:0, mode==TelMode::NVX?"NVX":(mode==TelMode::ATI?"ATI":"FALLBACK"));
-    }
-    std::pair<bool,int> readFreeMB(){
-        if(useTelemetry){
-            if(mode==TelMode::NVX){
-                GLint kb=0; glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX,&kb);
-                if(glGetError()==GL_NO_ERROR && kb>0) return {true, kb/1024};
-            } else if(mode==TelMode::ATI){
-                GLint kb[4]={0,0,0,0}; glGetIntegerv(0x87FC, kb);
-                if(glGetError()==GL_NO_ERROR && kb[0]>0) return {true, kb[0]/1024};
-            }
-        }
-        int freeMB = std::max(0, fallbackBaseFreeMB - padBlocks*256);
-        return {false, freeMB};
-    }
-} gTel;
+// Sampled every samplePeriod (cached in between) and published to gTelSnapshot; see telemetry.h.
+static Telemetry& gTel = gVg.telemetry();
 
 struct TelWatchdog {
     int lastMB=-1, noMoves=0;
     void onAllocCheck(){
-        auto [valid, nowMB] = gTel.readFreeMB();
+        auto [valid, nowMB] = gTel.readNow(glfwGetTime());
         if(!valid) return;
         if(lastMB<0){ lastMB=nowMB; return; }
         int delta = lastMB - nowMB;
@@ -181,154 +323,247 @@ struct TelWatchdog {
 } gWatch;
 
 // =================== Day 6 Data Model ===================
-enum class Priority : int { Low=0, Normal=1, High=2 };
-
+// Governed state (priority, bias, footprint, density) lives in gGov's arrays, indexed by id;
+// the demo side only keeps what it draws.
 struct GovObject {
-    int         id = -1;
-    Priority    priority = Priority::Normal;
-    float       bias = 0.f;
-    float       biasMin = 0.f;
-    float       biasMax = 8.f;
-    bool        visible = true;
-    float       estMB = 64.f; // optional: estimated memory footprint
+    int         id = -1;      // index into gGov; the texture is gVg.govTexture(id)
     // Draw placement (for our grid demo)
     int gridX=0, gridY=0;
+    float screenScale = 1.f;  // fraction of the grid cell the quad fills
 };
 
-struct Governor {
-    // Global goals
-    int   targetFreeMB = 1024;
-    int   hysteresisMB = 128;
-    int   spikeThreshMB= 256;
-
-    // dynamics
-    float stepGradual   = 0.5f;
-    float stepSpike     = 1.25f;
-    int   stepBudgetPerTick = 4; // number of object-steps per tick
-
-    // time
-    int    lastFreeMB=-1;
-    double lastEval=0.0;
-    double evalDt=0.25;
-    double lastPrint=0.0;
-
-    // debug/global
-    float globalNudge=0.f;
-
-    // objects
-    std::vector<GovObject> objects;
-
-    // scratch buckets (indices into objects)
-    std::vector<int> bucketLow, bucketNorm, bucketHigh;
-
-    void rebuildBuckets(){
-        bucketLow.clear(); bucketNorm.clear(); bucketHigh.clear();
-        for(int i=0;i<(int)objects.size();++i){
-            if(!objects[i].visible) continue;
-            switch(objects[i].priority){
-                case Priority::Low:    bucketLow.push_back(i);  break;
-                case Priority::Normal: bucketNorm.push_back(i); break;
-                case Priority::High:   bucketHigh.push_back(i); break;
-            }
-        }
-        // Example policy: within each bucket, largest memory first
-        auto sortByEstMB = [&](std::vector<int>& b){
-            std::sort(b.begin(), b.end(), [&](int a,int b){ return objects[a].estMB > objects[b].estMB; });
-        };
-        sortByEstMB(bucketLow);
-        sortByEstMB(bucketNorm);
-        sortByEstMB(bucketHigh);
-    }
-
-    static void clampObj(GovObject& o){ o.bias = std::clamp(o.bias, o.biasMin, o.biasMax); }
+static Governor& gGov = gVg.governor();
+static std::vector<GovObject> gObjects;
+static AdmissionControl& gAdmit = gVg.admission();
 
-    void applySteps(std::vector<int>& bucket, float delta, int& budget){
-        for(int idx : bucket){
-            if(budget<=0) break;
-            GovObject& o = objects[idx];
-            float old = o.bias;
-            o.bias += delta;
-            clampObj(o);
-            if (o.bias != old) --budget; // count only if it actually changed
-        }
-    }
+// Volume column: bricks are governor objects too (ids after the 2D objects).
+static GovVolume   gVolume;
+static std::string gVolumeSource = "phantom";
+static float       gSliceSpacing = 1.f;
+static GLenum      gVolumeFormat = GL_R16;
+static bool        gVolumeShown = true;
+static bool        gUseProfile = true;
+static const int   kBrickUploadsPerFrame = 8;    // brick re-uploads are synchronous
 
-    void spikeTourniquet(){
-        // Hit the Low bucket first, stronger step; budget-limited
-        int budget = stepBudgetPerTick;
-        applySteps(bucketLow, +stepSpike, budget);
-    }
+// =================== GL state & rendering ===================
+static GLuint gProg=0, gVAO=0, gVBO=0;
+static bool gRunning=true;
+static GpuTimer gGridTimer, gMetricTimer;
 
-    void escalate(){
-        int budget = stepBudgetPerTick;
-        // Low -> Normal -> High
-        applySteps(bucketLow,  +stepGradual, budget);
-        applySteps(bucketNorm, +stepGradual, budget);
-        applySteps(bucketHigh, +stepGradual, budget);
-    }
+// gVg.holdRelease: retarget the object's bias animation; while it is still fading towards the
+// coarser level, the finer one stays resident until nothing samples it.
+static bool holdForBiasAnim(int id, double now){
+    gBiasAnim.setTarget(id, gGov.bias(id), now);
+    return !gBiasAnim.settled(id, now);
+}
 
-    void deescalate(){
-        int budget = stepBudgetPerTick;
-        // High -> Normal -> Low
-        applySteps(bucketHigh, -stepGradual, budget);
-        applySteps(bucketNorm, -stepGradual, budget);
-        applySteps(bucketLow,  -stepGradual, budget);
+// gVg.onSync: volume bricks follow their governor levels, a few re-uploads per pass.
+static void syncVolume(){
+    int uploads = 0;
+    for(auto& k : gVolume.bricks){
+        if(uploads >= kBrickUploadsPerFrame) break;
+        int want = gGov.visible(k.id) ? gGov.wantedTop(k.id) : gVolume.levels-1;
+        if(want==k.level) continue;
+        double growMB = ((double)gVolume.brickBytes(k, want) - (double)k.bytes) / (1024.0*1024.0);
+        if(growMB > 0.0 && !gAdmit.tryAdmit(growMB, gGov.priority(k.id), glfwGetTime())) continue;
+        int before = k.level;
+        setBrickLevel(gVolume, k, want); ++uploads;
+        if(gGov.verbose) std::printf("[Residency] brick %d,%d,%d level %d -> %d (%.2f MB)\n", k.bx, k.by, k.bz, before, k.level, k.bytes/(1024.0*1024.0));
+        gGov.setFootprint(k.id, (float)(k.bytes/(1024.0*1024.0)), k.level, gVolume.levels);
     }
+}
 
-    void nudge(float d){ globalNudge = std::clamp(globalNudge+d, -4.f, 4.f); }
-
-    void evaluate(double now, int freeMB, bool telValid){
-        if(lastFreeMB<0){ lastFreeMB=freeMB; lastEval=now; return; }
-        if(now-lastEval < evalDt) return;
-        lastEval = now;
+// Simple 3x2 grid layout for our 6 demo objects, using object.gridX/gridY; each quad is
+// centred in its cell at screenScale. A loaded volume takes a fourth, full-height column.
+static int gridCols(){ return gVolume.loaded() ? 4 : 3; }
+static void volumePane(int fbW,int fbH, int& x,int& y,int& w,int& h){
+    w = fbW/gridCols(); h = fbH; x = 3*w; y = 0;
+}
+static void objectRect(const GovObject& o, int fbW,int fbH, int& x,int& y,int& w,int& h){
+    int cols=gridCols(), rows=2;
+    int cellW = fbW/cols, cellH = fbH/rows;
+    w = std::max(1, (int)(cellW*o.screenScale)); h = std::max(1, (int)(cellH*o.screenScale));
+    x = o.gridX * cellW + (cellW-w)/2;
+    y = (rows-1 - o.gridY) * cellH + (cellH-h)/2; // origin bottom
+}
 
-        int delta = freeMB - lastFreeMB; // negative = drop
-        lastFreeMB = freeMB;
+// =================== Region of interest ===================
+// Day 2's sharp circle, in framebuffer pixels. Each object's ROI overlap is the falloff at the
+// nearest point of its quad: anything the sharp radius touches counts as fully inside.
+static float gRoiX=0.f, gRoiY=0.f, gRoiRadius=160.f, gRoiFeather=90.f;
+
+static float roiInside(float x0, float y0, float x1, float y1){
+    float dx = std::max({x0 - gRoiX, 0.f, gRoiX - x1});
+    float dy = std::max({y0 - gRoiY, 0.f, gRoiY - y1});
+    float d = std::sqrt(dx*dx + dy*dy);
+    float t = std::clamp((d - gRoiRadius) / gRoiFeather, 0.f, 1.f);
+    return 1.f - t*t*(3.f - 2.f*t);                          // 1 - smoothstep, as in the shader
+}
 
-        rebuildBuckets();
+static void updateRoi(GLFWwindow* win, int fbW, int fbH){
+    double mx=0.0, my=0.0; int ww=1, wh=1;
+    glfwGetCursorPos(win, &mx, &my);
+    glfwGetWindowSize(win, &ww, &wh);
+    gRoiX = (float)(mx * fbW / std::max(1, ww));
+    gRoiY = (float)(fbH - my * fbH / std::max(1, wh));      // gl_FragCoord is bottom-up
+    for(const auto& o : gObjects){
+        int x,y,w,h; objectRect(o, fbW,fbH, x,y,w,h);
+        gGov.setRoi(o.id, roiInside((float)x, (float)y, (float)(x+w), (float)(y+h)));
+    }
+    if(!gVolume.loaded()) return;
+    int px,py,pw,ph; volumePane(fbW,fbH, px,py,pw,ph);
+    for(const auto& k : gVolume.bricks){
+        float x0,y0,x1,y1;
+        bool on = gVolumeRenderer.brickRect(gVolume, k, px,py,pw,ph, x0,y0,x1,y1);
+        gGov.setRoi(k.id, on ? roiInside(std::max(x0,(float)px), std::max(y0,(float)py),
+                                         std::min(x1,(float)(px+pw)), std::min(y1,(float)(py+ph))) : 0.f);
+    }
+}
 
-        if (delta <= -spikeThreshMB) spikeTourniquet();
+// =================== Batched draw ===================
+// One program/VAO/sampler bind per frame. Objects are sorted by texture and each run of
+// objects sharing a texture is a single instanced draw; uniform locations are looked up
+// once at link time and filtering lives in one sampler object.
+struct QuadInstance { float x0,y0,x1,y1, id, commitLevel, commitV; };
+static GLuint gInstVAO=0, gInstVBO=0, gSampler=0;
+static GLint  gLocNudge=-1, gLocRoi=-1, gLocRoiFloor=-1, gLocTime=-1;
+static size_t gInstCap=0;
+static std::vector<QuadInstance> gInstances;            // reused every frame
+static std::vector<std::pair<GLuint,int>> gDrawOrder;   // (texture, object index)
+
+static void setInstanceAttribs(size_t first){
+    const GLsizei stride = sizeof(QuadInstance);
+    const size_t  base = first*sizeof(QuadInstance);
+    glVertexAttribPointer(2,4,GL_FLOAT,GL_FALSE,stride,(void*)base);
+    glVertexAttribPointer(3,1,GL_FLOAT,GL_FALSE,stride,(void*)(base + offsetof(QuadInstance,id)));
+    glVertexAttribPointer(4,2,GL_FLOAT,GL_FALSE,stride,(void*)(base + offsetof(QuadInstance,commitLevel)));
+}
 
-        int lo = targetFreeMB - hysteresisMB;
-        int hi = targetFreeMB + hysteresisMB;
+static void initBatchedDraw(){
+    glUseProgram(gProg);
+    glUniform1i(glGetUniformLocation(gProg,"uTex"), 0);
+    gLocNudge = glGetUniformLocation(gProg,"uNudge");
+    gLocRoi = glGetUniformLocation(gProg,"uRoi");
+    gLocRoiFloor = glGetUniformLocation(gProg,"uRoiFloor");
+    gLocTime = glGetUniformLocation(gProg,"uTime");
+    glUniform1i(glGetUniformLocation(gProg,"uBiasAnim"), 1);
+    glUseProgram(0);
+
+    glGenSamplers(1,&gSampler);
+    glSamplerParameteri(gSampler,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
+    glSamplerParameteri(gSampler,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    glSamplerParameteri(gSampler,GL_TEXTURE_WRAP_S,GL_REPEAT);
+    glSamplerParameteri(gSampler,GL_TEXTURE_WRAP_T,GL_REPEAT);
+
+    glGenBuffers(1,&gInstVBO);
+    glGenVertexArrays(1,&gInstVAO); glBindVertexArray(gInstVAO);
+    glBindBuffer(GL_ARRAY_BUFFER,gVBO);
+    glEnableVertexAttribArray(0); glVertexAttribPointer(0,2,GL_FLOAT,GL_FALSE,sizeof(float)*4,(void*)0);
+    glEnableVertexAttribArray(1); glVertexAttribPointer(1,2,GL_FLOAT,GL_FALSE,sizeof(float)*4,(void*)(sizeof(float)*2));
+    glBindBuffer(GL_ARRAY_BUFFER,gInstVBO);
+    glEnableVertexAttribArray(2); glVertexAttribDivisor(2,1);
+    glEnableVertexAttribArray(3); glVertexAttribDivisor(3,1);
+    glEnableVertexAttribArray(4); glVertexAttribDivisor(4,1);
+    setInstanceAttribs(0);
+    glBindVertexArray(0); glBindBuffer(GL_ARRAY_BUFFER,0);
+}
 
-        if      (freeMB < lo) escalate();
-        else if (freeMB > hi) deescalate();
+static void destroyBatchedDraw(){
+    glDeleteVertexArrays(1,&gInstVAO); trackedDeleteBuffers(1,&gInstVBO); glDeleteSamplers(1,&gSampler);
+    gInstVAO=gInstVBO=gSampler=0; gInstCap=0;
+}
 
-        if(now-lastPrint>0.5){
-            lastPrint=now;
-            std::printf("freeMB=%4d (Δ %+4d) [%s] objs=%zu  L/N/H=%zu/%zu/%zu  nudge=%.2f\n",
-                freeMB, delta, telValid?"telemetry":"fallback",
-                objects.size(), bucketLow.size(), bucketNorm.size(), bucketHigh.size(), globalNudge);
-        }
+static void drawObjectsGrid(int fbW,int fbH){
+    VG_ZONE("draw.grid");
+    VG_GPU_ZONE("draw.grid");
+    gDrawOrder.clear();
+    for(int i=0;i<(int)gObjects.size();++i)
+        if(gGov.visible(gObjects[i].id) && gVg.texture(gObjects[i].id)) gDrawOrder.push_back({gVg.texture(gObjects[i].id), i});
+    if(gDrawOrder.empty()) return;
+    std::sort(gDrawOrder.begin(), gDrawOrder.end());
+
+    gInstances.clear();
+    for(auto& [tex, i] : gDrawOrder){
+        const GovObject& o = gObjects[i];
+        const GovTexture& T = gVg.govTexture(o.id);
+        int x,y,w,h; objectRect(o, fbW,fbH, x,y,w,h);
+        gInstances.push_back({ 2.f*x/fbW-1.f, 2.f*y/fbH-1.f, 2.f*(x+w)/fbW-1.f, 2.f*(y+h)/fbH-1.f, (float)o.id,
+                               T.sparse ? 0.f : -1.f, committedV(T) });   // setSparseResidency keeps BASE_LEVEL at residentTop
     }
-} gGov;
-
-// =================== GL state & rendering ===================
-static GLuint gProg=0, gVAO=0, gVBO=0, gTex=0;
-static bool gRunning=true;
+    size_t bytes = gInstances.size()*sizeof(QuadInstance);
+    glBindBuffer(GL_ARRAY_BUFFER,gInstVBO);
+    if(bytes > gInstCap) gInstCap = bytes*2;
+    trackedBufferData(MemTag::Geometry, GL_ARRAY_BUFFER, gInstVBO, gInstCap, nullptr, GL_STREAM_DRAW);   // orphan
+    glBufferSubData(GL_ARRAY_BUFFER,0,(GLsizeiptr)bytes,gInstances.data());
 
-static void drawQuadViewport(int x,int y,int w,int h, float bias){
-    glViewport(x,y,w,h);
+    glViewport(0,0,fbW,fbH);
     glUseProgram(gProg);
-    GLint locBias = glGetUniformLocation(gProg,"uBias");
-    glUniform1f(locBias, bias + gGov.globalNudge);
+    glUniform1f(gLocNudge, gGov.globalNudge);
+    glUniform4f(gLocRoi, gRoiX, gRoiY, gGov.roiEnabled() ? gRoiRadius : -1.f, gRoiFeather);
+    glUniform1f(gLocRoiFloor, gGov.roiFloor);
+    glUniform1f(gLocTime, gBiasAnim.time(glfwGetTime()));
+    gBiasAnim.bind(1);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTex);
-    glUniform1i(glGetUniformLocation(gProg,"uTex"), 0);
-    glBindVertexArray(gVAO);
-    glDrawArrays(GL_TRIANGLES,0,6);
+    glBindSampler(0,gSampler);
+    glBindVertexArray(gInstVAO);
+    for(size_t first=0; first<gDrawOrder.size(); ){
+        size_t last = first+1;
+        while(last<gDrawOrder.size() && gDrawOrder[last].first==gDrawOrder[first].first) ++last;
+        glBindTexture(GL_TEXTURE_2D, gDrawOrder[first].first);
+        setInstanceAttribs(first);
+        glDrawArraysInstanced(GL_TRIANGLES,0,6,(GLsizei)(last-first));
+        first = last;
+    }
     glBindVertexArray(0);
+    glBindSampler(0,0);
+    glBindBuffer(GL_ARRAY_BUFFER,0);
 }
 
-static void drawObjectsGrid(int fbW,int fbH){
-    // Simple 3x2 grid layout for our 6 demo objects, using object.gridX/gridY
-    int cols=3, rows=2;
-    int cellW = fbW/cols, cellH = fbH/rows;
-    for(const auto& o : gGov.objects){
-        int vx = o.gridX * cellW;
-        int vy = (rows-1 - o.gridY) * cellH; // origin bottom
-        drawQuadViewport(vx, vy, cellW, cellH, o.bias);
+static void drawVolume(int fbW,int fbH){
+    if(!gVolume.loaded() || !gVolumeShown) return;
+    VG_ZONE("draw.volume");
+    VG_GPU_ZONE("draw.volume");
+    int x,y,w,h; volumePane(fbW,fbH, x,y,w,h);
+    gVolumeRenderer.setView(gVolume, w, h);
+    gVolumeRenderer.draw(gVolume, x,y,w,h);
+    glViewport(0,0,fbW,fbH);
+}
+
+// Metric pass (every gDensity.sampleEvery frames) and hand the newest sample to the objects.
+static void sampleDensity(uint64_t frame, int fbW,int fbH){
+    VG_ZONE("density");
+    if(gDensity.begin(frame, fbW, fbH)){
+        VG_GPU_ZONE("density.pass");
+        gMetricTimer.begin();
+        for(const auto& o : gObjects){
+            if(!gGov.visible(o.id)) continue;
+            int x,y,w,h; objectRect(o, fbW,fbH, x,y,w,h);
+            const GovTexture& T = gVg.govTexture(o.id);
+            gDensity.drawObject(o.id, T.baseW, T.baseH, x,y,w,h, gVAO);
+        }
+        if(gVolume.loaded() && gVolumeShown){
+            int x,y,w,h; volumePane(fbW,fbH, x,y,w,h);
+            gVolumeRenderer.drawMetric(gVolume, x,y,w,h, gDensity.downscale);
+        }
+        gDensity.end();
+        gMetricTimer.end();
+        glViewport(0,0,fbW,fbH);
+    }
+    if(!gDensity.hasSample()) return;
+    const auto& res = gDensity.results();
+    for(auto& o : gObjects){
+        ObjDensity d = (o.id>=0 && o.id<(int)res.size()) ? res[o.id] : ObjDensity{};
+        gGov.setDensity(o.id, d.pixels ? d.coverage : 0.f, d.requiredMip, d.finestMip);
+    }
+    if(!gVolume.loaded()) return;
+    // Bricks blend with GL_MAX, so a brick behind another still shows; the metric only credits
+    // the one drawn last. Coverage is the projected box; mips come from the metric where it saw
+    // the brick, else level 0 (an occluded brick keeps what its bias allows).
+    int px,py,pw,ph; volumePane(fbW,fbH, px,py,pw,ph);
+    for(const auto& k : gVolume.bricks){
+        ObjDensity d = k.id<(int)res.size() ? res[k.id] : ObjDensity{};
+        float cov = gVolumeShown ? gVolumeRenderer.brickArea(gVolume, k, px,py,pw,ph) / ((float)fbW*fbH) : 0.f;
+        gGov.setDensity(k.id, cov, d.pixels ? d.requiredMip : 0.f, d.pixels ? d.finestMip : 0.f);
     }
 }
 
@@ -337,31 +572,83 @@ static void keyCB(GLFWwindow*, int key,int, int action,int mods){
     if(action!=GLFW_PRESS && action!=GLFW_REPEAT) return;
     switch(key){
         case GLFW_KEY_ESCAPE: gRunning=false; break;
-        case GLFW_KEY_B: {
-            Pad P = createCommittedPad();
-            gPads.push_back(P);
-            gTel.padBlocks = (int)gPads.size();
-            glFinish();
-            gWatch.onAllocCheck();
-            std::printf("[Pad] +256MB pad=%d\n",(int)gPads.size());
-        } break;
+        case GLFW_KEY_B:
+            // Committed (cleared + mipped) on the resource thread; the fence replaces the old glFinish
+            gAdmit.request(padMB(), Priority::Normal, glfwGetTime(), []{
+                createCommittedPad([](GLuint tex){
+                    gPads.push_back({tex});
+                    gWatch.onAllocCheck();
+                    std::printf("[Pad] +%.0fMB pad=%d\n", padMB(), (int)gPads.size());
+                });
+            }, "pad");
+            break;
         case GLFW_KEY_R: {
             for(auto& P: gPads) destroyPad(P);
-            gPads.clear(); gTel.padBlocks=0;
-            for(auto& o : gGov.objects) o.bias = 0.f;
+            gPads.clear();
+            gAdmit.clear();
+            gGov.resetBiases();
             std::printf("[Reset] pads cleared; biases reset.\n");
         } break;
         case GLFW_KEY_C:
             gTel.useTelemetry = !gTel.useTelemetry;
             std::printf("[Toggle] useTelemetry=%s\n", gTel.useTelemetry?"true":"false");
             break;
+        case GLFW_KEY_M:
+            gGov.residency = gGov.residency==ResidencyMode::MipTail ? ResidencyMode::BiasOnly
+                           : gGov.residency==ResidencyMode::BiasOnly && gSparseTextures ? ResidencyMode::Sparse : ResidencyMode::MipTail;
+            std::printf("[Toggle] residency=%s\n", gGov.residency==ResidencyMode::MipTail ? "mip-tail"
+                                                  : gGov.residency==ResidencyMode::Sparse ? "sparse" : "bias-only");
+            break;
+        case GLFW_KEY_K:
+            if(std::string(gGov.policy->name())=="knapsack") gGov.policy = std::make_unique<BucketPolicy>();
+            else                                             gGov.policy = std::make_unique<KnapsackPolicy>();
+            std::printf("[Toggle] policy=%s\n", gGov.policy->name());
+            break;
+        case GLFW_KEY_P:
+            gGov.setControl(gGov.control()==ControlMode::Band       ? ControlMode::Predictive
+                          : gGov.control()==ControlMode::Predictive ? ControlMode::PID : ControlMode::Band);
+            std::printf("[Toggle] control=%s\n", controlName(gGov.control()));
+            break;
+        case GLFW_KEY_L: gLedger.print(); if(gGov.domainsEnabled()) gGov.printDomains(); break;
+        case GLFW_KEY_D:
+            gGov.setDomainsEnabled(!gGov.domainsEnabled());
+            std::printf("[Toggle] budget domains=%s\n", gGov.domainsEnabled()?"on":"off");
+            if(gGov.domainsEnabled()) gGov.printDomains();
+            break;
+        case GLFW_KEY_A:
+            gBiasAnim.duration = gBiasAnim.duration > 0.f ? 0.f : 0.2f;
+            gGov.stepBudgetPerTick = gBiasAnim.duration > 0.f ? 32 : 4;
+            std::printf("[Toggle] bias animation=%.2fs, step budget %d\n", gBiasAnim.duration, gGov.stepBudgetPerTick);
+            break;
+        case GLFW_KEY_V:
+            if(!gVolume.loaded()) break;
+            gVolumeShown = !gVolumeShown;
+            for(const auto& k : gVolume.bricks) gGov.setVisible(k.id, gVolumeShown);
+            std::printf("[Toggle] volume=%s\n", gVolumeShown?"shown":"hidden");
+            break;
+        case GLFW_KEY_O:
+            gGov.setRoiEnabled(!gGov.roiEnabled());
+            std::printf("[Toggle] ROI=%s (floor %.1f outside, weight x%.0f inside)\n",
+                gGov.roiEnabled()?"on":"off", gGov.roiFloor, gGov.roiWeight);
+            break;
+        case GLFW_KEY_T: {
+            static int captures = 0;
+            if(!gTrace.enabled()){ gTrace.start(); std::printf("[Trace] capturing...\n"); break; }
+            gTrace.stop();
+            char path[64]; std::snprintf(path, sizeof(path), "trace_%03d.json", captures++);
+            gTrace.writeChrome(path);
+        } break;
+        case GLFW_KEY_G:
+            gGov.gpuBudgetMs = gGov.gpuBudgetMs==0.0 ? 4.0 : gGov.gpuBudgetMs>=16.0 ? 0.0 : gGov.gpuBudgetMs*2.0;
+            std::printf("[Toggle] gpu budget=%.0f ms%s\n", gGov.gpuBudgetMs, gGov.gpuBudgetMs==0.0?" (off)":"");
+            break;
         case GLFW_KEY_LEFT_BRACKET:  gGov.nudge(-0.125f); break;
         case GLFW_KEY_RIGHT_BRACKET: gGov.nudge(+0.125f); break;
         default:
             if((mods & GLFW_MOD_SHIFT) && key==GLFW_KEY_B){
                 if(!gPads.empty()){
-                    destroyPad(gPads.back()); gPads.pop_back(); gTel.padBlocks=(int)gPads.size();
-                    std::printf("[Pad] -256MB pad=%d\n",(int)gPads.size());
+                    destroyPad(gPads.back()); gPads.pop_back();
+                    std::printf("[Pad] -%.0fMB pad=%d\n", padMB(), (int)gPads.size());
                 }
             }
         break;
@@ -369,7 +656,31 @@ static void keyCB(GLFWwindow*, int key,int, int action,int mods){
 }
 
 // =================== Main ===================
-int main(){
+int main(int argc, char** argv){
+    for(int i=1;i<argc;++i){
+        std::string a = argv[i];
+        if(a=="--bake" && i+1<argc){
+            // Offline bake: no window, no GL. Output lands where the app will look for it.
+            CacheFormat f = CacheFormat::BC7;
+            const char* image = argv[++i];
+            if(i+1<argc && parseCacheFormat(argv[i+1], f)) ++i;
+            std::string out = cachePathFor(std::filesystem::path(image).stem().string(), f);
+            return bakeImageCache(image, out, f) ? 0 : 1;
+        }
+        if(a.rfind("--cache=",0)==0){
+            std::string v = a.substr(8);
+            if(v=="off") gUseCache = false;
+            else if(parseCacheFormat(v.c_str(), gCacheFmt)) gCacheFmtForced = true;
+            else std::fprintf(stderr,"unknown cache format '%s'\n", v.c_str());
+        }
+        if(a=="--sparse=off") gNoSparse = true;
+        if(a.rfind("--volume=",0)==0) gVolumeSource = a.substr(9);
+        if(a.rfind("--slice-spacing=",0)==0) gSliceSpacing = std::max(0.01f, (float)std::atof(a.c_str()+16));
+        if(a=="--volume-format=r16f") gVolumeFormat = GL_R16F;
+        if(a=="--profile=off") gUseProfile = false;
+        if(a.rfind("--bias-anim=",0)==0) gBiasAnim.duration = std::max(0.f, (float)std::atof(a.c_str()+12));
+    }
+
     if(!glfwInit()){ std::fprintf(stderr,"GLFW init failed\n"); return 1; }
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,3);
@@ -386,48 +697,120 @@ int main(){
     if(glewInit()!=GLEW_OK){ std::fprintf(stderr,"GLEW init failed\n"); return 1; }
 
     std::printf("Vendor  : %s\n", (const char*)glGetString(GL_VENDOR));
-    std::printf("Renderer: %s\n", (const char*)glGetString(GL_RENDERER));
+    std::string renderer = (const char*)glGetString(GL_RENDERER);
+    std::printf("Renderer: %s\n", renderer.c_str());
     std::printf("Version : %s\n", (const char*)glGetString(GL_VERSION));
 
     glfwSetKeyCallback(win, keyCB);
 
     // GL geometry
     glGenBuffers(1,&gVBO); glBindBuffer(GL_ARRAY_BUFFER,gVBO);
-    glBufferData(GL_ARRAY_BUFFER,sizeof(QUAD),QUAD,GL_STATIC_DRAW);
+    trackedBufferData(MemTag::Geometry, GL_ARRAY_BUFFER, gVBO, sizeof(QUAD), QUAD, GL_STATIC_DRAW);
     glGenVertexArrays(1,&gVAO); glBindVertexArray(gVAO);
     glEnableVertexAttribArray(0); glVertexAttribPointer(0,2,GL_FLOAT,GL_FALSE,sizeof(float)*4,(void*)0);
     glEnableVertexAttribArray(1); glVertexAttribPointer(1,2,GL_FLOAT,GL_FALSE,sizeof(float)*4,(void*)(sizeof(float)*2));
     glBindVertexArray(0); glBindBuffer(GL_ARRAY_BUFFER,0);
 
-    GLuint vs=compile(GL_VERTEX_SHADER,VS), fs=compile(GL_FRAGMENT_SHADER,FS);
-    gProg=link(vs,fs); glDeleteShader(vs); glDeleteShader(fs);
-
-    gTex = makeCheckerTex(2048,2048);
-
-    // Telemetry init + seed fallback baseline
-    gTel.init();
-    GLint kbTotal=0; glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &kbTotal);
-    if(glGetError()==GL_NO_ERROR && kbTotal>0) gTel.fallbackBaseFreeMB = (kbTotal/1024)*9/10;
-    else gTel.fallbackBaseFreeMB = 6000;
+    std::string vsInst = std::string("#version 330 core\n") + kBiasAnimGLSL + VS_INST;
+    GLuint vsi=compile(GL_VERTEX_SHADER,vsInst.c_str()), fs=compile(GL_FRAGMENT_SHADER,FS);
+    gProg=link(vsi,fs); glDeleteShader(vsi); glDeleteShader(fs);
+    initBatchedDraw();
+    gBiasAnim.init(glfwGetTime());
+    GLuint vs=compile(GL_VERTEX_SHADER,VS);
+    GLuint dfs=compile(GL_FRAGMENT_SHADER,kDensityFS);
+    GLuint densityProg=link(vs,dfs); glDeleteShader(vs); glDeleteShader(dfs);
+    gDensity.init(densityProg);
+    gVolumeRenderer.init(compile, link);
+
+    // Governor library: telemetry (fallback seeded from the NVX total), async uploads (object
+    // textures and streamed-in mips arrive over the next frames), decode pool, resource thread
+    VgConfig cfg;
+    cfg.gpuBudgetMs = 8.0;
+    cfg.verbose = true;
+    cfg.resourceShare = win;
+    gVg.init(cfg);
+    gVg.holdRelease = holdForBiasAnim;
+    gVg.onSync = syncVolume;
+    pickCacheFormat();
+    gGridTimer.init(); gMetricTimer.init();
+    gGpuTrace.init();
+    gTrace.setThreadName("render");
+    gGov.stepBudgetPerTick = gBiasAnim.duration > 0.f ? 32 : 4;     // smoothing is the GPU's job now
+    gSparseTextures = gTel.sparse && !gNoSparse;
+    if(gSparseTextures) gGov.residency = ResidencyMode::Sparse;
 
     // --------- Build Day 6 object set (3x2 grid) ---------
-    // Two of each priority; different estMB (so largest-first has effect).
-    auto addObj = [&](int id, Priority pr, int gx,int gy, float estMB){
-        GovObject o; o.id=id; o.priority=pr; o.bias=0.f; o.biasMin=0.f; o.biasMax=8.f;
-        o.visible=true; o.estMB=estMB; o.gridX=gx; o.gridY=gy; gGov.objects.push_back(o);
+    // Two of each priority; different texture sizes (so largest-first has effect).
+    struct ObjSpec { Priority pr; int gx,gy; float scale; int texW,texH; const char* image; };
+    static const ObjSpec kObjSpecs[] = {
+        // Row 0 (bottom): Low, Low, Normal
+        { Priority::Low,    0,0, 1.00f, 2048,2048, nullptr },
+        { Priority::Low,    1,0, 0.40f, 2048,1024, nullptr },
+        { Priority::Normal, 2,0, 0.70f, 2048,2048, nullptr },
+        // Row 1 (top): Normal, High, High
+        { Priority::Normal, 0,1, 0.25f, 1024,1024, nullptr },
+        { Priority::High,   1,1, 1.00f, 4096,4096, nullptr }, // "main" (largest)
+        { Priority::High,   2,1, 0.60f, 1024,1024, "assets/checker.png" },
     };
-    // Row 0 (bottom): Low, Low, Normal
-    addObj(0, Priority::Low,    0,0, 200.f);
-    addObj(1, Priority::Low,    1,0, 150.f);
-    addObj(2, Priority::Normal, 2,0, 180.f);
-    // Row 1 (top): Normal, High, High
-    addObj(3, Priority::Normal, 0,1, 120.f);
-    addObj(4, Priority::High,   1,1, 220.f); // "main" (largest est)
-    addObj(5, Priority::High,   2,1, 100.f);
+    const int kObjCount = (int)(sizeof(kObjSpecs)/sizeof(kObjSpecs[0]));
+
+    // The volume's CPU side comes first: its brick count is part of the profile's shape.
+    VolumeData volumeData;
+    bool haveVolume = gVolumeSource!="off" &&
+        (gVolumeSource=="phantom" ? (volumeData = makeVolumePhantom(), true) : loadSliceStack(gVolumeSource, volumeData, gSliceSpacing));
+
+    // Warm start: the scene id covers everything an object id or a level number depends on,
+    // including the residency mode (M changes it mid-session, so the save rebuilds the id).
+    std::string sceneObjs;
+    for(const ObjSpec& s : kObjSpecs) sceneObjs += " " + std::to_string(s.texW) + "x" + std::to_string(s.texH) + (s.image ? std::string(":") + s.image : "");
+    if(haveVolume) sceneObjs += " volume=" + gVolumeSource + ":" + std::to_string(volumeData.w) + "x" + std::to_string(volumeData.h) + "x" + std::to_string(volumeData.d)
+                              + (gVolumeFormat==GL_R16F ? ":r16f" : ":r16");
+    auto sceneId = [&](ResidencyMode m){ return std::string("day6 residency=") + (m==ResidencyMode::Sparse ? "sparse" : "mip-tail") + sceneObjs; };
+    GovProfile profile;
+    bool warm = gUseProfile && loadProfile(renderer, sceneId(gGov.residency), (size_t)kObjCount + (haveVolume ? brickCount(volumeData) : 0), profile);
+
+    for(const ObjSpec& s : kObjSpecs){
+        GovObject o; o.id=gGov.add(s.pr, 0.f, 8.f); o.gridX=s.gx; o.gridY=s.gy; o.screenScale=s.scale;
+        gVg.adoptTexture(o.id, makeGovernedTex(s.image, s.texW, s.texH, (int)s.pr, warm ? profile.topFor(o.id, s.image ? 0 : mipLevelsFor(s.texW, s.texH)) : 0));
+        if(warm) gGov.setBias(o.id, profile.biasFor(o.id));
+        gObjects.push_back(std::move(o));
+    }
+
+    // Budget domains: global -> view (grid column) -> group (row within it). Off until D.
+    static const char* kViewNames[]  = { "view 0", "view 1", "view 2" };
+    static const char* kGroupNames[] = { "view 0/row 0", "view 0/row 1", "view 1/row 0", "view 1/row 1", "view 2/row 0", "view 2/row 1" };
+    for(int v=0; v<3; ++v){
+        int view = gGov.addDomain(kViewNames[v]);
+        for(int r=0; r<2; ++r){
+            int group = gGov.addDomain(kGroupNames[2*v+r], view, r==1 ? 2.f : 1.f);   // top row carries the main image
+            for(auto& o : gObjects) if(o.gridX==v && o.gridY==r) gGov.setDomain(o.id, group);
+        }
+    }
+
+    // Volume column: one Normal object per brick, each level 1/8 of the one above.
+    if(haveVolume){
+        createGovVolume(gVolume, std::move(volumeData), gVolumeFormat, 64,
+                        [&](int b){ return warm ? profile.topFor(kObjCount + b, 0) : 0; });
+        int volDomain = gGov.addDomain("volume");
+        for(auto& k : gVolume.bricks){
+            k.id = gGov.add(Priority::Normal, 0.f, (float)(gVolume.levels-1));
+            gGov.setLevelShrink(k.id, 8.f);
+            gGov.setDomain(k.id, volDomain);
+            gGov.setFootprint(k.id, (float)(k.bytes/(1024.0*1024.0)), k.level, gVolume.levels);
+            if(warm) gGov.setBias(k.id, profile.biasFor(k.id));
+        }
+    }
+    if(warm){ gGov.setControl(profile.control); gGov.setPidIntegral(profile.pidIntegral); }
+    gGov.setDomainsEnabled(false);
 
-    std::puts("Hotkeys: B (+256MB), Shift+B (-256MB), [ / ] nudge, R reset, C toggle telemetry");
+    std::puts("Hotkeys: B (+pad), Shift+B (-pad), [ / ] nudge, R reset, C toggle telemetry, M residency mode, K policy, P controller, L ledger, G gpu budget, T trace, O roi, D domains, V volume, A bias anim");
+    gLedger.print();
 
+    uint64_t frame=0;
+    double lastTitle=0.0;
     while(!glfwWindowShouldClose(win) && gRunning){
+        VG_ZONE("frame");
+        gGpuTrace.collect();
         glfwPollEvents();
         int W,H; glfwGetFramebufferSize(win,&W,&H);
         glViewport(0,0,W,H);
@@ -435,28 +818,61 @@ int main(){
         glClearColor(0.10f,0.11f,0.13f,1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        auto [valid, freeMB] = gTel.readFreeMB();
         double t = glfwGetTime();
-        gGov.evaluate(t, freeMB, valid);
-
+        if(gGov.roiEnabled()) updateRoi(win, W, H);
+        const VgFrameStats& st = gVg.frame(t, gGridTimer.avgMs());
+        bool valid = st.telemetryValid; int freeMB = st.freeMB;
+        double govUs = st.governorUs;
+        VG_COUNTER("freeMB", freeMB);
+        VG_COUNTER("pendingMB", gGov.pendingMB());
+        VG_COUNTER("residentMB", gGov.residentMB());
+
+        gGridTimer.begin();
         drawObjectsGrid(W,H);
+        drawVolume(W,H);
+        gGridTimer.end();
+        sampleDensity(++frame, W,H);
+
+        // HUD (a few times a second; the title string is not free)
+        if(t - lastTitle >= 0.25){
+            VG_ZONE("hud");
+            lastTitle = t;
+            char title[448];
+            auto &o0=gObjects[0], &o4=gObjects[4];
+            std::snprintf(title,sizeof(title),
+                "Day6 | freeMB=%d [%s] | objs=%zu | sample biases: L0=%.2f  H4=%.2f  H5=%.2f | top mip L0/H4=%d/%d | up=%zuKB | pads=%zu (+%d creating, %zu waiting) retiring=%zu | vol=%.0fMB | bias writes=%d | gpu grid/metric=%.2f/%.2fms gov=%.0fus",
+                freeMB, valid?telModeName(gTel.mode):"fallback",
+                gObjects.size(), gGov.bias(0), gGov.bias(4), gGov.bias(5), gVg.govTexture(o0.id).residentTop, gVg.govTexture(o4.id).residentTop,
+                gUploads.bytesIssuedLastFrame()>>10, gPads.size(), gPadsCreating, gAdmit.waiting(), gRetire.queuedCount(), gVolume.residentMB(), gBiasAnim.takeUploads(),
+                gGridTimer.avgMs(), gMetricTimer.avgMs(), govUs);
+            glfwSetWindowTitle(win, title);
+        }
 
-        // HUD
-        char title[256];
-        auto &o0=gGov.objects[0], &o4=gGov.objects[4], &o5=gGov.objects[5];
-        std::snprintf(title,sizeof(title),
-            "Day6 | freeMB=%d [%s] | objs=%zu | sample biases: L0=%.2f  H4=%.2f  H5=%.2f | pads=%zu",
-            freeMB, valid?"telemetry":"fallback",
-            gGov.objects.size(), o0.bias, o4.bias, o5.bias, gPads.size());
-        glfwSetWindowTitle(win, title);
-
+        VG_ZONE("swap");
         glfwSwapBuffers(win);
     }
 
+    // Pads are test pressure, not the scene: a session that ends with pads keeps the old profile.
+    // So does one that ends in bias-only mode, where resident levels don't follow the biases.
+    if(gUseProfile && gPads.empty() && gPadsCreating==0 && gGov.residency!=ResidencyMode::BiasOnly){
+        GovProfile out; out.renderer = renderer; out.scene = sceneId(gGov.residency);
+        out.control = gGov.control(); out.pidIntegral = gGov.pidIntegral();
+        for(const auto& o : gObjects){ const GovTexture& T = gVg.govTexture(o.id); out.objs.push_back({ gGov.bias(o.id), T.residentTop, T.levels }); }
+        for(const auto& k : gVolume.bricks) out.objs.push_back({ gGov.bias(k.id), k.level, gVolume.levels });
+        saveProfile(out);
+    }
     for(auto& P: gPads) destroyPad(P);
-    glDeleteTextures(1,&gTex);
+    gGridTimer.shutdown(); gMetricTimer.shutdown();
+    gGpuTrace.shutdown();
+    destroyGovVolume(gVolume);
+    gVg.shutdown();         // telemetry, decode, uploads, the objects' textures, retirement drain, resource thread
+    destroyBatchedDraw();
     glDeleteVertexArrays(1,&gVAO);
-    glDeleteBuffers(1,&gVBO);
+    trackedDeleteBuffers(1,&gVBO);
+    gDensity.shutdown();
+    gVolumeRenderer.shutdown();
+    gBiasAnim.shutdown();
+    glDeleteProgram(densityProg);
     glDeleteProgram(gProg);
     glfwDestroyWindow(win);
     glfwTerminate();
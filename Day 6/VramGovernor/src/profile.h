@@ -0,0 +1,82 @@
+// Profile — learned governor state per GPU and scene, for a warm start
+// - Keyed by the GL renderer string and a scene id supplied by the app (its object set)
+// - save() records, per object, the bias and resident top level it ended at, plus the
+//   controller mode and PID integral; load() reads them back before any texture is created
+// - The app creates textures at the profiled top level (nothing is uploaded only to be thrown
+//   away) and seeds the governor with the biases, so a heavy scene starts converged instead
+//   of overshooting from bias 0
+// - Plain text under profiles/, one object per line; a profile whose renderer, scene or object
+//   count doesn't match is ignored
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "governor.h"
+#include "texcache.h"
+
+struct GovProfile {
+    struct Obj { float bias = 0.f; int top = 0, levels = 0; };
+    std::string renderer, scene;
+    ControlMode control = ControlMode::Band;
+    double pidIntegral = 0.0;
+    std::vector<Obj> objs;
+
+    // Top level to create object i at (0 without a profile, or if its chain has changed).
+    int topFor(int i, int levels) const {
+        return i < (int)objs.size() && (levels <= 0 || objs[i].levels == levels) ? objs[i].top : 0;
+    }
+    float biasFor(int i) const { return i < (int)objs.size() ? objs[i].bias : 0.f; }
+};
+
+inline std::string gProfileDir = "profiles";
+inline std::string profilePathFor(const std::string& renderer, const std::string& scene){
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)sourceKey(renderer + "|" + scene));
+    return gProfileDir + "/" + name + ".vgp";
+}
+
+inline bool loadProfile(const std::string& renderer, const std::string& scene, size_t objects, GovProfile& P){
+    std::string path = profilePathFor(renderer, scene);
+    FILE* f = std::fopen(path.c_str(), "r");
+    if(!f) return false;
+    P = GovProfile{};
+    char line[512];
+    int version = 0, control = 0;
+    bool ok = std::fgets(line, sizeof(line), f) && std::sscanf(line, "vgprofile %d", &version)==1 && version==1;
+    while(ok && std::fgets(line, sizeof(line), f)){
+        std::string s(line);
+        while(!s.empty() && (s.back()=='\n' || s.back()=='\r')) s.pop_back();
+        GovProfile::Obj o;
+        if(s.rfind("renderer ",0)==0) P.renderer = s.substr(9);
+        else if(s.rfind("scene ",0)==0) P.scene = s.substr(6);
+        else if(std::sscanf(line, "control %d %lf", &control, &P.pidIntegral)==2) P.control = (ControlMode)control;
+        else if(std::sscanf(line, "obj %f %d %d", &o.bias, &o.top, &o.levels)==3) P.objs.push_back(o);
+    }
+    std::fclose(f);
+    if(!ok || P.renderer!=renderer || P.scene!=scene || P.objs.size()!=objects){
+        std::printf("[Profile] %s does not match this scene, cold start\n", path.c_str());
+        return false;
+    }
+    std::printf("[Profile] warm start from %s (%zu objects, control=%s)\n", path.c_str(), P.objs.size(), controlName(P.control));
+    return true;
+}
+
+inline bool saveProfile(const GovProfile& P){
+    std::error_code ec;
+    std::filesystem::create_directories(gProfileDir, ec);
+    std::string path = profilePathFor(P.renderer, P.scene), tmp = path + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "w");
+    if(!f){ std::fprintf(stderr,"[Profile] cannot write %s\n", tmp.c_str()); return false; }
+    std::fprintf(f, "vgprofile 1\nrenderer %s\nscene %s\ncontrol %d %.6f\n",
+        P.renderer.c_str(), P.scene.c_str(), (int)P.control, P.pidIntegral);
+    for(const auto& o : P.objs) std::fprintf(f, "obj %.4f %d %d\n", o.bias, o.top, o.levels);
+    bool ok = std::fclose(f)==0;
+    std::filesystem::rename(tmp, path, ec);     // whole file or nothing
+    if(!ok || ec){ std::fprintf(stderr,"[Profile] cannot write %s\n", path.c_str()); return false; }
+    std::printf("[Profile] saved %s (%zu objects)\n", path.c_str(), P.objs.size());
+    return true;
+}
@@ -0,0 +1,554 @@
+// Residency — mip-tail eviction for governed textures
+// - A GovTexture remembers its full-resolution shape but only keeps levels [residentTop .. levels-1]
+// - Dropping top mips re-creates immutable storage from the already-resident lower levels (GPU copy)
+// - Streaming top mips back in regenerates them from the texture's LevelSource, through the
+//   async upload queue when it is running (levels become sampleable via GL_TEXTURE_BASE_LEVEL)
+// - Image-backed textures are decoded off-thread by gDecode at the owner's priority
+// - Cache-backed textures (texcache.h) upload straight from the mapped file, BC1/BC7 or RGBA8
+// - Storage comes from a TexturePool that recycles texture objects of identical shape/format;
+//   every texture is created through the ledger (tagged governed while in use, pool while parked)
+// - Released storage is retired, not freed: it waits for a fence on the frame that released it
+//   and then goes back to the pool or is deleted, a few objects per frame
+// - With ARB_sparse_texture, procedural and cache-backed textures are sparse instead: the full
+//   chain is virtual and residency is page commitment per level, down to page rows of the finest
+//   level (fine-grained MB instead of 4x jumps). The sampler is kept inside committed pages by
+//   the draw shader; stream-in of sparse rows is synchronous
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <deque>
+#include <memory>
+
+#include <GL/glew.h>
+
+#include "upload.h"
+#include "resource_thread.h"
+#include "decode_pool.h"
+#include "texcache.h"
+#include "ledger.h"
+
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+
+// Produces RGBA8 pixels for one level of the *full* chain (level 0 = full resolution).
+// Must be safe to call from the upload worker thread.
+using LevelSource = std::function<std::vector<uint8_t>(int level, int w, int h)>;
+
+// Streaming progress, shared with in-flight upload callbacks (render thread only).
+struct StreamState {
+    GLuint tex = 0;         // storage the callbacks belong to (stale callbacks are ignored)
+    int    top = 0;         // full-chain level stored at level 0 of `tex`
+    int    loadedTop = 0;   // finest full-chain level whose data has been submitted
+    std::atomic<uint64_t> gen{0};   // bumped on every reallocation; stale decodes are dropped
+};
+
+// Route stream-in through gUploads (set once the queue is initialised).
+inline bool gAsyncUploads = false;
+inline int  gSyncTailEdge = 64;     // levels this small are always uploaded synchronously
+
+struct GovTexture {
+    GLuint      tex = 0;
+    GLenum      format = GL_RGBA8;
+    int         baseW = 0, baseH = 0;   // level 0 of the full chain
+    int         levels = 1;             // full chain length
+    int         residentTop = 0;        // finest level currently resident
+    LevelSource source;
+    std::string imagePath;      // non-empty: levels come from this file through gDecode
+    std::shared_ptr<MappedTexCache> cache;  // set: levels come from this mapped .vtc file
+    int         priority = 1;   // decode priority (the owning GovObject's Priority)
+    std::shared_ptr<StreamState> stream = std::make_shared<StreamState>();
+    // Sparse: storage always holds the full chain; pages are committed per level
+    bool        sparse = false;
+    int         pageW = 0, pageH = 0;       // virtual page size for `format`
+    int         tailFirst = 0;              // first level of the mip tail (committed as one unit)
+    std::vector<int> committedRows;         // page rows committed per level below tailFirst
+    size_t      committedBytes = 0;
+    std::vector<uint8_t> rowsPix;           // procedural source: the partly committed level, generated once
+    int         rowsLevel = -1;             // level rowsPix holds (-1: none)
+
+    int  loadedTop() const { return stream->loadedTop; }
+    int  storageTop() const { return sparse ? 0 : residentTop; }   // full-chain level at storage level 0
+    int  levelW(int l) const { return std::max(1, baseW >> l); }
+    int  levelH(int l) const { return std::max(1, baseH >> l); }
+    int  residentLevels() const { return levels - residentTop; }
+};
+
+inline int mipLevelsFor(int w, int h){
+    return 1 + (int)std::floor(std::log2((double)std::max(w,h)));
+}
+
+// ---------- Footprint ----------
+// (format sizes live in ledger.h)
+// Bytes held by levels [top .. levels-1].
+inline size_t residentBytes(const GovTexture& T, int top){
+    size_t b=0;
+    for(int l=top; l<T.levels; ++l) b += levelBytes(T.format, T.levelW(l), T.levelH(l));
+    return b;
+}
+inline size_t residentBytes(const GovTexture& T){ return T.sparse ? T.committedBytes : residentBytes(T, T.residentTop); }
+inline float  residentMB(const GovTexture& T){ return (float)(residentBytes(T)/(1024.0*1024.0)); }
+
+// =================== Texture pool ===================
+// Immutable storage can't be re-specified, so a resize normally means glGenTextures +
+// glDeleteTextures. The pool keeps released textures keyed by exact shape and hands them
+// back to the next request of that shape. Pooled textures still hold VRAM, so the pool
+// is capped and the app trims it to zero while the governor is under pressure.
+struct TexShape {
+    GLenum format=GL_RGBA8; int w=0, h=0, levels=0;
+    bool operator==(const TexShape& o) const { return format==o.format && w==o.w && h==o.h && levels==o.levels; }
+    size_t bytes() const { return chainBytes(format, w, h, levels); }
+};
+
+struct TexturePool {
+    struct Entry { GLuint tex; TexShape shape; };
+    std::deque<Entry> free;     // oldest first
+    size_t pooledBytes = 0;
+    size_t maxBytes    = 64ull<<20;
+    int    hits=0, misses=0;
+
+    GLuint acquire(const TexShape& s){
+        for(auto it=free.begin(); it!=free.end(); ++it){
+            if(it->shape==s){
+                GLuint t=it->tex; pooledBytes-=s.bytes(); free.erase(it); ++hits;
+                gLedger.retag(LedgerKind::Texture, t, MemTag::Governed);
+                return t;
+            }
+        }
+        ++misses;
+        return trackedTexStorage2D(MemTag::Governed, s.levels, s.format, s.w, s.h);
+    }
+    void release(GLuint t, const TexShape& s){
+        if(!t) return;
+        free.push_back({t,s}); pooledBytes+=s.bytes();
+        gLedger.retag(LedgerKind::Texture, t, MemTag::Pool);
+        trimTo(maxBytes);
+    }
+    void trimTo(size_t bytes){
+        while(pooledBytes>bytes && !free.empty()){
+            Entry e=free.front(); free.pop_front();
+            pooledBytes-=e.shape.bytes();
+            releaseTexture(e.tex);
+        }
+    }
+};
+inline TexturePool gTexPool;
+
+// ---------- Deferred release ----------
+// Draws still in flight may sample storage the render thread has just let go of, and a mass
+// delete inside one frame stalls the driver. Retired textures wait for a fence on the frame
+// that retired them (pump() fences the previous frame's batch), then are recycled into the
+// pool or deleted on the resource thread, at most maxPerFrame / bytesPerFrame per frame.
+// Until then they sit in the ledger as "retiring" and in queuedBytes(); `onFreed` reports
+// what was actually given back.
+struct RetireQueue {
+    int    maxPerFrame   = 2;
+    size_t bytesPerFrame = 512ull<<20;      // the first object of a frame always goes
+    bool   recycle       = true;            // false under pressure: poolable storage is deleted too
+    std::function<void(size_t bytes)> onFreed;
+
+    // `poolable`: hand it back to gTexPool as `shape` instead of deleting it.
+    void retire(GLuint t, size_t bytes, bool poolable=false, TexShape shape={}){
+        if(!t) return;
+        gLedger.retag(LedgerKind::Texture, t, MemTag::Retiring);
+        open_.push_back({t, bytes, poolable, shape});
+        queued_ += bytes; ++count_;
+    }
+    size_t queuedBytes() const { return queued_; }
+    size_t queuedCount() const { return count_; }
+
+    // Render thread, once per frame.
+    void pump(){
+        if(!open_.empty()){ batches_.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), std::move(open_), 0}); open_.clear(); }
+        int n=0; size_t bytes=0, freed=0;
+        while(!batches_.empty()){
+            Batch& b = batches_.front();
+            if(b.fence){
+                GLenum st = glClientWaitSync(b.fence, 0, 0);
+                if(st!=GL_ALREADY_SIGNALED && st!=GL_CONDITION_SATISFIED) break;
+                glDeleteSync(b.fence); b.fence=nullptr;
+            }
+            for(; b.next<b.items.size(); ++b.next){
+                const Item& it = b.items[b.next];
+                if(n>=maxPerFrame || (n>0 && bytes + it.bytes > bytesPerFrame)) break;
+                ++n; bytes += it.bytes;
+                freed += give(it);
+            }
+            if(b.next < b.items.size()) break;
+            batches_.pop_front();
+        }
+        if(freed && onFreed) onFreed(freed);
+    }
+
+    // Shutdown: wait for the GPU once and let everything go (nothing is pooled).
+    void drain(){
+        recycle = false;
+        glFinish();
+        for(auto& b : batches_){
+            if(b.fence) glDeleteSync(b.fence);
+            for(; b.next<b.items.size(); ++b.next) give(b.items[b.next]);
+        }
+        for(const auto& it : open_) give(it);
+        batches_.clear(); open_.clear();
+    }
+
+private:
+    struct Item  { GLuint tex; size_t bytes; bool poolable; TexShape shape; };
+    struct Batch { GLsync fence; std::vector<Item> items; size_t next; };
+
+    // Returns the bytes actually freed.
+    size_t give(const Item& it){
+        queued_ -= it.bytes; --count_;
+        if(it.poolable && recycle){ gTexPool.release(it.tex, it.shape); return 0; }
+        releaseTexture(it.tex);
+        return it.bytes;
+    }
+
+    std::vector<Item> open_;                // retired this frame, not fenced yet
+    std::deque<Batch> batches_;
+    size_t queued_=0, count_=0;
+};
+inline RetireQueue gRetire;
+
+inline TexShape shapeFor(const GovTexture& T, int top){
+    return { T.format, T.levelW(top), T.levelH(top), T.levels-top };
+}
+
+// ---------- Storage helpers ----------
+inline GLuint allocStorage(const GovTexture& T, int top){
+    GLuint t = gTexPool.acquire(shapeFor(T, top));
+    glBindTexture(GL_TEXTURE_2D,t);
+    int n = T.levels - top;
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_BASE_LEVEL,0);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAX_LEVEL,n-1);
+    return t;
+}
+
+inline void uploadLevel(const GovTexture& T, GLuint dst, int fullLevel, int dstLevel){
+    int w=T.levelW(fullLevel), h=T.levelH(fullLevel);
+    if(T.cache){
+        glBindTexture(GL_TEXTURE_2D, dst);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        const VtcLevel& L = T.cache->level(fullLevel);
+        if(isCompressed(T.format))
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, dstLevel, 0,0, w,h, T.format, (GLsizei)L.size, T.cache->data(fullLevel));
+        else
+            glTexSubImage2D(GL_TEXTURE_2D, dstLevel, 0,0, w,h, GL_RGBA, GL_UNSIGNED_BYTE, T.cache->data(fullLevel));
+        return;
+    }
+    auto pix = T.source(fullLevel, w, h);
+    glBindTexture(GL_TEXTURE_2D, dst);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, dstLevel, 0,0, w,h, GL_RGBA, GL_UNSIGNED_BYTE, pix.data());
+}
+
+inline UploadJob::Callback levelLanded(const std::shared_ptr<StreamState>& st, GLuint tex, int l){
+    return [st, tex, l]{
+        if(st->tex!=tex || l>=st->loadedTop) return;
+        st->loadedTop = l;
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, l - st->top);
+    };
+}
+
+// Image-backed fill: decode [from .. to) on the pool, then queue the uploads coarsest first.
+inline void fillLevelsFromImage(GovTexture& T, int from, int to){
+    auto st = T.stream;
+    if(st->loadedTop >= T.levels){         // nothing to sample yet: seed the 1x1 tail with grey
+        const uint8_t grey[4]={128,128,128,255};
+        glBindTexture(GL_TEXTURE_2D, T.tex);
+        glTexSubImage2D(GL_TEXTURE_2D, T.levels-1-T.storageTop(), 0,0,1,1, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, T.levels-1-T.storageTop());
+    } else {
+        glBindTexture(GL_TEXTURE_2D, T.tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, st->loadedTop - T.storageTop());
+    }
+    DecodeRequest rq;
+    rq.path = T.imagePath; rq.mipFrom = from; rq.mipTo = to; rq.priority = T.priority;
+    uint64_t gen = st->gen.load();
+    rq.stillWanted = [st, gen]{ return st->gen.load()==gen; };
+    rq.done = [st, gen, tex=T.tex, top=T.storageTop(), bpp=(int)bytesPerTexel(T.format)]
+              (bool ok, std::vector<DecodedLevel>&& levels){
+        if(!ok) return;
+        for(auto it=levels.rbegin(); it!=levels.rend(); ++it){
+            auto pix = std::make_shared<std::vector<uint8_t>>(std::move(it->rgba));
+            UploadJob J;
+            J.tex=tex; J.level=it->level-top; J.w=it->w; J.h=it->h; J.bytesPerPixel=bpp;
+            J.produce = [pix]{ return std::move(*pix); };
+            J.onIssued = levelLanded(st, tex, it->level);
+            if(!gUploads.submitIfCurrent(std::move(J), st->gen, gen)) return;
+        }
+    };
+    gDecode.submit(std::move(rq));
+}
+
+// Fill full-chain levels [from .. to) of T's current storage, coarsest first. Large levels go
+// through the upload queue; sampling is clamped with BASE_LEVEL until each level has landed.
+inline void fillLevels(GovTexture& T, int from, int to){
+    auto st = T.stream;
+    if(to <= from){ st->loadedTop = std::min(st->loadedTop, from); return; }
+    if(!T.imagePath.empty() && gAsyncUploads && gDecode.running()){ fillLevelsFromImage(T, from, to); return; }
+    int l = to-1;
+    for(; l>=from; --l){
+        bool small = std::max(T.levelW(l), T.levelH(l)) <= gSyncTailEdge;
+        if(gAsyncUploads && !small) break;
+        uploadLevel(T, T.tex, l, l-T.storageTop());
+        st->loadedTop = l;
+    }
+    glBindTexture(GL_TEXTURE_2D, T.tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, st->loadedTop - T.storageTop());
+    for(; l>=from; --l){
+        UploadJob J;
+        J.tex=T.tex; J.level=l-T.storageTop(); J.w=T.levelW(l); J.h=T.levelH(l);
+        J.bytesPerPixel=(int)bytesPerTexel(T.format);
+        if(T.cache){
+            if(isCompressed(T.format)){ J.compressedFormat=T.format; J.blockBytes=blockBytesFor(T.format); }
+            J.data=T.cache->data(l); J.keepAlive=T.cache;
+        } else {
+            J.produce = [src=T.source, l, w=J.w, h=J.h]{ return src(l,w,h); };
+        }
+        J.onIssued = levelLanded(st, T.tex, l);
+        gUploads.submit(std::move(J));
+    }
+}
+
+// GPU->GPU level copy. ARB_copy_image when present, else a framebuffer blit (GL 3.3 core).
+inline void copyLevel(GLuint src, int srcLevel, GLuint dst, int dstLevel, int w, int h){
+    if(GLEW_ARB_copy_image){
+        glCopyImageSubData(src, GL_TEXTURE_2D, srcLevel, 0,0,0,
+                           dst, GL_TEXTURE_2D, dstLevel, 0,0,0, w,h,1);
+        return;
+    }
+    static GLuint fbo[2]={0,0};
+    if(!fbo[0]) glGenFramebuffers(2,fbo);
+    GLint prevRead=0, prevDraw=0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING,&prevRead);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING,&prevDraw);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo[0]);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, src, srcLevel);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo[1]);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dst, dstLevel);
+    glBlitFramebuffer(0,0,w,h, 0,0,w,h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)prevRead);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)prevDraw);
+}
+
+// =================== Sparse backend ===================
+inline bool gSparseTextures = false;    // ARB_sparse_texture seen by Telemetry::init, and wanted
+
+inline int pageRowsAt(const GovTexture& T, int l){ return (T.levelH(l) + T.pageH-1) / T.pageH; }
+inline size_t pageRowBytes(const GovTexture& T, int l){
+    return (size_t)((T.levelW(l) + T.pageW-1) / T.pageW) * levelBytes(T.format, T.pageW, T.pageH);
+}
+// The tail is committed whole, in pages.
+inline size_t tailBytes(const GovTexture& T){
+    if(T.tailFirst >= T.levels) return 0;
+    size_t page = levelBytes(T.format, T.pageW, T.pageH);
+    size_t b = chainBytes(T.format, T.levelW(T.tailFirst), T.levelH(T.tailFirst), T.levels - T.tailFirst);
+    return (b + page-1) / page * page;
+}
+// Page rows of level `top` that keep `commit` (0..1] of it.
+inline int sparseRowsFor(const GovTexture& T, int top, float commit){
+    if(top >= T.tailFirst) return 0;
+    int n = pageRowsAt(T, top);
+    return std::clamp((int)std::ceil(commit * n), 1, n);
+}
+inline size_t sparseBytes(const GovTexture& T, int top, int rows){
+    size_t b = tailBytes(T);
+    for(int l=std::max(0, top); l<T.tailFirst; ++l) b += (size_t)(l==top ? rows : pageRowsAt(T, l)) * pageRowBytes(T, l);
+    return b;
+}
+// Bytes T would hold with `top` as finest level and `commit` of it paged in (dense: whole levels).
+inline size_t residentBytes(const GovTexture& T, int top, float commit){
+    return T.sparse ? sparseBytes(T, top, sparseRowsFor(T, top, commit)) : residentBytes(T, top);
+}
+// Committed share of the residentTop level: by pages (governor input) and by texel rows (the
+// band of v the draw shader samples it in).
+inline float committedFraction(const GovTexture& T){
+    if(!T.sparse || T.residentTop >= T.tailFirst) return 1.f;
+    return (float)T.committedRows[T.residentTop] / (float)pageRowsAt(T, T.residentTop);
+}
+inline float committedV(const GovTexture& T){
+    if(!T.sparse || T.residentTop >= T.tailFirst) return 1.f;
+    return std::min(1.f, (float)(T.committedRows[T.residentTop] * T.pageH) / (float)T.levelH(T.residentTop));
+}
+
+// Page size for `fmt` when the extension is on and the chain is page aligned.
+inline bool sparsePageSize(GLenum fmt, int w, int h, int& pw, int& ph){
+    if(!gSparseTextures) return false;
+    GLint n=0; glGetInternalformativ(GL_TEXTURE_2D, fmt, GL_NUM_VIRTUAL_PAGE_SIZES_ARB, 1, &n);
+    if(n<=0) return false;
+    glGetInternalformativ(GL_TEXTURE_2D, fmt, GL_VIRTUAL_PAGE_SIZE_X_ARB, 1, &pw);
+    glGetInternalformativ(GL_TEXTURE_2D, fmt, GL_VIRTUAL_PAGE_SIZE_Y_ARB, 1, &ph);
+    return pw>0 && ph>0 && w%pw==0 && h%ph==0;
+}
+
+// Commit or release page rows [r0, r1) of level l of the bound texture (the last row is clipped
+// to the level edge, which the extension allows).
+inline void commitRows(const GovTexture& T, int l, int r0, int r1, bool commit){
+    int y0 = r0*T.pageH, y1 = std::min(T.levelH(l), r1*T.pageH);
+    if(y1 > y0) glTexPageCommitmentARB(GL_TEXTURE_2D, l, 0, y0, 0, T.levelW(l), y1-y0, 1, commit ? GL_TRUE : GL_FALSE);
+}
+
+// Texel rows [y0, y1) of level l into the bound texture. Cache levels are sliced in place;
+// procedural sources produce the whole level once and later bands are cut from that copy
+// (setSparseResidency drops it once the level is complete or no longer the partial one).
+inline void uploadRows(GovTexture& T, int l, int y0, int y1){
+    int w=T.levelW(l), h=T.levelH(l);
+    y1 = std::min(y1, h);
+    if(y1 <= y0) return;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if(T.cache){
+        const uint8_t* base = T.cache->data(l);
+        if(isCompressed(T.format)){
+            size_t rowBytes = (size_t)((w+3)/4) * blockBytesFor(T.format);
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, l, 0,y0, w,y1-y0, T.format,
+                                      (GLsizei)(rowBytes * ((y1-y0+3)/4)), base + (size_t)(y0/4)*rowBytes);
+        } else {
+            glTexSubImage2D(GL_TEXTURE_2D, l, 0,y0, w,y1-y0, GL_RGBA, GL_UNSIGNED_BYTE, base + (size_t)y0*w*4);
+        }
+        return;
+    }
+    if(T.rowsLevel != l){ T.rowsPix = T.source(l, w, h); T.rowsLevel = l; }
+    glTexSubImage2D(GL_TEXTURE_2D, l, 0,y0, w,y1-y0, GL_RGBA, GL_UNSIGNED_BYTE, T.rowsPix.data() + (size_t)y0*w*4);
+}
+
+// Virtual full-chain storage with nothing but the tail committed. False: use dense storage.
+inline bool createSparseStorage(GovTexture& T){
+    int pw=0, ph=0;
+    if(!T.imagePath.empty() || !sparsePageSize(T.format, T.baseW, T.baseH, pw, ph)) return false;
+    glGenTextures(1, &T.tex);
+    glBindTexture(GL_TEXTURE_2D, T.tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+    glTexParameteri(GL_TEXTURE_2D, GL_VIRTUAL_PAGE_SIZE_INDEX_ARB, 0);
+    glTexStorage2D(GL_TEXTURE_2D, T.levels, T.format, T.baseW, T.baseH);
+    GLint tail=0; glGetTexParameteriv(GL_TEXTURE_2D, GL_NUM_SPARSE_LEVELS_ARB, &tail);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAX_LEVEL,T.levels-1);
+    T.sparse = true; T.pageW = pw; T.pageH = ph;
+    T.tailFirst = std::clamp((int)tail, 0, T.levels);
+    T.committedRows.assign(T.tailFirst, 0);
+    if(T.tailFirst < T.levels)
+        glTexPageCommitmentARB(GL_TEXTURE_2D, T.tailFirst, 0,0,0, T.levelW(T.tailFirst), T.levelH(T.tailFirst), 1, GL_TRUE);
+    T.committedBytes = tailBytes(T);
+    gLedger.track(LedgerKind::Texture, T.tex, MemTag::Governed, T.committedBytes);
+    std::printf("[Sparse] %dx%d %d levels, %dx%d pages, tail from level %d\n", T.baseW, T.baseH, T.levels, pw, ph, T.tailFirst);
+    return true;
+}
+
+// Move sparse residency to `top` with `commit` of it paged in: release pages first, then commit
+// (coarse to fine) and fill what was committed. Returns true if any page changed.
+inline bool setSparseResidency(GovTexture& T, int top, float commit){
+    top = std::clamp(top, 0, T.levels-1);
+    int rows = sparseRowsFor(T, top, commit);
+    auto wantRows = [&](int l){ return l < top ? 0 : (l==top ? rows : pageRowsAt(T, l)); };
+    glBindTexture(GL_TEXTURE_2D, T.tex);
+    bool changed = false;
+    for(int l=0; l<T.tailFirst; ++l){
+        int want = wantRows(l), have = T.committedRows[l];
+        if(want < have){ commitRows(T, l, want, have, false); T.committedRows[l] = want; changed = true; }
+    }
+    for(int l=T.tailFirst-1; l>=0; --l){
+        int want = wantRows(l), have = T.committedRows[l];
+        if(want <= have) continue;
+        commitRows(T, l, have, want, true);
+        uploadRows(T, l, have*T.pageH, want*T.pageH);
+        T.committedRows[l] = want; changed = true;
+    }
+    if(T.rowsLevel >= 0 && (T.rowsLevel != top || rows >= pageRowsAt(T, top))){ T.rowsPix = {}; T.rowsLevel = -1; }
+    if(top != T.residentTop) changed = true;
+    if(changed){
+        auto st = T.stream;
+        if(st->loadedTop <= T.residentTop) st->loadedTop = std::min(st->loadedTop, top);   // restores land synchronously
+        T.residentTop = top;
+        T.committedBytes = sparseBytes(T, top, rows);
+        gLedger.track(LedgerKind::Texture, T.tex, MemTag::Governed, T.committedBytes);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, std::max(top, st->loadedTop));
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return changed;
+}
+
+// ---------- Public API ----------
+// Allocate the texture with levels [top .. levels-1] resident, filled from its source.
+inline void createGovTexture(GovTexture& T, int top=0){
+    T.levels = mipLevelsFor(T.baseW, T.baseH);
+    T.residentTop = std::clamp(top, 0, T.levels-1);
+    if(createSparseStorage(T)){
+        for(int l=T.residentTop; l<T.tailFirst; ++l){ commitRows(T, l, 0, pageRowsAt(T, l), true); T.committedRows[l] = pageRowsAt(T, l); }
+        T.committedBytes = sparseBytes(T, T.residentTop, T.residentTop < T.tailFirst ? pageRowsAt(T, T.residentTop) : 0);
+        gLedger.track(LedgerKind::Texture, T.tex, MemTag::Governed, T.committedBytes);
+        T.stream->tex = T.tex; T.stream->top = 0; T.stream->loadedTop = T.levels;
+        fillLevels(T, T.residentTop, T.levels);
+        glBindTexture(GL_TEXTURE_2D,0);
+        return;
+    }
+    T.tex = allocStorage(T, T.residentTop);
+    T.stream->tex = T.tex; T.stream->top = T.residentTop; T.stream->loadedTop = T.levels;
+    fillLevels(T, T.residentTop, T.levels);
+    glBindTexture(GL_TEXTURE_2D,0);
+}
+
+// Shape/format come from the mapped file; no decode happens at all. Returns false if the
+// file's chain doesn't match its shape (left untouched so the caller can fall back).
+inline bool createGovTextureFromCache(GovTexture& T, std::shared_ptr<MappedTexCache> cache, int top=0){
+    if(!cache || cache->levels()!=mipLevelsFor(cache->baseW(), cache->baseH())) return false;
+    T.cache = std::move(cache);
+    T.baseW = T.cache->baseW(); T.baseH = T.cache->baseH();
+    T.format = glFormatFor(T.cache->format());
+    T.imagePath.clear();
+    createGovTexture(T, top);
+    return true;
+}
+
+// Retires the storage for the pool (recycled by the next texture of the same shape). Sparse
+// storage is deleted: its commitment is the only thing worth keeping and it goes with it.
+inline void destroyGovTexture(GovTexture& T){
+    if(T.tex){
+        ++T.stream->gen;
+        if(gAsyncUploads) gUploads.cancel(T.tex);
+        if(T.sparse) gRetire.retire(T.tex, T.committedBytes);
+        else         gRetire.retire(T.tex, shapeFor(T, T.residentTop).bytes(), true, shapeFor(T, T.residentTop));
+    }
+    T.tex=0; T.stream->tex=0;
+}
+
+// Move the resident window so that `newTop` is the finest level.
+// Levels that already hold data in the old storage are copied on the GPU; newly
+// required top levels are streamed from the source. Returns true if storage changed.
+// Sparse textures commit/release pages instead, keeping `commit` of newTop.
+inline bool setResidentTop(GovTexture& T, int newTop, float commit=1.f){
+    if(T.sparse && T.tex) return setSparseResidency(T, newTop, commit);
+    newTop = std::clamp(newTop, 0, T.levels-1);
+    if(newTop == T.residentTop || !T.tex) return false;
+
+    ++T.stream->gen;
+    if(gAsyncUploads) gUploads.cancel(T.tex);
+    GLuint dst = allocStorage(T, newTop);
+    int keepFrom = std::max(newTop, T.loadedTop());
+    if(isCompressed(T.format) && !GLEW_ARB_copy_image) keepFrom = T.levels;   // no blit for BC: re-read the cache
+    for(int l=keepFrom; l<T.levels; ++l)
+        copyLevel(T.tex, l - T.residentTop, dst, l - newTop, T.levelW(l), T.levelH(l));
+
+    gRetire.retire(T.tex, shapeFor(T, T.residentTop).bytes(), true, shapeFor(T, T.residentTop));
+    T.tex = dst;
+    T.residentTop = newTop;
+    T.stream->tex = dst; T.stream->top = newTop; T.stream->loadedTop = keepFrom;
+    fillLevels(T, newTop, keepFrom);          // stream-in (only when newTop < old data)
+    glBindTexture(GL_TEXTURE_2D,0);
+    return true;
+}
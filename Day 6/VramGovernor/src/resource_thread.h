@@ -0,0 +1,177 @@
+// Resource thread — GL object creation and deletion off the render thread
+// - A hidden GLFW window whose context shares objects with the main one; a worker thread makes
+//   it current and owns the heavy work: storage allocation, clears, mip generation, deletion
+// - Commands go in through a lock-free single-producer/single-consumer ring (render -> resource);
+//   finished work comes back through a second ring (resource -> render). When the command
+//   ring is full, commands wait in a render-thread overflow queue and move into the ring in
+//   order as it drains, so nothing overtakes an earlier command
+// - Every command is followed by a fence on the resource context; poll() hands the result to the
+//   render thread only once its fence has signalled, so the render thread never waits on the GPU
+// - Container objects (FBOs, VAOs) are not shared between contexts: a command that needs one
+//   creates and deletes it itself
+// - The ledger map is render-thread only: the caller records allocations in `done` and
+//   untracks before posting a delete
+// - Without a shared context (or before start()) commands run inline, as before
+#pragma once
+
+#include <cstdio>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "ledger.h"
+#include "trace.h"
+
+// Bounded ring, one pushing thread and one popping thread, no locks.
+template<class T, size_t N>
+class SpscRing {
+public:
+    bool push(T&& v){
+        size_t h = head_.load(std::memory_order_relaxed), n = (h+1) % N;
+        if(n == tail_.load(std::memory_order_acquire)) return false;
+        slots_[h] = std::move(v);
+        head_.store(n, std::memory_order_release);
+        return true;
+    }
+    // Consumer only: the oldest element, or nullptr.
+    T* front(){
+        size_t t = tail_.load(std::memory_order_relaxed);
+        return t == head_.load(std::memory_order_acquire) ? nullptr : &slots_[t];
+    }
+    void pop(){
+        size_t t = tail_.load(std::memory_order_relaxed);
+        slots_[t] = T{};
+        tail_.store((t+1) % N, std::memory_order_release);
+    }
+    bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+
+private:
+    T slots_[N];
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+class ResourceThread {
+public:
+    using Fn = std::function<void()>;
+    static constexpr size_t kRing = 256;
+
+    bool threaded() const { return ctx_ != nullptr; }
+    int  inFlight() const { return inFlight_; }
+
+    // Main thread, with `share` current; GLFW windows can only be created here.
+    bool start(GLFWwindow* share){
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        ctx_ = glfwCreateWindow(1, 1, "resource", nullptr, share);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+        if(!ctx_){ std::printf("[Resource] no shared context, creating inline\n"); return false; }
+        stop_ = false;
+        // GLEW's (non-MX) entry points are process-wide, valid for a context of the same driver.
+        worker_ = std::thread([this]{
+            gTrace.setThreadName("resource");
+            glfwMakeContextCurrent(ctx_);
+            workerLoop();
+            glfwMakeContextCurrent(nullptr);
+        });
+        std::printf("[Resource] shared-context thread up\n");
+        return true;
+    }
+
+    // Render thread. Drains the queue (deletes still run), then tears the context down.
+    void shutdown(){
+        if(!ctx_) return;
+        while(!overflow_.empty()){ poll(); std::this_thread::yield(); }   // the worker only sees the ring
+        { std::lock_guard<std::mutex> lk(m_); stop_ = true; }
+        cv_.notify_all();
+        if(worker_.joinable()) worker_.join();
+        while(Done* d = done_.front()){ glDeleteSync(d->fence); done_.pop(); }
+        inFlight_ = 0;
+        glfwDestroyWindow(ctx_); ctx_ = nullptr;
+    }
+
+    // Render thread. `run` executes with the resource context current; `done` runs on the
+    // render thread once the GPU has finished everything `run` issued.
+    void post(Fn run, Fn done = nullptr){
+        if(!ctx_){
+            run();                              // inline fallback (no thread)
+            if(done) done();
+            return;
+        }
+        overflow_.push_back({std::move(run), std::move(done)});
+        ++inFlight_;
+        flushOverflow();
+    }
+
+    // Render thread, once per frame: completions in submission order, never blocking.
+    void poll(){
+        while(Done* d = done_.front()){
+            GLenum st = glClientWaitSync(d->fence, 0, 0);
+            if(st!=GL_ALREADY_SIGNALED && st!=GL_CONDITION_SATISFIED) break;
+            glDeleteSync(d->fence);
+            Fn fn = std::move(d->done);
+            done_.pop(); --inFlight_;
+            if(fn) fn();
+        }
+        flushOverflow();
+    }
+
+private:
+    struct Cmd  { Fn run, done; };
+    struct Done { GLsync fence = nullptr; Fn done; };
+
+    // Render thread: oldest overflow commands into the ring while it has room.
+    void flushOverflow(){
+        bool moved = false;
+        while(!overflow_.empty() && cmds_.push(std::move(overflow_.front()))){ overflow_.pop_front(); moved = true; }
+        if(!moved) return;
+        { std::lock_guard<std::mutex> lk(m_); }
+        cv_.notify_one();
+    }
+
+    void workerLoop(){
+        for(;;){
+            Cmd* c = cmds_.front();
+            if(!c){
+                std::unique_lock<std::mutex> lk(m_);
+                cv_.wait(lk, [&]{ return stop_ || !cmds_.empty(); });
+                if(stop_ && cmds_.empty()) return;
+                continue;
+            }
+            { VG_ZONE("resource.cmd"); c->run(); }
+            Done d{ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), std::move(c->done) };
+            glFlush();                          // the fence must reach the GPU for the other context to see it signal
+            cmds_.pop();
+            // A full ring waits for poll(); once shutdown() is joining nobody polls, and its
+            // drain drops completions anyway, so drop this one here.
+            while(!done_.push(std::move(d))){
+                if(stop_){ glDeleteSync(d.fence); break; }
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    GLFWwindow* ctx_ = nullptr;
+    std::thread worker_;
+    std::mutex m_;                              // sleeping only; the rings are lock-free
+    std::condition_variable cv_;
+    std::atomic<bool> stop_{true};              // read unlocked by a worker waiting on done_
+    int  inFlight_ = 0;                         // render thread
+    std::deque<Cmd> overflow_;                  // render thread; posted behind a full ring
+    SpscRing<Cmd,  kRing> cmds_;
+    SpscRing<Done, kRing> done_;
+};
+
+inline ResourceThread gRes;
+
+// Untrack now, delete on the resource thread (the name stays valid until then).
+inline void releaseTexture(GLuint t){
+    if(!t) return;
+    gLedger.untrack(LedgerKind::Texture, t);
+    gRes.post([t]{ glDeleteTextures(1, &t); });
+}
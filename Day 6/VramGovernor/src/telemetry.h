@@ -0,0 +1,233 @@
+// Telemetry — cached free-VRAM sampling with a lock-free snapshot
+// - Backends: NVX (free/total plus the driver's eviction count and evicted memory), ATI, DXGI
+//   (Windows: QueryVideoMemoryInfo budget minus usage, used when neither GL extension exists)
+//   and FALLBACK (a model: base minus everything in the allocation ledger)
+// - The driver is queried at most every samplePeriod; sample() in between returns the cached
+//   value. glGetError is checked once when a backend is validated at init, never per read
+// - Every fresh sample is published to gTelSnapshot (a seqlock over atomics), which the upload
+//   and decode threads can read without locks and without a GL context
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <utility>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "ledger.h"
+#include "trace.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <dxgi1_4.h>
+#endif
+
+#ifndef GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX
+#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX         0x9047
+#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX    0x9048
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX  0x9049
+#define GL_GPU_MEMORY_INFO_EVICTION_COUNT_NVX            0x904A
+#define GL_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX            0x904B
+#endif
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+enum class TelMode : int { NVX, ATI, DXGI, FALLBACK };
+inline const char* telModeName(TelMode m){
+    return m==TelMode::NVX ? "NVX" : m==TelMode::ATI ? "ATI" : m==TelMode::DXGI ? "DXGI" : "FALLBACK";
+}
+
+struct TelemetrySample {
+    bool     valid = false;         // from a driver/OS counter (false: fallback model)
+    TelMode  mode  = TelMode::FALLBACK;
+    int      freeMB = 0, totalMB = -1;
+    int      evictionCount = -1, evictedMB = -1;   // NVX only; -1 unknown
+    double   time = 0.0;            // when it was read
+    uint64_t seq  = 0;              // increments per read
+};
+
+// Single writer (render thread), any number of readers.
+class TelemetrySnapshot {
+public:
+    void publish(const TelemetrySample& s){
+        uint32_t v = ver_.load(std::memory_order_relaxed);
+        ver_.store(v+1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        valid_.store(s.valid, std::memory_order_relaxed);
+        mode_.store((int)s.mode, std::memory_order_relaxed);
+        freeMB_.store(s.freeMB, std::memory_order_relaxed);
+        totalMB_.store(s.totalMB, std::memory_order_relaxed);
+        evictions_.store(s.evictionCount, std::memory_order_relaxed);
+        evictedMB_.store(s.evictedMB, std::memory_order_relaxed);
+        time_.store(s.time, std::memory_order_relaxed);
+        seq_.store(s.seq, std::memory_order_relaxed);
+        ver_.store(v+2, std::memory_order_release);
+    }
+    TelemetrySample read() const {
+        TelemetrySample s;
+        for(;;){
+            uint32_t v = ver_.load(std::memory_order_acquire);
+            if(v & 1) continue;             // write in progress
+            s.valid = valid_.load(std::memory_order_relaxed);
+            s.mode = (TelMode)mode_.load(std::memory_order_relaxed);
+            s.freeMB = freeMB_.load(std::memory_order_relaxed);
+            s.totalMB = totalMB_.load(std::memory_order_relaxed);
+            s.evictionCount = evictions_.load(std::memory_order_relaxed);
+            s.evictedMB = evictedMB_.load(std::memory_order_relaxed);
+            s.time = time_.load(std::memory_order_relaxed);
+            s.seq = seq_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(ver_.load(std::memory_order_relaxed) == v) return s;
+        }
+    }
+private:
+    std::atomic<uint32_t> ver_{0};
+    std::atomic<bool>     valid_{false};
+    std::atomic<int>      mode_{(int)TelMode::FALLBACK}, freeMB_{0}, totalMB_{-1}, evictions_{-1}, evictedMB_{-1};
+    std::atomic<double>   time_{0.0};
+    std::atomic<uint64_t> seq_{0};
+};
+
+inline TelemetrySnapshot gTelSnapshot;
+
+#ifdef _WIN32
+// Budget/usage of the local segment from DXGI 1.4; this is the OS's real per-process budget.
+struct DxgiBudget {
+    IDXGIAdapter3* adapter = nullptr;
+
+    // The hardware adapter with the most dedicated memory: where the GL context runs on a
+    // hybrid laptop once the app is set to the discrete GPU.
+    bool init(){
+        IDXGIFactory4* f = nullptr;
+        if(FAILED(CreateDXGIFactory1(__uuidof(IDXGIFactory4), (void**)&f))) return false;
+        IDXGIAdapter1* a = nullptr; SIZE_T best = 0;
+        for(UINT i=0; f->EnumAdapters1(i, &a)!=DXGI_ERROR_NOT_FOUND; ++i){
+            DXGI_ADAPTER_DESC1 d{}; a->GetDesc1(&d);
+            IDXGIAdapter3* a3 = nullptr;
+            if(!(d.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) && d.DedicatedVideoMemory > best &&
+               SUCCEEDED(a->QueryInterface(__uuidof(IDXGIAdapter3), (void**)&a3))){
+                if(adapter) adapter->Release();
+                adapter = a3; best = d.DedicatedVideoMemory;
+            }
+            a->Release();
+        }
+        f->Release();
+        return adapter != nullptr;
+    }
+    bool query(int& freeMB, int& totalMB) const {
+        DXGI_QUERY_VIDEO_MEMORY_INFO info{};
+        if(!adapter || FAILED(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info))) return false;
+        totalMB = (int)(info.Budget >> 20);
+        freeMB  = info.Budget > info.CurrentUsage ? (int)((info.Budget - info.CurrentUsage) >> 20) : 0;
+        return true;
+    }
+    void shutdown(){ if(adapter) adapter->Release(); adapter = nullptr; }
+};
+#endif
+
+struct Telemetry {
+    TelMode mode = TelMode::FALLBACK;
+    bool nvx=false, ati=false, dxgi=false;
+    bool sparse=false;          // GL_ARB_sparse_texture (a residency backend, not telemetry)
+    bool useTelemetry=true;
+    int  fallbackBaseFreeMB = 2048;   // VRAM the app may use; fallback free = this - gLedger.total()
+    double samplePeriod = 0.1;  // seconds between driver queries
+
+    void init(){
+        GLint n=0; glGetIntegerv(GL_NUM_EXTENSIONS,&n);
+        for(GLint i=0;i<n;++i){
+            const char* e=(const char*)glGetStringi(GL_EXTENSIONS,(GLuint)i);
+            if(!e) continue;
+            std::string s(e);
+            if(s=="GL_NVX_gpu_memory_info") nvx=true;
+            if(s=="GL_ATI_meminfo") ati=true;
+            if(s=="GL_ARB_sparse_texture") sparse=true;
+        }
+#ifdef _WIN32
+        if(!nvx && !ati) dxgi = dxgi_.init();
+#endif
+        mode = nvx ? TelMode::NVX : (ati ? TelMode::ATI : (dxgi ? TelMode::DXGI : TelMode::FALLBACK));
+        // Validate the GL path once; reads after this never call glGetError.
+        if(mode==TelMode::NVX || mode==TelMode::ATI){
+            while(glGetError()!=GL_NO_ERROR) {}
+            TelemetrySample s;
+            if(!query(s) || glGetError()!=GL_NO_ERROR){
+                std::printf("[Init] Telemetry %s query failed, using FALLBACK\n", telModeName(mode));
+                mode = TelMode::FALLBACK;
+            }
+        }
+        std::printf("[Init] Telemetry NVX=%d ATI=%d DXGI=%d -> %s (every %.0f ms), sparse textures %s\n",
+            nvx?1:0, ati?1:0, dxgi?1:0, telModeName(mode), samplePeriod*1000.0, sparse?"yes":"no");
+    }
+    void shutdown(){
+#ifdef _WIN32
+        dxgi_.shutdown();
+#endif
+    }
+
+    // Cached: queries the driver only when samplePeriod has passed. The fallback model is
+    // recomputed on every call (no driver involved).
+    const TelemetrySample& sample(double now){
+        if(last_.seq==0 || now - last_.time >= samplePeriod) refresh(now);
+        else if(!last_.valid) last_.freeMB = fallbackFreeMB();
+        return last_;
+    }
+    // Fresh read regardless of the rate (right after an allocation).
+    std::pair<bool,int> readNow(double now){
+        refresh(now);
+        return {last_.valid, last_.freeMB};
+    }
+    const TelemetrySample& last() const { return last_; }
+
+private:
+    int fallbackFreeMB() const { return std::max(0, fallbackBaseFreeMB - (int)(gLedger.total() >> 20)); }
+
+    bool query(TelemetrySample& s) const {
+        if(mode==TelMode::NVX){
+            GLint kb=0, totalKB=0, count=0, evictedKB=0;
+            glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &kb);
+            glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &totalKB);
+            glGetIntegerv(GL_GPU_MEMORY_INFO_EVICTION_COUNT_NVX, &count);
+            glGetIntegerv(GL_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX, &evictedKB);
+            if(kb<=0) return false;
+            s.freeMB = kb/1024; s.totalMB = totalKB/1024;
+            s.evictionCount = count; s.evictedMB = evictedKB/1024;
+            return true;
+        }
+        if(mode==TelMode::ATI){
+            GLint kb[4]={0,0,0,0}; glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, kb);
+            if(kb[0]<=0) return false;
+            s.freeMB = kb[0]/1024;
+            return true;
+        }
+#ifdef _WIN32
+        if(mode==TelMode::DXGI) return dxgi_.query(s.freeMB, s.totalMB);
+#endif
+        return false;
+    }
+
+    void refresh(double now){
+        VG_ZONE("telemetry.read");
+        TelemetrySample s;
+        s.time = now; s.mode = mode; s.seq = last_.seq + 1;
+        s.valid = useTelemetry && query(s);
+        if(!s.valid){ s.freeMB = fallbackFreeMB(); s.evictionCount = last_.evictionCount; s.evictedMB = last_.evictedMB; }
+        // The driver paging us out is the worst stall there is: say so when it happens.
+        if(s.evictionCount > last_.evictionCount && last_.evictionCount >= 0)
+            std::printf("[Telemetry] driver evicted %d more allocation(s), %d MB evicted in total\n",
+                s.evictionCount - last_.evictionCount, s.evictedMB);
+        last_ = s;
+        gTelSnapshot.publish(s);
+    }
+
+    TelemetrySample last_;
+#ifdef _WIN32
+    DxgiBudget dxgi_;
+#endif
+};
@@ -0,0 +1,361 @@
+// Texture cache — pre-mipped, optionally block-compressed, memory-mappable container (.vtc)
+// - Baked once (offline with --bake, or in the background on first run) from an image or a
+//   procedural LevelSource; later runs map the file and upload individual levels directly
+// - BC1 (4 bpp) and BC7 mode 6 (8 bpp) encoders, or plain RGBA8
+// - Per-level offsets make partial mip-range reads (governor stream-in) a pointer lookup
+//
+// Layout (little-endian):
+//   VtcHeader | VtcLevel[levels] | level data (each level 16-byte aligned, finest first)
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+
+#ifdef _WIN32
+  #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+  #endif
+  #ifndef NOMINMAX
+  #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+#include <GL/glew.h>
+
+#include "decode_pool.h"
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM   0x8E8C
+#endif
+
+enum class CacheFormat : uint32_t { RGBA8=0, BC1=1, BC7=2 };
+
+inline const char* cacheFormatName(CacheFormat f){
+    return f==CacheFormat::BC1 ? "bc1" : (f==CacheFormat::BC7 ? "bc7" : "rgba");
+}
+inline bool parseCacheFormat(const char* s, CacheFormat& out){
+    std::string v(s);
+    if(v=="bc1")  { out=CacheFormat::BC1;   return true; }
+    if(v=="bc7")  { out=CacheFormat::BC7;   return true; }
+    if(v=="rgba") { out=CacheFormat::RGBA8; return true; }
+    return false;
+}
+inline GLenum glFormatFor(CacheFormat f){
+    return f==CacheFormat::BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+         : (f==CacheFormat::BC7 ? GL_COMPRESSED_RGBA_BPTC_UNORM : GL_RGBA8);
+}
+inline size_t cacheLevelBytes(CacheFormat f, int w, int h){
+    size_t blocks = (size_t)((w+3)/4) * (size_t)((h+3)/4);
+    return f==CacheFormat::BC1 ? blocks*8 : (f==CacheFormat::BC7 ? blocks*16 : (size_t)w*h*4);
+}
+
+#pragma pack(push,1)
+struct VtcHeader {
+    char     magic[4];      // "VTC1"
+    uint32_t version;
+    uint32_t format;        // CacheFormat
+    uint32_t baseW, baseH, levels;
+    uint64_t sourceKey;     // identifies the source (path+size+mtime, or a procedural recipe)
+};
+struct VtcLevel {
+    uint64_t offset, size;
+    uint32_t w, h;
+};
+#pragma pack(pop)
+
+// ---------- Source keys (FNV-1a) ----------
+inline uint64_t fnv1a(const void* p, size_t n, uint64_t h=1469598103934665603ull){
+    const uint8_t* b=(const uint8_t*)p;
+    for(size_t i=0;i<n;++i){ h^=b[i]; h*=1099511628211ull; }
+    return h;
+}
+inline uint64_t sourceKey(const std::string& recipe){ return fnv1a(recipe.data(), recipe.size()); }
+inline uint64_t sourceKeyForFile(const std::string& path){
+    std::error_code ec;
+    auto sz = std::filesystem::file_size(path, ec);          if(ec) return 0;
+    auto mt = std::filesystem::last_write_time(path, ec);    if(ec) return 0;
+    int64_t ticks = (int64_t)mt.time_since_epoch().count();
+    uint64_t h = sourceKey(path);
+    h = fnv1a(&sz, sizeof(sz), h);
+    return fnv1a(&ticks, sizeof(ticks), h);
+}
+
+inline std::string gCacheDir = "cache";
+inline std::string cachePathFor(const std::string& name, CacheFormat f){
+    return gCacheDir + "/" + name + "." + cacheFormatName(f) + ".vtc";
+}
+
+// =================== Block encoders ===================
+// Principal axis of a 4x4 block (power iteration on the covariance), shared by BC1/BC7.
+inline void blockAxis(const float px[16][4], int ch, float mean[4], float axis[4]){
+    for(int c=0;c<4;++c){ mean[c]=0; for(int i=0;i<16;++i) mean[c]+=px[i][c]; mean[c]/=16.f; }
+    float cov[4][4]={};
+    for(int i=0;i<16;++i) for(int a=0;a<ch;++a) for(int b=0;b<ch;++b)
+        cov[a][b]+=(px[i][a]-mean[a])*(px[i][b]-mean[b]);
+    float v[4]={1,1,1,ch>3?1.f:0.f};
+    for(int it=0; it<6; ++it){
+        float n[4]={};
+        for(int a=0;a<ch;++a) for(int b=0;b<ch;++b) n[a]+=cov[a][b]*v[b];
+        float L=0; for(int a=0;a<ch;++a) L+=n[a]*n[a];
+        L=std::sqrt(L); if(L<1e-6f) break;
+        for(int a=0;a<ch;++a) v[a]=n[a]/L;
+    }
+    for(int c=0;c<4;++c) axis[c]= c<ch ? v[c] : 0.f;
+}
+inline void loadBlock(const uint8_t* rgba, int w, int h, int bx, int by, float px[16][4]){
+    for(int y=0;y<4;++y) for(int x=0;x<4;++x){
+        int sx=std::min(w-1,bx*4+x), sy=std::min(h-1,by*4+y);
+        const uint8_t* p = rgba + ((size_t)sy*w+sx)*4;
+        for(int c=0;c<4;++c) px[y*4+x][c]=p[c];
+    }
+}
+inline void axisExtents(const float px[16][4], const float mean[4], const float axis[4], float lo[4], float hi[4]){
+    float tmin=1e9f, tmax=-1e9f;
+    for(int i=0;i<16;++i){
+        float t=0; for(int c=0;c<4;++c) t+=(px[i][c]-mean[c])*axis[c];
+        tmin=std::min(tmin,t); tmax=std::max(tmax,t);
+    }
+    for(int c=0;c<4;++c){
+        lo[c]=std::clamp(mean[c]+axis[c]*tmin, 0.f, 255.f);
+        hi[c]=std::clamp(mean[c]+axis[c]*tmax, 0.f, 255.f);
+    }
+}
+
+// ---------- BC1 (opaque, 4-colour mode) ----------
+inline uint16_t pack565(const float c[4]){
+    int r=(int)std::lround(c[0]*31.f/255.f), g=(int)std::lround(c[1]*63.f/255.f), b=(int)std::lround(c[2]*31.f/255.f);
+    return (uint16_t)((r<<11)|(g<<5)|b);
+}
+inline void unpack565(uint16_t v, int out[3]){
+    int r=(v>>11)&31, g=(v>>5)&63, b=v&31;
+    out[0]=(r<<3)|(r>>2); out[1]=(g<<2)|(g>>4); out[2]=(b<<3)|(b>>2);
+}
+inline void encodeBC1Block(const float px[16][4], uint8_t out[8]){
+    float mean[4], axis[4], lo[4], hi[4];
+    blockAxis(px, 3, mean, axis);
+    axisExtents(px, mean, axis, lo, hi);
+    uint16_t c0=pack565(hi), c1=pack565(lo);
+    if(c0<c1) std::swap(c0,c1);
+    uint32_t idx=0;
+    if(c0!=c1){
+        int e0[3], e1[3], pal[4][3];
+        unpack565(c0,e0); unpack565(c1,e1);
+        for(int c=0;c<3;++c){
+            pal[0][c]=e0[c]; pal[1][c]=e1[c];
+            pal[2][c]=(2*e0[c]+e1[c])/3; pal[3][c]=(e0[c]+2*e1[c])/3;
+        }
+        for(int i=0;i<16;++i){
+            int best=0; float bestD=1e30f;
+            for(int k=0;k<4;++k){
+                float d=0; for(int c=0;c<3;++c){ float t=px[i][c]-pal[k][c]; d+=t*t; }
+                if(d<bestD){ bestD=d; best=k; }
+            }
+            idx |= (uint32_t)best << (2*i);
+        }
+    }
+    std::memcpy(out+0,&c0,2); std::memcpy(out+2,&c1,2); std::memcpy(out+4,&idx,4);
+}
+
+// ---------- BC7 mode 6 (one subset, RGBA 7.7.7.7 + p-bit endpoints, 4-bit indices) ----------
+struct Bits128 {
+    uint64_t w[2]={0,0}; int pos=0;
+    void put(uint32_t v, int n){
+        for(int i=0;i<n;++i,++pos) if((v>>i)&1u) w[pos>>6] |= 1ull<<(pos&63);
+    }
+};
+inline void quantizeBC7Endpoint(const float e[4], int q[4], int& pbit){
+    float bestErr=1e30f;
+    for(int p=0;p<2;++p){
+        int t[4]; float err=0;
+        for(int c=0;c<4;++c){
+            t[c]=std::clamp((int)std::lround((e[c]-p)/2.f), 0, 127);
+            float r=(float)(t[c]*2+p) - e[c]; err+=r*r;
+        }
+        if(err<bestErr){ bestErr=err; pbit=p; std::memcpy(q,t,sizeof(t)); }
+    }
+}
+inline void encodeBC7Block(const float px[16][4], uint8_t out[16]){
+    static const int W[16]={0,4,9,13,17,21,26,30,34,38,43,47,51,55,60,64};
+    float mean[4], axis[4], lo[4], hi[4];
+    blockAxis(px, 4, mean, axis);
+    axisExtents(px, mean, axis, lo, hi);
+    int q0[4], q1[4], p0=0, p1=0;
+    quantizeBC7Endpoint(lo, q0, p0);
+    quantizeBC7Endpoint(hi, q1, p1);
+    float e0[4], e1[4], d[4], dd=0;
+    for(int c=0;c<4;++c){ e0[c]=(float)(q0[c]*2+p0); e1[c]=(float)(q1[c]*2+p1); d[c]=e1[c]-e0[c]; dd+=d[c]*d[c]; }
+    int idx[16];
+    for(int i=0;i<16;++i){
+        float t=0; if(dd>0){ for(int c=0;c<4;++c) t+=(px[i][c]-e0[c])*d[c]; t/=dd; }
+        int best=0; float bestD=1e9f;
+        for(int k=0;k<16;++k){ float r=std::fabs(t*64.f-(float)W[k]); if(r<bestD){ bestD=r; best=k; } }
+        idx[i]=best;
+    }
+    if(idx[0]>=8){                       // anchor index must have its MSB clear
+        std::swap(q0,q1); std::swap(p0,p1);
+        for(int& v : idx) v=15-v;
+    }
+    Bits128 b;
+    b.put(1u<<6, 7);                     // mode 6
+    for(int c=0;c<4;++c){ b.put((uint32_t)q0[c],7); b.put((uint32_t)q1[c],7); }
+    b.put((uint32_t)p0,1); b.put((uint32_t)p1,1);
+    b.put((uint32_t)idx[0],3);
+    for(int i=1;i<16;++i) b.put((uint32_t)idx[i],4);
+    std::memcpy(out, b.w, 16);
+}
+
+inline std::vector<uint8_t> encodeLevel(CacheFormat f, const std::vector<uint8_t>& rgba, int w, int h){
+    if(f==CacheFormat::RGBA8) return rgba;
+    std::vector<uint8_t> out(cacheLevelBytes(f,w,h));
+    size_t bb = f==CacheFormat::BC1 ? 8 : 16;
+    int bw=(w+3)/4, bh=(h+3)/4;
+    float px[16][4];
+    for(int by=0;by<bh;++by) for(int bx=0;bx<bw;++bx){
+        loadBlock(rgba.data(), w, h, bx, by, px);
+        uint8_t* dst = out.data() + ((size_t)by*bw+bx)*bb;
+        if(f==CacheFormat::BC1) encodeBC1Block(px, dst); else encodeBC7Block(px, dst);
+    }
+    return out;
+}
+
+// =================== Baking ===================
+// `levels` must be the full chain, finest first (DecodedLevel::rgba holds RGBA8).
+inline bool bakeTexCache(const std::string& outPath, CacheFormat f, uint64_t key, const std::vector<DecodedLevel>& levels){
+    if(levels.empty()) return false;
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(outPath).parent_path(), ec);
+    std::string tmp = outPath + ".tmp";
+    FILE* fp = std::fopen(tmp.c_str(), "wb");
+    if(!fp){ std::fprintf(stderr,"[Cache] can't write %s\n", tmp.c_str()); return false; }
+
+    VtcHeader H{}; std::memcpy(H.magic,"VTC1",4); H.version=1; H.format=(uint32_t)f;
+    H.baseW=(uint32_t)levels[0].w; H.baseH=(uint32_t)levels[0].h; H.levels=(uint32_t)levels.size(); H.sourceKey=key;
+    std::vector<VtcLevel> table(levels.size());
+    uint64_t off = (sizeof(VtcHeader) + sizeof(VtcLevel)*table.size() + 15) & ~15ull;
+    for(size_t i=0;i<levels.size();++i){
+        table[i] = { off, cacheLevelBytes(f, levels[i].w, levels[i].h), (uint32_t)levels[i].w, (uint32_t)levels[i].h };
+        off = (off + table[i].size + 15) & ~15ull;
+    }
+    std::fwrite(&H, sizeof(H), 1, fp);
+    std::fwrite(table.data(), sizeof(VtcLevel), table.size(), fp);
+    static const uint8_t zeros[16]={};
+    long pos = (long)(sizeof(VtcHeader) + sizeof(VtcLevel)*table.size());
+    for(size_t i=0;i<levels.size();++i){
+        if((uint64_t)pos < table[i].offset){ std::fwrite(zeros, 1, (size_t)(table[i].offset-pos), fp); pos=(long)table[i].offset; }
+        auto enc = encodeLevel(f, levels[i].rgba, levels[i].w, levels[i].h);
+        std::fwrite(enc.data(), 1, enc.size(), fp); pos += (long)enc.size();
+    }
+    bool ok = std::ferror(fp)==0;
+    std::fclose(fp);
+    if(ok){ std::filesystem::rename(tmp, outPath, ec); ok = !ec; }
+    if(!ok) std::filesystem::remove(tmp, ec);
+    std::printf("[Cache] %s %s (%ux%u, %u levels, %s)\n", ok?"baked":"FAILED", outPath.c_str(),
+        H.baseW, H.baseH, H.levels, cacheFormatName(f));
+    return ok;
+}
+
+// Full chain from a procedural generator (one call per level).
+inline std::vector<DecodedLevel> levelsFromSource(int w, int h,
+        const std::function<std::vector<uint8_t>(int,int,int)>& src){
+    std::vector<DecodedLevel> out;
+    for(int l=0;;++l){
+        int lw=std::max(1,w>>l), lh=std::max(1,h>>l);
+        out.push_back({l, lw, lh, src(l,lw,lh)});
+        if(lw==1 && lh==1) break;
+    }
+    return out;
+}
+// Full chain from an image file.
+inline bool bakeImageCache(const std::string& image, const std::string& outPath, CacheFormat f){
+    std::vector<DecodedLevel> levels;
+    if(!decodeLevels(image, 0, 64, levels)) return false;
+    return bakeTexCache(outPath, f, sourceKeyForFile(image), levels);
+}
+
+// =================== Mapped loader ===================
+class MappedTexCache {
+public:
+    static std::shared_ptr<MappedTexCache> open(const std::string& path, uint64_t expectKey){
+        auto m = std::shared_ptr<MappedTexCache>(new MappedTexCache());
+        if(!m->map(path)) return nullptr;
+        if(m->size_ < sizeof(VtcHeader)) return nullptr;
+        const VtcHeader* H = m->header();
+        if(std::memcmp(H->magic,"VTC1",4)!=0 || H->version!=1 || H->levels==0 || H->levels>32) return nullptr;
+        if(m->size_ < sizeof(VtcHeader)+sizeof(VtcLevel)*H->levels) return nullptr;
+        for(uint32_t i=0;i<H->levels;++i){
+            const VtcLevel& L = m->level((int)i);
+            if(L.offset+L.size > m->size_) return nullptr;
+        }
+        if(expectKey && H->sourceKey!=expectKey){
+            std::printf("[Cache] %s is stale, ignoring\n", path.c_str());
+            return nullptr;
+        }
+        return m;
+    }
+    ~MappedTexCache(){
+#ifdef _WIN32
+        if(base_) UnmapViewOfFile(base_);
+        if(mapping_) CloseHandle(mapping_);
+        if(file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+#else
+        if(base_) munmap((void*)base_, size_);
+#endif
+    }
+
+    const VtcHeader* header() const { return (const VtcHeader*)base_; }
+    CacheFormat format() const { return (CacheFormat)header()->format; }
+    int  levels() const { return (int)header()->levels; }
+    int  baseW()  const { return (int)header()->baseW; }
+    int  baseH()  const { return (int)header()->baseH; }
+    const VtcLevel& level(int l) const { return ((const VtcLevel*)(base_ + sizeof(VtcHeader)))[l]; }
+    const uint8_t*  data(int l)  const { return base_ + level(l).offset; }
+
+private:
+    MappedTexCache() = default;
+    bool map(const std::string& path){
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file_==INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER sz; if(!GetFileSizeEx(file_, &sz)) return false;
+        size_ = (size_t)sz.QuadPart;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(!mapping_) return false;
+        base_ = (const uint8_t*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        return base_!=nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd<0) return false;
+        struct stat st{};
+        if(fstat(fd,&st)!=0 || st.st_size<=0){ ::close(fd); return false; }
+        size_ = (size_t)st.st_size;
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(p==MAP_FAILED) return false;
+        base_ = (const uint8_t*)p;
+        return true;
+#endif
+    }
+
+    const uint8_t* base_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE, mapping_ = nullptr;
+#endif
+};
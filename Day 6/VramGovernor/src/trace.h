@@ -0,0 +1,153 @@
+// Trace — scoped CPU zones and counters into per-thread rings, exported as Chrome trace JSON
+// - VG_ZONE("name") records one complete event (begin + duration) for the enclosing scope;
+//   names must be string literals (only the pointer is stored)
+// - Each thread writes its own ring (single producer, no locks); rings register once through
+//   an atomic slot counter and live for the process. A full ring overwrites its oldest events
+// - Disabled: a zone is one relaxed atomic load. Build with VG_TRACE=0 to compile zones out
+// - GPU zones (timestamp queries, same timeline) live in gputimer.h
+// - Export while capture is stopped: gTrace.writeChrome("trace.json"), open in ui.perfetto.dev
+//   or chrome://tracing
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#ifndef VG_TRACE
+#define VG_TRACE 1
+#endif
+
+struct TraceEvent {
+    const char* name;
+    int64_t     ts;     // ns since the trace epoch
+    int64_t     dur;    // ns; -1 marks a counter sample
+    double      value;  // counters only
+};
+
+class TraceRing {
+public:
+    static constexpr uint32_t kCapacity = 1u << 16;     // power of two
+    explicit TraceRing(int id=0) : tid(id) {}
+    int  tid = 0;
+    char threadName[32] = {};
+
+    void push(const TraceEvent& e){
+        uint64_t h = head_.load(std::memory_order_relaxed);
+        ev_[h & (kCapacity-1)] = e;
+        head_.store(h+1, std::memory_order_release);
+    }
+    // Oldest-first copy of what the ring still holds.
+    void snapshot(std::vector<TraceEvent>& out) const {
+        uint64_t h = head_.load(std::memory_order_acquire);
+        for(uint64_t i = h > kCapacity ? h - kCapacity : 0; i < h; ++i) out.push_back(ev_[i & (kCapacity-1)]);
+    }
+    void clear(){ head_.store(0, std::memory_order_release); }
+
+private:
+    std::vector<TraceEvent> ev_ = std::vector<TraceEvent>(kCapacity);
+    std::atomic<uint64_t>   head_{0};
+};
+
+class Tracer {
+public:
+    static constexpr int kMaxThreads = 64;
+    static constexpr int kGpuTid     = 1000;     // lane for GPU zones
+
+    bool enabled() const { return on_.load(std::memory_order_relaxed); }
+    void start(){ for(int i=0;i<count();++i) rings_[i].load()->clear(); on_.store(true); }
+    void stop(){ on_.store(false); }
+
+    int64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count();
+    }
+
+    // Calling thread's ring, registered on first use (nullptr once kMaxThreads are taken).
+    TraceRing* local(){
+        thread_local TraceRing* r = nullptr;
+        if(!r){
+            int slot = next_.fetch_add(1);
+            if(slot >= kMaxThreads) return nullptr;
+            r = new TraceRing(slot + 1);             // owned by the tracer for the process
+            rings_[slot].store(r, std::memory_order_release);
+        }
+        return r;
+    }
+    // Events from other clocks (GPU) go to a dedicated lane, written by the render thread only.
+    TraceRing& gpuRing(){ return gpu_; }
+
+    void setThreadName(const char* name){
+        if(TraceRing* r = local()) std::snprintf(r->threadName, sizeof(r->threadName), "%s", name);
+    }
+    void counter(const char* name, double v){
+        if(!enabled()) return;
+        if(TraceRing* r = local()) r->push({name, now(), -1, v});
+    }
+
+    bool writeChrome(const char* path){
+        std::FILE* f = std::fopen(path, "w");
+        if(!f){ std::fprintf(stderr,"[Trace] can't write %s\n", path); return false; }
+        std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", kGpuTid);
+        size_t total = 0;
+        std::vector<TraceEvent> ev;
+        auto emit = [&](const TraceRing& r){
+            ev.clear(); r.snapshot(ev);
+            if(r.threadName[0])
+                std::fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", r.tid, r.threadName);
+            for(const TraceEvent& e : ev){
+                if(e.dur < 0) std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%.3f}}", e.name, r.tid, e.ts*1e-3, e.value);
+                else          std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", e.name, r.tid, e.ts*1e-3, e.dur*1e-3);
+            }
+            total += ev.size();
+        };
+        for(int i=0;i<count();++i) emit(*rings_[i].load(std::memory_order_acquire));
+        emit(gpu_);
+        std::fprintf(f, "\n]}\n");
+        std::fclose(f);
+        std::printf("[Trace] %zu events -> %s\n", total, path);
+        return true;
+    }
+
+private:
+    // Slots are claimed before their pointer is published; skip any not yet visible.
+    int count() const {
+        int n = std::min(next_.load(), kMaxThreads);
+        for(int i=0;i<n;++i) if(!rings_[i].load(std::memory_order_acquire)) return i;
+        return n;
+    }
+
+    std::atomic<bool> on_{false};
+    std::atomic<int>  next_{0};
+    std::atomic<TraceRing*> rings_[kMaxThreads] = {};
+    TraceRing gpu_{kGpuTid};
+    std::chrono::steady_clock::time_point epoch_ = std::chrono::steady_clock::now();
+};
+
+inline Tracer gTrace;
+
+class TraceZone {
+public:
+    explicit TraceZone(const char* name) : name_(name), t0_(gTrace.enabled() ? gTrace.now() : -1) {}
+    ~TraceZone(){
+        if(t0_ < 0) return;
+        if(TraceRing* r = gTrace.local()) r->push({name_, t0_, gTrace.now() - t0_, 0.0});
+    }
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+private:
+    const char* name_;
+    int64_t     t0_;
+};
+
+#define VG_CAT2(a,b) a##b
+#define VG_CAT(a,b)  VG_CAT2(a,b)
+#if VG_TRACE
+#define VG_ZONE(name)        TraceZone VG_CAT(vgZone_, __LINE__)(name)
+#define VG_COUNTER(name, v)  gTrace.counter(name, (double)(v))
+#else
+#define VG_ZONE(name)        ((void)0)
+#define VG_COUNTER(name, v)  ((void)0)
+#endif
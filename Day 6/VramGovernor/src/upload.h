@@ -0,0 +1,263 @@
+// Upload — asynchronous texture uploads through a persistently mapped PBO ring
+// - A worker thread generates level data and copies it, row band by row band, into the ring
+// - The render thread issues glTexSubImage2D from the ring under a per-frame byte budget
+// - Ring space is recycled only once a fence shows the GPU has consumed it
+// - Without ARB_buffer_storage the worker keeps bands in CPU memory (same budget, no PBO)
+// - Block-compressed levels are banded on 4-row block boundaries (glCompressedTexSubImage2D)
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+#include <GL/glew.h>
+
+#include "ledger.h"
+#include "trace.h"
+
+// One texture level to upload. `produce` runs on the worker thread and must not touch GL.
+struct UploadJob {
+    GLuint tex = 0;
+    int    level = 0;           // destination level of `tex`
+    int    w = 0, h = 0;
+    int    bytesPerPixel = 4;
+    GLenum format = GL_RGBA, type = GL_UNSIGNED_BYTE;
+    GLenum compressedFormat = 0;    // non-zero: BC data, `blockBytes` per 4x4 block
+    int    blockBytes = 0;
+    using Callback = std::function<void()>;
+    std::function<std::vector<uint8_t>()> produce;
+    const uint8_t* data = nullptr;          // zero-copy source instead of produce() (e.g. a mapped file)
+    std::shared_ptr<const void> keepAlive;  // keeps `data` valid until the job is done
+    Callback onIssued;              // render thread, after the last band has been submitted
+};
+
+class UploadQueue {
+public:
+    size_t ringBytes      = 32ull<<20;
+    size_t bandBytes      = 2ull<<20;   // max bytes per glTexSubImage2D
+    size_t budgetPerFrame = 8ull<<20;   // bytes issued per pump()
+
+    bool persistent() const { return mapped_ != nullptr; }
+    size_t bytesIssuedLastFrame() const { return issuedLast_; }
+    size_t pendingBands() const { std::lock_guard<std::mutex> lk(m_); return ready_.size() + jobs_.size(); }
+
+    void init(){
+        if(GLEW_ARB_buffer_storage){
+            glGenBuffers(1,&pbo_);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_);
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            trackedBufferStorage(MemTag::Staging, GL_PIXEL_UNPACK_BUFFER, pbo_, ringBytes, nullptr, flags);
+            mapped_ = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)ringBytes, flags);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            if(!mapped_){ trackedDeleteBuffers(1,&pbo_); pbo_=0; }
+        }
+        std::printf("[Upload] %s ring=%zuMB budget=%zuMB/frame\n",
+            persistent()?"persistent PBO":"client-memory", ringBytes>>20, budgetPerFrame>>20);
+        stop_ = false;
+        worker_ = std::thread([this]{ gTrace.setThreadName("upload"); workerLoop(); });
+    }
+
+    void shutdown(){
+        { std::lock_guard<std::mutex> lk(m_); stop_ = true; }
+        cv_.notify_all();
+        if(worker_.joinable()) worker_.join();
+        for(auto& f : fences_) glDeleteSync(f.sync);
+        fences_.clear(); ready_.clear(); jobs_.clear(); regions_.clear();
+        if(pbo_){
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_); glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); trackedDeleteBuffers(1,&pbo_);
+        }
+        pbo_=0; mapped_=nullptr;
+    }
+
+    void submit(UploadJob job){
+        auto p = std::make_shared<Pending>(); p->job = std::move(job);
+        { std::lock_guard<std::mutex> lk(m_); jobs_.push_back(std::move(p)); }
+        cv_.notify_all();
+    }
+
+    // Submit only if `gen` still equals `expected`, atomically with respect to cancel():
+    // producers on other threads bump the generation before cancelling a texture.
+    bool submitIfCurrent(UploadJob job, const std::atomic<uint64_t>& gen, uint64_t expected){
+        auto p = std::make_shared<Pending>(); p->job = std::move(job);
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            if(gen.load() != expected) return false;
+            jobs_.push_back(std::move(p));
+        }
+        cv_.notify_all();
+        return true;
+    }
+
+    // Drop queued work for a texture that is about to be released or reallocated.
+    void cancel(GLuint tex){
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            for(auto& p : jobs_)  if(p->job.tex==tex) p->cancelled = true;
+            for(auto& b : ready_) if(b.p->job.tex==tex) b.p->cancelled = true;
+            if(current_ && current_->job.tex==tex) current_->cancelled = true;
+        }
+        cv_.notify_all();
+    }
+
+    // Render thread, once per frame: retire finished ring space, then issue ready bands.
+    void pump(){
+        VG_ZONE("upload.pump");
+        retire();
+        size_t issued=0;
+        GLuint boundTex=0;
+        if(pbo_) glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for(;;){
+            Band b;
+            {
+                std::lock_guard<std::mutex> lk(m_);
+                if(ready_.empty()) break;
+                if(issued>0 && issued + ready_.front().bytes > budgetPerFrame) break;
+                b = std::move(ready_.front()); ready_.pop_front();
+            }
+            const UploadJob& J = b.p->job;
+            if(!b.p->cancelled){
+                if(boundTex!=J.tex){ glBindTexture(GL_TEXTURE_2D, J.tex); boundTex=J.tex; }
+                const void* src = pbo_ ? (const void*)(uintptr_t)b.ringOff : (const void*)b.cpu.data();
+                if(J.compressedFormat)
+                    glCompressedTexSubImage2D(GL_TEXTURE_2D, J.level, 0, b.y0, J.w, b.rows,
+                                              J.compressedFormat, (GLsizei)b.bytes, src);
+                else
+                    glTexSubImage2D(GL_TEXTURE_2D, J.level, 0, b.y0, J.w, b.rows, J.format, J.type, src);
+                issued += b.bytes;
+                if(b.last && J.onIssued) J.onIssued();
+            }
+            if(b.ringRegion) lastIssuedEnd_ = b.ringRegion;
+        }
+        if(pbo_) glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if(boundTex) glBindTexture(GL_TEXTURE_2D, 0);
+        if(pbo_ && lastIssuedEnd_ && lastIssuedEnd_ != lastFencedEnd_){
+            fences_.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), lastIssuedEnd_ });
+            lastFencedEnd_ = lastIssuedEnd_;
+        }
+        issuedLast_ = issued;
+    }
+
+private:
+    struct Pending {
+        UploadJob job;
+        std::atomic<bool> cancelled{false};
+    };
+    struct Band {
+        std::shared_ptr<Pending> p;
+        int    y0=0, rows=0;
+        size_t bytes=0;
+        bool   last=false;
+        size_t ringOff=0;
+        uint64_t ringRegion=0;      // sequence number of the ring region (0 = none)
+        std::vector<uint8_t> cpu;   // client-memory path only
+    };
+    struct Region { uint64_t seq; size_t off, len; };
+    struct Fence  { GLsync sync; uint64_t upToSeq; };
+
+    // ---- ring allocator (worker allocates, render thread retires, in FIFO order) ----
+    bool tryAlloc(size_t n, size_t& off, uint64_t& seq){
+        if(n > ringBytes) return false;
+        if(regions_.empty()) off = 0;
+        else {
+            size_t first = regions_.front().off;
+            size_t end   = regions_.back().off + regions_.back().len;
+            if(regions_.back().off >= first){          // not wrapped
+                if(ringBytes - end >= n) off = end;
+                else if(first >= n)      off = 0;
+                else return false;
+            } else {                                   // wrapped
+                if(first - end >= n) off = end;
+                else return false;
+            }
+        }
+        seq = ++nextSeq_;
+        regions_.push_back({seq, off, n});
+        return true;
+    }
+
+    void retire(){
+        bool freed=false;
+        while(!fences_.empty()){
+            GLenum r = glClientWaitSync(fences_.front().sync, 0, 0);
+            if(r!=GL_ALREADY_SIGNALED && r!=GL_CONDITION_SATISFIED) break;
+            glDeleteSync(fences_.front().sync);
+            uint64_t upTo = fences_.front().upToSeq; fences_.pop_front();
+            std::lock_guard<std::mutex> lk(m_);
+            while(!regions_.empty() && regions_.front().seq <= upTo){ regions_.pop_front(); freed=true; }
+        }
+        if(freed) cv_.notify_all();
+    }
+
+    void workerLoop(){
+        for(;;){
+            std::shared_ptr<Pending> p;
+            {
+                std::unique_lock<std::mutex> lk(m_);
+                cv_.wait(lk, [&]{ return stop_ || !jobs_.empty(); });
+                if(stop_) return;
+                p = jobs_.front(); jobs_.pop_front();
+                current_ = p;
+            }
+            const UploadJob& J = p->job;
+            if(p->cancelled){ std::lock_guard<std::mutex> lk(m_); current_.reset(); continue; }
+            std::vector<uint8_t> pix;
+            const uint8_t* base = J.data;
+            if(!base){ VG_ZONE("upload.produce"); pix = J.produce(); base = pix.data(); }
+            VG_ZONE("upload.stage");
+
+            // A "unit" is one pixel row, or one row of 4x4 blocks for compressed data.
+            int    unitRows  = J.compressedFormat ? 4 : 1;
+            size_t unitBytes = J.compressedFormat ? (size_t)((J.w+3)/4) * J.blockBytes
+                                                  : (size_t)J.w * J.bytesPerPixel;
+            int unitsPerBand = (int)std::max<size_t>(1, std::min(bandBytes, ringBytes/2) / unitBytes);
+            int rowsPerBand  = unitsPerBand * unitRows;
+            for(int y=0; y<J.h; y+=rowsPerBand){
+                Band b; b.p=p; b.y0=y; b.rows=std::min(rowsPerBand, J.h-y);
+                b.bytes=(size_t)((b.rows+unitRows-1)/unitRows)*unitBytes; b.last=(y+b.rows>=J.h);
+                const uint8_t* src = base + (size_t)(y/unitRows)*unitBytes;
+                if(mapped_){
+                    std::unique_lock<std::mutex> lk(m_);
+                    cv_.wait(lk, [&]{ return stop_ || p->cancelled || tryAlloc(b.bytes, b.ringOff, b.ringRegion); });
+                    if(stop_) return;
+                    if(!b.ringRegion) break;           // cancelled while waiting for ring space
+                    lk.unlock();
+                    std::memcpy(mapped_ + b.ringOff, src, b.bytes);  // coherent mapping, no flush needed
+                } else {
+                    b.cpu.assign(src, src + b.bytes);
+                }
+                // Cancelled bands still go through pump() so their ring region is fenced and retired.
+                std::lock_guard<std::mutex> lk(m_);
+                ready_.push_back(std::move(b));
+                if(p->cancelled) break;
+            }
+            std::lock_guard<std::mutex> lk(m_); current_.reset();
+        }
+    }
+
+    GLuint   pbo_ = 0;
+    uint8_t* mapped_ = nullptr;
+    size_t   issuedLast_ = 0;
+    uint64_t nextSeq_ = 0, lastIssuedEnd_ = 0, lastFencedEnd_ = 0;
+
+    mutable std::mutex m_;
+    std::condition_variable cv_;
+    std::thread worker_;
+    bool stop_ = true;
+    std::deque<std::shared_ptr<Pending>> jobs_;
+    std::shared_ptr<Pending> current_;
+    std::deque<Band>   ready_;
+    std::deque<Region> regions_;
+    std::deque<Fence>  fences_;
+};
+
+inline UploadQueue gUploads;
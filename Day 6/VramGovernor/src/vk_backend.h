@@ -0,0 +1,451 @@
+// VkBackend — the Vulkan path behind GpuBackend (built with VG_VULKAN)
+// - Budget: VK_EXT_memory_budget summed over the DEVICE_LOCAL heaps (free = budget - usage),
+//   i.e. the driver's own number instead of the NVX / ATI / fallback guess; without the
+//   extension it falls back to fallbackMB (or 90% of the local heaps) - what we hold, like
+//   Telemetry's FALLBACK. Both add the allocator's slack (block space no image occupies):
+//   shrinking an image frees a range inside a live block, which the driver never sees
+// - Memory: images are placed in 256 MB blocks through BlockAllocator (one pool per memory
+//   type), so a governor step is a bind into an existing block, not a vkAllocateMemory
+// - Streaming: a dedicated transfer queue (if the device has one with a 1x1x1 granularity)
+//   and a persistently mapped staging ring. Work recorded during a frame goes out as one
+//   fenced batch in present(); ring space and retired images are released when it signals
+// - Changing the resident top allocates the new chain, copies the levels both chains share
+//   on the GPU, uploads only the newly required top levels, and retires the old image with
+//   the batch (onFreed fires once its memory is back in the block)
+// - Images use concurrent sharing between the graphics and transfer families, so no queue
+//   ownership transfers are needed
+// - Headless: there is no swapchain and no draw pipeline yet (no SPIR-V in this tree), so
+//   drawGrid() is a no-op and gpuMs() is 0; the budget / residency / transfer path is complete
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+#include <vulkan/vulkan.h>
+
+#include "backend.h"
+#include "block_alloc.h"
+#include "residency.h"      // LevelSource, mipLevelsFor
+
+class VkBackend : public GpuBackend {
+public:
+    size_t stagingBytes = size_t(64) << 20;
+
+    const char* name() const override { return "vk"; }
+    std::string device() const override { return deviceName_; }
+
+    bool init(int fallbackMB) override {
+        fallbackMB_ = fallbackMB;
+        VkApplicationInfo app{VK_STRUCTURE_TYPE_APPLICATION_INFO};
+        app.pApplicationName = "vram_bench";
+        app.apiVersion = VK_API_VERSION_1_1;       // vkGetPhysicalDeviceMemoryProperties2
+        VkInstanceCreateInfo ici{VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
+        ici.pApplicationInfo = &app;
+        if(vkCreateInstance(&ici, nullptr, &inst_) != VK_SUCCESS){ std::fprintf(stderr,"[Vulkan] no instance\n"); return false; }
+
+        // Prefer a discrete GPU, then one that reports a memory budget
+        uint32_t n = 0; vkEnumeratePhysicalDevices(inst_, &n, nullptr);
+        std::vector<VkPhysicalDevice> devs(n); vkEnumeratePhysicalDevices(inst_, &n, devs.data());
+        int best = -1;
+        for(uint32_t i=0;i<n;++i){
+            VkPhysicalDeviceProperties p; vkGetPhysicalDeviceProperties(devs[i], &p);
+            int score = (p.deviceType==VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU ? 2 : 0) + (hasExtension(devs[i], VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) ? 1 : 0);
+            if(score > best){ best = score; phys_ = devs[i]; deviceName_ = p.deviceName; }
+        }
+        if(!phys_){ std::fprintf(stderr,"[Vulkan] no physical device\n"); return false; }
+        hasBudget_ = hasExtension(phys_, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        vkGetPhysicalDeviceMemoryProperties(phys_, &memProps_);
+        for(uint32_t h=0; h<memProps_.memoryHeapCount; ++h)
+            if(memProps_.memoryHeaps[h].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) localHeapMB_ += (int)(memProps_.memoryHeaps[h].size >> 20);
+
+        // Graphics family, and a transfer-only family if one can copy arbitrary rectangles
+        uint32_t qn = 0; vkGetPhysicalDeviceQueueFamilyProperties(phys_, &qn, nullptr);
+        std::vector<VkQueueFamilyProperties> qf(qn); vkGetPhysicalDeviceQueueFamilyProperties(phys_, &qn, qf.data());
+        gfxFamily_ = xferFamily_ = UINT32_MAX;
+        for(uint32_t i=0;i<qn;++i) if((qf[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) && gfxFamily_==UINT32_MAX) gfxFamily_ = i;
+        for(uint32_t i=0;i<qn;++i){
+            const VkExtent3D& g = qf[i].minImageTransferGranularity;
+            if((qf[i].queueFlags & VK_QUEUE_TRANSFER_BIT) && !(qf[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT|VK_QUEUE_COMPUTE_BIT))
+               && g.width==1 && g.height==1 && g.depth==1){ xferFamily_ = i; break; }
+        }
+        if(gfxFamily_==UINT32_MAX){ std::fprintf(stderr,"[Vulkan] no graphics queue\n"); return false; }
+        if(xferFamily_==UINT32_MAX) xferFamily_ = gfxFamily_;
+
+        float prio = 1.f;
+        VkDeviceQueueCreateInfo qci[2] = {{VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO}, {VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO}};
+        qci[0].queueFamilyIndex = gfxFamily_;  qci[0].queueCount = 1; qci[0].pQueuePriorities = &prio;
+        qci[1].queueFamilyIndex = xferFamily_; qci[1].queueCount = 1; qci[1].pQueuePriorities = &prio;
+        const char* ext = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+        VkDeviceCreateInfo dci{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+        dci.queueCreateInfoCount = xferFamily_!=gfxFamily_ ? 2 : 1; dci.pQueueCreateInfos = qci;
+        dci.enabledExtensionCount = hasBudget_ ? 1 : 0; dci.ppEnabledExtensionNames = &ext;
+        if(vkCreateDevice(phys_, &dci, nullptr, &dev_) != VK_SUCCESS){ std::fprintf(stderr,"[Vulkan] no device\n"); return false; }
+        vkGetDeviceQueue(dev_, gfxFamily_, 0, &gfxQueue_);
+        vkGetDeviceQueue(dev_, xferFamily_, 0, &xferQueue_);
+
+        VkCommandPoolCreateInfo pci{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+        pci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        pci.queueFamilyIndex = xferFamily_; vkCreateCommandPool(dev_, &pci, nullptr, &xferPool_);
+        pci.queueFamilyIndex = gfxFamily_;  vkCreateCommandPool(dev_, &pci, nullptr, &gfxPool_);
+
+        alloc_.newBlock = [this](int pool, int block, size_t bytes){
+            VkMemoryAllocateInfo ai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+            ai.allocationSize = bytes; ai.memoryTypeIndex = (uint32_t)pool;
+            VkDeviceMemory m = VK_NULL_HANDLE;
+            if(vkAllocateMemory(dev_, &ai, nullptr, &m) != VK_SUCCESS) return false;
+            if(pool >= (int)blocks_.size()) blocks_.resize(pool+1);
+            if(block >= (int)blocks_[pool].size()) blocks_[pool].resize(block+1, VK_NULL_HANDLE);
+            blocks_[pool][block] = m;
+            return true;
+        };
+        alloc_.releaseBlock = [this](int pool, int block){
+            vkFreeMemory(dev_, blocks_[pool][block], nullptr);
+            blocks_[pool][block] = VK_NULL_HANDLE;
+        };
+
+        // Staging ring: host-visible, coherent, mapped for the life of the backend
+        VkBufferCreateInfo bci{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+        bci.size = stagingBytes; bci.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT; bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if(vkCreateBuffer(dev_, &bci, nullptr, &staging_) != VK_SUCCESS) return false;
+        VkMemoryRequirements req; vkGetBufferMemoryRequirements(dev_, staging_, &req);
+        int type = memoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        VkMemoryAllocateInfo ai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+        ai.allocationSize = req.size; ai.memoryTypeIndex = (uint32_t)type;
+        if(type < 0 || vkAllocateMemory(dev_, &ai, nullptr, &stagingMem_) != VK_SUCCESS){ std::fprintf(stderr,"[Vulkan] no staging memory\n"); return false; }
+        vkBindBufferMemory(dev_, staging_, stagingMem_, 0);
+        vkMapMemory(dev_, stagingMem_, 0, VK_WHOLE_SIZE, 0, (void**)&mapped_);
+
+        std::printf("[Vulkan] %s | memory budget: %s | transfer queue: %s\n", deviceName_.c_str(),
+            hasBudget_ ? "VK_EXT_memory_budget" : "none (fallback)", xferFamily_!=gfxFamily_ ? "dedicated" : "shared with graphics");
+        return true;
+    }
+
+    void shutdown() override {
+        if(!dev_){ if(inst_) vkDestroyInstance(inst_, nullptr); inst_ = VK_NULL_HANDLE; return; }
+        if(open_) flush();
+        vkDeviceWaitIdle(dev_);
+        collect(true);
+        for(auto& T : tex_) if(T.img){ vkDestroyImage(dev_, T.img, nullptr); alloc_.free(T.mem); }
+        for(auto& P : pads_) if(P.img){ vkDestroyImage(dev_, P.img, nullptr); alloc_.free(P.mem); }
+        tex_.clear(); pads_.clear();
+        alloc_.clear();
+        for(auto& B : spare_){ vkDestroyFence(dev_, B.fence, nullptr); vkFreeCommandBuffers(dev_, xferPool_, 1, &B.cmd); }
+        spare_.clear();
+        if(staging_) vkDestroyBuffer(dev_, staging_, nullptr);
+        if(stagingMem_){ vkUnmapMemory(dev_, stagingMem_); vkFreeMemory(dev_, stagingMem_, nullptr); }
+        vkDestroyCommandPool(dev_, xferPool_, nullptr);
+        vkDestroyCommandPool(dev_, gfxPool_, nullptr);
+        vkDestroyDevice(dev_, nullptr);
+        vkDestroyInstance(inst_, nullptr);
+        dev_ = VK_NULL_HANDLE; inst_ = VK_NULL_HANDLE;
+    }
+
+    BudgetSample sampleBudget(double now) override {
+        BudgetSample s;
+        s.time = now;                   // both paths read fresh every call
+        int slackMB = (int)((alloc_.reservedBytes() - alloc_.usedBytes()) >> 20);
+        if(!hasBudget_ || fallbackMB_ > 0){
+            s.freeMB = std::max(0, (fallbackMB_ > 0 ? fallbackMB_ : localHeapMB_*9/10) - (int)allocatedMB() + slackMB);
+            s.source = "FALLBACK";
+            return s;
+        }
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT};
+        VkPhysicalDeviceMemoryProperties2 props{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2};
+        props.pNext = &budget;
+        vkGetPhysicalDeviceMemoryProperties2(phys_, &props);
+        uint64_t b=0, u=0, total=0;
+        for(uint32_t h=0; h<props.memoryProperties.memoryHeapCount; ++h){
+            if(!(props.memoryProperties.memoryHeaps[h].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) continue;
+            b += budget.heapBudget[h]; u += budget.heapUsage[h]; total += props.memoryProperties.memoryHeaps[h].size;
+        }
+        s.valid = b > 0;
+        s.freeMB = (b > u ? (int)((b - u) >> 20) : 0) + slackMB;
+        s.totalMB = (int)(total >> 20);
+        s.source = "VK_EXT_memory_budget";
+        return s;
+    }
+
+    int createTexture(int w, int h, LevelSource src, int top) override {
+        Tex T; T.w = w; T.h = h; T.levels = mipLevelsFor(w, h); T.src = std::move(src);
+        T.top = std::clamp(top, 0, T.levels-1);
+        if(!createImage(T.levelW(T.top), T.levelH(T.top), T.levels - T.top, T.img, T.mem)) return -1;
+        barrier(T.img, 0, T.levels - T.top, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        for(int l=T.top; l<T.levels; ++l) uploadLevel(T, T.img, l, l - T.top);
+        barrier(T.img, 0, T.levels - T.top, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        tex_.push_back(std::move(T));
+        return (int)tex_.size()-1;
+    }
+
+    bool setResidentTop(int t, int top) override {
+        Tex& T = tex_[t];
+        top = std::clamp(top, 0, T.levels-1);
+        if(top == T.top || !T.img) return false;
+        VkImage img = VK_NULL_HANDLE; BlockAllocation mem;
+        if(!createImage(T.levelW(top), T.levelH(top), T.levels - top, img, mem)) return false;   // over budget: stay put
+        int keepFrom = std::max(top, T.top);
+        barrier(img, 0, T.levels - top, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        barrier(T.img, keepFrom - T.top, T.levels - keepFrom, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        std::vector<VkImageCopy> copies;
+        for(int l=keepFrom; l<T.levels; ++l){
+            VkImageCopy c{};
+            c.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, (uint32_t)(l - T.top), 0, 1};
+            c.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, (uint32_t)(l - top), 0, 1};
+            c.extent = {(uint32_t)T.levelW(l), (uint32_t)T.levelH(l), 1};
+            copies.push_back(c);
+        }
+        vkCmdCopyImage(batch().cmd, T.img, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       (uint32_t)copies.size(), copies.data());
+        for(int l=top; l<keepFrom; ++l) uploadLevel(T, img, l, l - top);        // stream-in (growing only)
+        barrier(img, 0, T.levels - top, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        retire(T.img, T.mem, T.bytesAt(T.top));
+        T.img = img; T.mem = mem; T.top = top;
+        return true;
+    }
+    int    residentTop(int t) const override { return tex_[t].top; }
+    int    levels(int t) const override { return tex_[t].levels; }
+    size_t bytesAt(int t, int top) const override { return tex_[t].bytesAt(std::clamp(top, 0, tex_[t].levels-1)); }
+    void   destroyTexture(int t) override {
+        Tex& T = tex_[t];
+        if(T.img) retire(T.img, T.mem, T.bytesAt(T.top));
+        T.img = VK_NULL_HANDLE; T.mem = {};
+    }
+
+    // Pads are cleared on the graphics queue (transfer queues can't clear) and waited on.
+    int createPad(int dim) override {
+        Pad P; P.dim = dim;
+        int levels = mipLevelsFor(dim, dim);
+        if(!createImage(dim, dim, levels, P.img, P.mem)) return -1;
+        VkCommandBufferAllocateInfo cai{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        cai.commandPool = gfxPool_; cai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY; cai.commandBufferCount = 1;
+        VkCommandBuffer cmd; vkAllocateCommandBuffers(dev_, &cai, &cmd);
+        VkCommandBufferBeginInfo bi{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+        bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(cmd, &bi);
+        recordBarrier(cmd, P.img, 0, levels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        VkClearColorValue grey{{0.1f, 0.1f, 0.1f, 1.f}};
+        VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, (uint32_t)levels, 0, 1};
+        vkCmdClearColorImage(cmd, P.img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &grey, 1, &range);
+        vkEndCommandBuffer(cmd);
+        VkSubmitInfo si{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        si.commandBufferCount = 1; si.pCommandBuffers = &cmd;
+        vkQueueSubmit(gfxQueue_, 1, &si, VK_NULL_HANDLE);
+        vkQueueWaitIdle(gfxQueue_);
+        vkFreeCommandBuffers(dev_, gfxPool_, 1, &cmd);
+        pads_.push_back(P);
+        return (int)pads_.size()-1;
+    }
+    void destroyPad(int p) override {
+        Pad& P = pads_[p];
+        if(P.img) retire(P.img, P.mem, chainBytes(P.dim, P.dim, 0, mipLevelsFor(P.dim, P.dim)));
+        P = Pad{};
+    }
+
+    void beginFrame() override { collect(false); }
+    void setPressure(bool) override {}      // blocks are never pooled across shapes: nothing to trim
+    double retiringMB() const override { return retiring_/(1024.0*1024.0); }
+    double allocatedMB() const override { return (alloc_.reservedBytes() + stagingBytes)/(1024.0*1024.0); }
+
+    void   drawGrid(const std::vector<GridDraw>&) override {}
+    void   present() override { if(open_) flush(); }
+    double gpuMs() const override { return 0.0; }
+    double avgGpuMs() const override { return 0.0; }
+
+private:
+    struct Tex {
+        VkImage img = VK_NULL_HANDLE; BlockAllocation mem;
+        int w=0, h=0, levels=1, top=0;
+        LevelSource src;
+        int    levelW(int l) const { return std::max(1, w >> l); }
+        int    levelH(int l) const { return std::max(1, h >> l); }
+        size_t bytesAt(int t) const { return chainBytes(w, h, t, levels); }
+    };
+    struct Pad     { VkImage img = VK_NULL_HANDLE; BlockAllocation mem; int dim = 0; };
+    struct Retired { VkImage img; BlockAllocation mem; size_t bytes; };
+    struct Batch   { VkCommandBuffer cmd = VK_NULL_HANDLE; VkFence fence = VK_NULL_HANDLE; size_t ringBytes = 0; std::vector<Retired> retired; };
+
+    // RGBA8 bytes of levels [top .. levels-1] of a w x h chain.
+    static size_t chainBytes(int w, int h, int top, int levels){
+        size_t b=0;
+        for(int l=top; l<levels; ++l) b += (size_t)std::max(1, w >> l) * std::max(1, h >> l) * 4;
+        return b;
+    }
+    static bool hasExtension(VkPhysicalDevice d, const char* name){
+        uint32_t n = 0; vkEnumerateDeviceExtensionProperties(d, nullptr, &n, nullptr);
+        std::vector<VkExtensionProperties> e(n); vkEnumerateDeviceExtensionProperties(d, nullptr, &n, e.data());
+        for(const auto& x : e) if(std::strcmp(x.extensionName, name)==0) return true;
+        return false;
+    }
+    int memoryType(uint32_t bits, VkMemoryPropertyFlags want) const {
+        for(uint32_t i=0;i<memProps_.memoryTypeCount;++i)
+            if((bits & (1u<<i)) && (memProps_.memoryTypes[i].propertyFlags & want)==want) return (int)i;
+        return -1;
+    }
+
+    bool createImage(int w, int h, int levels, VkImage& img, BlockAllocation& mem){
+        uint32_t families[2] = { gfxFamily_, xferFamily_ };
+        VkImageCreateInfo ci{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+        ci.imageType = VK_IMAGE_TYPE_2D; ci.format = VK_FORMAT_R8G8B8A8_UNORM;
+        ci.extent = {(uint32_t)w, (uint32_t)h, 1}; ci.mipLevels = (uint32_t)levels; ci.arrayLayers = 1;
+        ci.samples = VK_SAMPLE_COUNT_1_BIT; ci.tiling = VK_IMAGE_TILING_OPTIMAL;
+        ci.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        if(xferFamily_ != gfxFamily_){ ci.sharingMode = VK_SHARING_MODE_CONCURRENT; ci.queueFamilyIndexCount = 2; ci.pQueueFamilyIndices = families; }
+        else ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if(vkCreateImage(dev_, &ci, nullptr, &img) != VK_SUCCESS){ img = VK_NULL_HANDLE; return false; }
+        VkMemoryRequirements req; vkGetImageMemoryRequirements(dev_, img, &req);
+        int type = memoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        mem = type < 0 ? BlockAllocation{} : alloc_.alloc(type, req.size, req.alignment);
+        if(!mem.valid()){
+            std::fprintf(stderr,"[Vulkan] out of device memory for a %dx%d image\n", w, h);
+            vkDestroyImage(dev_, img, nullptr); img = VK_NULL_HANDLE;
+            return false;
+        }
+        vkBindImageMemory(dev_, img, blocks_[mem.pool][mem.block], mem.offset);
+        return true;
+    }
+
+    // ---------- Transfer batches ----------
+    Batch& batch(){
+        if(!open_){
+            Batch B;
+            if(!spare_.empty()){ B = std::move(spare_.back()); spare_.pop_back(); }
+            else {
+                VkCommandBufferAllocateInfo cai{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+                cai.commandPool = xferPool_; cai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY; cai.commandBufferCount = 1;
+                vkAllocateCommandBuffers(dev_, &cai, &B.cmd);
+                VkFenceCreateInfo fci{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+                vkCreateFence(dev_, &fci, nullptr, &B.fence);
+            }
+            VkCommandBufferBeginInfo bi{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+            bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            vkBeginCommandBuffer(B.cmd, &bi);
+            cur_ = std::move(B); open_ = true;
+        }
+        return cur_;
+    }
+    void flush(){
+        vkEndCommandBuffer(cur_.cmd);
+        VkSubmitInfo si{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        si.commandBufferCount = 1; si.pCommandBuffers = &cur_.cmd;
+        vkQueueSubmit(xferQueue_, 1, &si, cur_.fence);
+        inFlight_.push_back(std::move(cur_));
+        cur_ = Batch{}; open_ = false;
+    }
+    // Release batches the GPU has finished (in submission order); `wait` blocks on each.
+    void collect(bool wait){
+        size_t freed = 0;
+        while(!inFlight_.empty()){
+            Batch& B = inFlight_.front();
+            if(wait) vkWaitForFences(dev_, 1, &B.fence, VK_TRUE, UINT64_MAX);
+            else if(vkGetFenceStatus(dev_, B.fence) != VK_SUCCESS) break;
+            ringUsed_ -= B.ringBytes;
+            for(const auto& r : B.retired){
+                vkDestroyImage(dev_, r.img, nullptr);
+                alloc_.free(r.mem);
+                retiring_ -= r.bytes; freed += r.bytes;
+            }
+            B.retired.clear(); B.ringBytes = 0;
+            vkResetFences(dev_, 1, &B.fence);
+            vkResetCommandBuffer(B.cmd, 0);
+            spare_.push_back(std::move(B));
+            inFlight_.pop_front();
+        }
+        if(freed && onFreed) onFreed(freed);
+    }
+    void retire(VkImage img, const BlockAllocation& mem, size_t bytes){
+        batch().retired.push_back({img, mem, bytes});
+        retiring_ += bytes;
+    }
+
+    // Reserve `bytes` of the staging ring, submitting and waiting on old batches if it's full.
+    size_t stage(size_t bytes){
+        bytes = (bytes + 15) & ~size_t(15);
+        for(;;){
+            if(ringUsed_ == 0) head_ = 0;
+            size_t tail = (head_ + stagingBytes - ringUsed_) % stagingBytes;
+            bool full = ringUsed_ == stagingBytes;
+            if(!full && head_ >= tail){
+                if(bytes <= stagingBytes - head_) return take(bytes, 0);
+                if(bytes <= tail) return take(bytes, stagingBytes - head_);     // wrap, waste the end
+            } else if(!full && bytes <= tail - head_) return take(bytes, 0);
+            if(open_) flush();
+            Batch& B = inFlight_.front();
+            vkWaitForFences(dev_, 1, &B.fence, VK_TRUE, UINT64_MAX);
+            collect(false);
+        }
+    }
+    size_t take(size_t bytes, size_t waste){
+        if(waste) head_ = 0;
+        size_t off = head_;
+        head_ = (head_ + bytes) % stagingBytes;
+        ringUsed_ += bytes + waste;
+        batch().ringBytes += bytes + waste;
+        return off;
+    }
+
+    // Level `l` of T's full chain into level `dst` of `img` (TRANSFER_DST), in ring-sized row bands.
+    void uploadLevel(const Tex& T, VkImage img, int l, int dst){
+        int w = T.levelW(l), h = T.levelH(l);
+        std::vector<uint8_t> px = T.src(l, w, h);
+        size_t row = (size_t)w*4;
+        int band = (int)std::max<size_t>(1, (stagingBytes/4) / row);
+        for(int y=0; y<h; y+=band){
+            int rows = std::min(band, h - y);
+            size_t bytes = row*rows, off = stage(bytes);
+            std::memcpy(mapped_ + off, px.data() + row*y, bytes);
+            VkBufferImageCopy c{};
+            c.bufferOffset = off;
+            c.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, (uint32_t)dst, 0, 1};
+            c.imageOffset = {0, y, 0};
+            c.imageExtent = {(uint32_t)w, (uint32_t)rows, 1};
+            vkCmdCopyBufferToImage(batch().cmd, staging_, img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &c);
+        }
+    }
+
+    void barrier(VkImage img, int base, int count, VkImageLayout from, VkImageLayout to){
+        recordBarrier(batch().cmd, img, base, count, from, to);
+    }
+    static void recordBarrier(VkCommandBuffer cmd, VkImage img, int base, int count, VkImageLayout from, VkImageLayout to){
+        VkImageMemoryBarrier b{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+        b.srcAccessMask = from==VK_IMAGE_LAYOUT_UNDEFINED ? 0u : (VkAccessFlags)VK_ACCESS_TRANSFER_WRITE_BIT;
+        b.dstAccessMask = to==VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ? 0u : (VkAccessFlags)(VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+        b.oldLayout = from; b.newLayout = to;
+        b.srcQueueFamilyIndex = b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.image = img;
+        b.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, (uint32_t)base, (uint32_t)count, 0, 1};
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &b);
+    }
+
+    VkInstance       inst_ = VK_NULL_HANDLE;
+    VkPhysicalDevice phys_ = VK_NULL_HANDLE;
+    VkDevice         dev_ = VK_NULL_HANDLE;
+    VkQueue          gfxQueue_ = VK_NULL_HANDLE, xferQueue_ = VK_NULL_HANDLE;
+    uint32_t         gfxFamily_ = 0, xferFamily_ = 0;
+    VkCommandPool    gfxPool_ = VK_NULL_HANDLE, xferPool_ = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memProps_{};
+    std::string      deviceName_;
+    bool             hasBudget_ = false;
+    int              fallbackMB_ = 0, localHeapMB_ = 0;
+
+    BlockAllocator   alloc_;
+    std::vector<std::vector<VkDeviceMemory>> blocks_;   // [memory type][block]
+    std::vector<Tex> tex_;
+    std::vector<Pad> pads_;
+
+    VkBuffer         staging_ = VK_NULL_HANDLE;
+    VkDeviceMemory   stagingMem_ = VK_NULL_HANDLE;
+    uint8_t*         mapped_ = nullptr;
+    size_t           head_ = 0, ringUsed_ = 0;
+
+    Batch             cur_;
+    bool              open_ = false;
+    std::deque<Batch> inFlight_;
+    std::vector<Batch> spare_;
+    size_t            retiring_ = 0;
+};
@@ -0,0 +1,428 @@
+// Volume — governed 3D textures: 16-bit slice stacks in bricks with per-brick mip level
+// - A VolumeData is a w x h x d stack of 16-bit samples (CT/MR slices, or a built-in phantom)
+//   plus its box-filtered 3D mip pyramid, kept in system memory
+// - The GPU copy is split into brick x brick x brick bricks; each brick is a GL_TEXTURE_3D
+//   holding a single level of the pyramid (its own mip level) plus a one-voxel border, so
+//   bricks at different levels still filter seamlessly. Each brick is one governor object:
+//   one level step frees ~7/8 of it (setLevelShrink 8)
+// - Footprint comes from the storage format (GL_R16 or GL_R16F, 2 bytes per voxel) through
+//   the ledger; replaced bricks are retired like any other governed storage
+// - VolumeRenderer ray-marches the bricks (maximum intensity projection: bricks composite in
+//   any order with GL_MAX blending) and has a density-metric variant: voxels per pixel at the
+//   ray entry point, written into the same RG16F target as the 2D objects. A metric pixel
+//   holds one brick, but every brick along the ray shows, so brick coverage is the projected
+//   box (brickArea) rather than the metric's pixel count
+// - loadSliceStack reads a directory of 16-bit PNG slices (DICOM exported with e.g. dcmj2pnm
+//   or gdcm; there is no DICOM parser here), sorted by file name
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+
+#include <GL/glew.h>
+
+#include "ledger.h"
+#include "residency.h"
+#include "stb_image.h"
+
+// =================== CPU volume ===================
+struct VolumeData {
+    int w=0, h=0, d=0;
+    float spacing[3] = {1.f, 1.f, 1.f};         // voxel size (mm), x y z
+    std::vector<std::vector<uint16_t>> levels;  // [0] is full resolution
+
+    int dim(int axis, int l) const { return std::max(1, (axis==0 ? w : axis==1 ? h : d) >> l); }
+    uint16_t at(int l, int x, int y, int z) const {
+        int lw=dim(0,l), lh=dim(1,l), ld=dim(2,l);
+        x=std::clamp(x,0,lw-1); y=std::clamp(y,0,lh-1); z=std::clamp(z,0,ld-1);
+        return levels[l][((size_t)z*lh + y)*lw + x];
+    }
+    size_t bytes() const { size_t b=0; for(const auto& L : levels) b += L.size()*sizeof(uint16_t); return b; }
+};
+
+// 2x2x2 box filter down to 1x1x1 (odd sizes clamp at the edge).
+inline void buildVolumePyramid(VolumeData& V){
+    V.levels.resize(1);
+    for(int l=1; V.dim(0,l-1)>1 || V.dim(1,l-1)>1 || V.dim(2,l-1)>1; ++l){
+        int lw=V.dim(0,l), lh=V.dim(1,l), ld=V.dim(2,l);
+        std::vector<uint16_t> L((size_t)lw*lh*ld);
+        for(int z=0;z<ld;++z) for(int y=0;y<lh;++y) for(int x=0;x<lw;++x){
+            uint32_t s=0;
+            for(int k=0;k<8;++k) s += V.at(l-1, 2*x+(k&1), 2*y+((k>>1)&1), 2*z+(k>>2));
+            L[((size_t)z*lh + y)*lw + x] = (uint16_t)((s+4)/8);
+        }
+        V.levels.push_back(std::move(L));
+    }
+}
+
+// Nested ellipsoids with a few dense inclusions: enough structure to see the mip level.
+inline VolumeData makeVolumePhantom(int w=256, int h=256, int d=192){
+    VolumeData V; V.w=w; V.h=h; V.d=d;
+    V.levels.assign(1, std::vector<uint16_t>((size_t)w*h*d));
+    struct Blob { float cx,cy,cz, rx,ry,rz, value; };
+    const Blob blobs[] = {
+        {0.50f,0.50f,0.50f, 0.46f,0.40f,0.46f, 12000.f},   // body
+        {0.50f,0.50f,0.50f, 0.40f,0.34f,0.40f, -4000.f},   // soft tissue inside
+        {0.35f,0.45f,0.55f, 0.10f,0.14f,0.20f, 30000.f},
+        {0.65f,0.45f,0.45f, 0.08f,0.08f,0.25f, 45000.f},
+        {0.52f,0.70f,0.50f, 0.03f,0.03f,0.30f, 60000.f},   // thin bright rod
+    };
+    for(int z=0;z<d;++z) for(int y=0;y<h;++y) for(int x=0;x<w;++x){
+        float p[3] = {(x+0.5f)/w, (y+0.5f)/h, (z+0.5f)/d}, v=0.f;
+        for(const Blob& b : blobs){
+            float dx=(p[0]-b.cx)/b.rx, dy=(p[1]-b.cy)/b.ry, dz=(p[2]-b.cz)/b.rz;
+            if(dx*dx+dy*dy+dz*dz <= 1.f) v += b.value;
+        }
+        v += 1500.f * std::sin(40.f*p[0]) * std::sin(40.f*p[1]) * std::sin(40.f*p[2]) * (v>0.f);   // texture
+        V.levels[0][((size_t)z*h + y)*w + x] = (uint16_t)std::clamp(v, 0.f, 65535.f);
+    }
+    buildVolumePyramid(V);
+    return V;
+}
+
+// Every *.png in `dir`, in file-name order, as one slice (8-bit slices are widened by stb).
+inline bool loadSliceStack(const std::string& dir, VolumeData& V, float sliceSpacing=1.f){
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    std::vector<fs::path> files;
+    for(const auto& e : fs::directory_iterator(dir, ec))
+        if(e.is_regular_file() && e.path().extension()==".png") files.push_back(e.path());
+    if(ec || files.empty()){ std::fprintf(stderr,"[Volume] no .png slices in '%s'\n", dir.c_str()); return false; }
+    std::sort(files.begin(), files.end());
+
+    V = VolumeData{};
+    for(const auto& f : files){
+        int w=0, h=0, c=0;
+        stbi_us* px = stbi_load_16(f.string().c_str(), &w, &h, &c, 1);
+        if(!px){ std::fprintf(stderr,"[Volume] %s: %s\n", f.string().c_str(), stbi_failure_reason()); continue; }
+        if(V.d==0){ V.w=w; V.h=h; V.levels.assign(1, {}); }
+        if(w!=V.w || h!=V.h){
+            std::fprintf(stderr,"[Volume] %s: %dx%d, expected %dx%d (skipped)\n", f.string().c_str(), w, h, V.w, V.h);
+            stbi_image_free(px); continue;
+        }
+        V.levels[0].insert(V.levels[0].end(), px, px + (size_t)w*h);
+        ++V.d;
+        stbi_image_free(px);
+    }
+    if(V.d==0) return false;
+    V.spacing[2] = sliceSpacing;
+    buildVolumePyramid(V);
+    std::printf("[Volume] %s: %dx%dx%d, %.1f MB in system memory with mips\n", dir.c_str(), V.w, V.h, V.d, V.bytes()/(1024.0*1024.0));
+    return true;
+}
+
+// =================== Bricks ===================
+struct VolumeBrick {
+    int    bx=0, by=0, bz=0;
+    int    id=-1;               // governor object
+    int    level=-1;            // pyramid level held (-1: none)
+    GLuint tex=0;
+    int    o[3]={}, n[3]={};    // origin and size in voxels of that level (border excluded)
+    size_t bytes=0;
+};
+
+struct GovVolume {
+    VolumeData data;
+    GLenum format = GL_R16;     // or GL_R16F
+    int    brick  = 64;         // level-0 voxels per brick edge
+    int    levels = 0;          // levels a brick can be at: full res down to 1 voxel
+    int    grid[3] = {};
+    std::vector<VolumeBrick> bricks;
+
+    bool   loaded() const { return !bricks.empty(); }
+    double residentMB() const { size_t b=0; for(const auto& k : bricks) b+=k.bytes; return b/(1024.0*1024.0); }
+    // Storage a brick takes at `level`: the level's voxels plus the border, no mips.
+    size_t brickBytes(const VolumeBrick& k, int level) const {
+        int n[3]; brickExtent(k, level, nullptr, n);
+        return (size_t)(n[0]+2)*(n[1]+2)*(n[2]+2)*bytesPerTexel(format);
+    }
+    void brickExtent(const VolumeBrick& k, int level, int* o, int* n) const {
+        const int b[3] = {k.bx, k.by, k.bz};
+        for(int a=0;a<3;++a){
+            int ld = data.dim(a, level);
+            int oa = std::min((b[a]*brick) >> level, ld-1);
+            int na = std::clamp(std::min(std::max(1, brick>>level), ld-oa), 1, ld);
+            if(o) o[a]=oa;
+            n[a]=na;
+        }
+    }
+};
+
+// (Re)upload brick k at `level`; the old storage is retired. Returns false if nothing changed.
+inline bool setBrickLevel(GovVolume& V, VolumeBrick& k, int level){
+    level = std::clamp(level, 0, V.levels-1);
+    if(level==k.level && k.tex) return false;
+    VG_ZONE("volume.brick");
+    int o[3], n[3]; V.brickExtent(k, level, o, n);
+    int tw=n[0]+2, th=n[1]+2, td=n[2]+2;
+
+    // Staging with a one-voxel border taken from the neighbours (clamped at the volume edge).
+    bool half = V.format==GL_R16F;
+    std::vector<uint16_t> u16; std::vector<float> f32;
+    if(half) f32.resize((size_t)tw*th*td); else u16.resize((size_t)tw*th*td);
+    for(int z=0;z<td;++z) for(int y=0;y<th;++y) for(int x=0;x<tw;++x){
+        uint16_t s = V.data.at(level, o[0]+x-1, o[1]+y-1, o[2]+z-1);
+        size_t i = ((size_t)z*th + y)*tw + x;
+        if(half) f32[i] = s / 65535.f; else u16[i] = s;
+    }
+
+    if(k.tex) gRetire.retire(k.tex, k.bytes);
+    k.tex = trackedTexStorage3D(MemTag::Governed, 1, V.format, tw, th, td);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, half ? 4 : 2);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0,0,0, tw,th,td, GL_RED, half ? GL_FLOAT : GL_UNSIGNED_SHORT,
+                    half ? (const void*)f32.data() : (const void*)u16.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    std::copy(o, o+3, k.o); std::copy(n, n+3, k.n);
+    k.level = level;
+    k.bytes = (size_t)tw*th*td*bytesPerTexel(V.format);
+    return true;
+}
+
+inline int brickCount(const VolumeData& D, int brick=64){
+    return ((D.w + brick-1)/brick) * ((D.h + brick-1)/brick) * ((D.d + brick-1)/brick);
+}
+
+// Lays out the brick grid and uploads brick i at startLevel(i) (governor ids are the caller's).
+inline void createGovVolume(GovVolume& V, VolumeData data, GLenum format=GL_R16, int brick=64,
+                            const std::function<int(int)>& startLevel = nullptr){
+    V.data = std::move(data); V.format = format; V.brick = brick;
+    V.levels = std::clamp(1 + (int)std::log2((double)brick), 1, (int)V.data.levels.size());    // small volumes have a shorter pyramid
+    V.grid[0] = (V.data.w + brick-1)/brick; V.grid[1] = (V.data.h + brick-1)/brick; V.grid[2] = (V.data.d + brick-1)/brick;
+    V.bricks.clear();
+    for(int z=0;z<V.grid[2];++z) for(int y=0;y<V.grid[1];++y) for(int x=0;x<V.grid[0];++x){
+        VolumeBrick k; k.bx=x; k.by=y; k.bz=z;
+        setBrickLevel(V, k, startLevel ? startLevel((int)V.bricks.size()) : 0);
+        V.bricks.push_back(k);
+    }
+    std::printf("[Volume] %dx%dx%d %s in %dx%dx%d bricks of %d, %.1f MB resident\n", V.data.w, V.data.h, V.data.d,
+        format==GL_R16F ? "R16F" : "R16", V.grid[0], V.grid[1], V.grid[2], brick, V.residentMB());
+}
+
+inline void destroyGovVolume(GovVolume& V){
+    for(auto& k : V.bricks){ gRetire.retire(k.tex, k.bytes); k.tex=0; k.bytes=0; k.level=-1; }
+    V.bricks.clear();
+}
+
+// =================== Ray-march renderer ===================
+// Positions are in volume space v in [0,1]^3; the model matrix scales the unit cube to the
+// physical extent (spacing * dims, longest side 1) centred on the origin.
+inline const char* kVolumeVS = R"(#version 330 core
+layout(location=0) in vec3 aPos;
+uniform mat4 uMVP;
+uniform vec3 uBoxMin, uBoxMax;
+out vec3 vPos;
+void main(){ vPos = mix(uBoxMin, uBoxMax, aPos); gl_Position = uMVP * vec4(vPos, 1.0); })";
+
+// Back faces of the brick box (front faces culled), so the ray also works from inside it.
+inline const char* kVolumeFS = R"(#version 330 core
+in vec3 vPos;
+out vec4 outColor;
+uniform sampler3D uBrick;
+uniform vec3  uCam;                 // camera in volume space
+uniform vec3  uBoxMin, uBoxMax;
+uniform vec3  uTexScale, uTexOff;   // volume space -> brick texture coords at the brick's level
+uniform float uStep;                // half a voxel of the brick's level
+uniform vec2  uWindow;              // centre, width
+void main(){
+    vec3 dir = normalize(vPos - uCam);
+    vec3 inv = 1.0 / dir;
+    vec3 t0 = (uBoxMin - uCam) * inv, t1 = (uBoxMax - uCam) * inv;
+    float tn = max(max(min(t0.x,t1.x), min(t0.y,t1.y)), min(t0.z,t1.z));
+    float tf = min(min(max(t0.x,t1.x), max(t0.y,t1.y)), max(t0.z,t1.z));
+    float m = 0.0;
+    float t = max(tn, 0.0);
+    for(int i=0; i<512 && t<tf; ++i, t+=uStep)
+        m = max(m, textureLod(uBrick, (uCam + t*dir) * uTexScale + uTexOff, 0.0).r);
+    float g = clamp((m - uWindow.x) / uWindow.y + 0.5, 0.0, 1.0);
+    outColor = vec4(vec3(g), 1.0);
+})";
+
+// Metric variant (front faces): level-0 voxels per full-res pixel where the ray enters.
+inline const char* kVolumeDensityFS = R"(#version 330 core
+in vec3 vPos;
+layout(location=0) out vec2 outMetric;
+uniform vec3  uDims;                // level-0 voxel counts
+uniform float uPixelScale;
+uniform float uId;
+void main(){
+    vec3 p = vPos * uDims;
+    float rho = max(length(dFdx(p)), length(dFdy(p))) / uPixelScale;
+    outMetric = vec2(clamp(log2(max(rho, 1e-8)), -8.0, 16.0), uId + 1.0);
+})";
+
+class VolumeRenderer {
+public:
+    float yaw = 0.6f, pitch = 0.35f, distance = 2.0f, fovY = 0.8f;
+    float windowCentre = 0.35f, windowWidth = 0.7f;
+
+    bool init(GLuint (*compile)(GLenum, const char*), GLuint (*link)(GLuint, GLuint)){
+        GLuint vs = compile(GL_VERTEX_SHADER, kVolumeVS);
+        GLuint fs = compile(GL_FRAGMENT_SHADER, kVolumeFS), dfs = compile(GL_FRAGMENT_SHADER, kVolumeDensityFS);
+        prog_ = link(vs, fs); metric_ = link(vs, dfs);
+        glDeleteShader(vs); glDeleteShader(fs); glDeleteShader(dfs);
+        static const float cube[] = {   // 12 triangles, outward CCW
+            0,0,1, 1,0,1, 1,1,1,  0,0,1, 1,1,1, 0,1,1,   1,0,0, 0,0,0, 0,1,0,  1,0,0, 0,1,0, 1,1,0,
+            0,0,0, 0,0,1, 0,1,1,  0,0,0, 0,1,1, 0,1,0,   1,0,1, 1,0,0, 1,1,0,  1,0,1, 1,1,0, 1,1,1,
+            0,1,1, 1,1,1, 1,1,0,  0,1,1, 1,1,0, 0,1,0,   0,0,0, 1,0,0, 1,0,1,  0,0,0, 1,0,1, 0,0,1 };
+        glGenBuffers(1,&vbo_); glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+        trackedBufferData(MemTag::Geometry, GL_ARRAY_BUFFER, vbo_, sizeof(cube), cube, GL_STATIC_DRAW);
+        glGenVertexArrays(1,&vao_); glBindVertexArray(vao_);
+        glEnableVertexAttribArray(0); glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,sizeof(float)*3,(void*)0);
+        glBindVertexArray(0); glBindBuffer(GL_ARRAY_BUFFER,0);
+        return prog_ && metric_;
+    }
+    void shutdown(){
+        if(vao_) glDeleteVertexArrays(1,&vao_);
+        if(vbo_) trackedDeleteBuffers(1,&vbo_);
+        if(prog_) glDeleteProgram(prog_);
+        if(metric_) glDeleteProgram(metric_);
+        vao_=vbo_=prog_=metric_=0;
+    }
+
+    // Camera and projection for a pane of w x h pixels.
+    void setView(const GovVolume& V, int w, int h){
+        const VolumeData& D = V.data;
+        float ext[3] = { D.w*D.spacing[0], D.h*D.spacing[1], D.d*D.spacing[2] };
+        float e = std::max({ext[0], ext[1], ext[2]});
+        float model[16] = { ext[0]/e,0,0,0, 0,ext[1]/e,0,0, 0,0,ext[2]/e,0, -0.5f*ext[0]/e,-0.5f*ext[1]/e,-0.5f*ext[2]/e,1 };
+        float eye[3] = { distance*std::cos(pitch)*std::sin(yaw), distance*std::sin(pitch), distance*std::cos(pitch)*std::cos(yaw) };
+        float view[16], proj[16], vp[16];
+        lookAt(eye, view);
+        perspective(fovY, (float)w/std::max(1,h), 0.05f, 10.f, proj);
+        mul(proj, view, vp); mul(vp, model, mvp_);
+        for(int a=0;a<3;++a) cam_[a] = eye[a]/(ext[a]/e) + 0.5f;       // inverse of the model matrix
+    }
+
+    // Visible pass into pane (x,y,w,h) of the framebuffer; clears the pane to black first.
+    void draw(const GovVolume& V, int x, int y, int w, int h){
+        glViewport(x,y,w,h);
+        glEnable(GL_SCISSOR_TEST); glScissor(x,y,w,h);
+        glClearColor(0.f,0.f,0.f,1.f); glClear(GL_COLOR_BUFFER_BIT);
+        glDisable(GL_SCISSOR_TEST);
+        glEnable(GL_BLEND); glBlendEquation(GL_MAX); glBlendFunc(GL_ONE, GL_ONE);
+        glEnable(GL_CULL_FACE); glCullFace(GL_FRONT);
+        glUseProgram(prog_);
+        glUniformMatrix4fv(loc(prog_,"uMVP"), 1, GL_FALSE, mvp_);
+        glUniform3fv(loc(prog_,"uCam"), 1, cam_);
+        glUniform2f(loc(prog_,"uWindow"), windowCentre, windowWidth);
+        glUniform1i(loc(prog_,"uBrick"), 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(vao_);
+        for(const auto& k : V.bricks){
+            if(!k.tex) continue;
+            float bmin[3], bmax[3], scale[3], off[3];
+            boxOf(V, k, bmin, bmax);
+            float lmax = 1.f;
+            for(int a=0;a<3;++a){
+                float ld = (float)V.data.dim(a, k.level), tn = (float)(k.n[a]+2);
+                scale[a] = ld/tn; off[a] = (1.f - k.o[a])/tn;
+                lmax = std::max(lmax, ld);
+            }
+            glUniform3fv(loc(prog_,"uBoxMin"), 1, bmin); glUniform3fv(loc(prog_,"uBoxMax"), 1, bmax);
+            glUniform3fv(loc(prog_,"uTexScale"), 1, scale); glUniform3fv(loc(prog_,"uTexOff"), 1, off);
+            glUniform1f(loc(prog_,"uStep"), 0.5f/lmax);
+            glBindTexture(GL_TEXTURE_3D, k.tex);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
+        glBindTexture(GL_TEXTURE_3D, 0);
+        glBindVertexArray(0);
+        glDisable(GL_CULL_FACE);
+        glBlendEquation(GL_FUNC_ADD); glDisable(GL_BLEND);
+    }
+
+    // Metric pass, inside DensityProbe::begin()/end(): pane in framebuffer pixels.
+    void drawMetric(const GovVolume& V, int x, int y, int w, int h, int downscale){
+        glViewport(x/downscale, y/downscale, std::max(1, w/downscale), std::max(1, h/downscale));
+        glEnable(GL_CULL_FACE); glCullFace(GL_BACK);
+        glUseProgram(metric_);
+        glUniformMatrix4fv(loc(metric_,"uMVP"), 1, GL_FALSE, mvp_);
+        glUniform3f(loc(metric_,"uDims"), (float)V.data.w, (float)V.data.h, (float)V.data.d);
+        glUniform1f(loc(metric_,"uPixelScale"), (float)downscale);
+        glBindVertexArray(vao_);
+        for(const auto& k : V.bricks){
+            if(k.id<0) continue;
+            float bmin[3], bmax[3]; boxOf(V, k, bmin, bmax);
+            glUniform3fv(loc(metric_,"uBoxMin"), 1, bmin); glUniform3fv(loc(metric_,"uBoxMax"), 1, bmax);
+            glUniform1f(loc(metric_,"uId"), (float)k.id);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
+        glBindVertexArray(0);
+        glDisable(GL_CULL_FACE);
+    }
+
+    // Screen rect (framebuffer pixels) of brick k inside pane (x,y,w,h); false if behind the camera.
+    bool brickRect(const GovVolume& V, const VolumeBrick& k, int x, int y, int w, int h, float& x0, float& y0, float& x1, float& y1) const {
+        float bmin[3], bmax[3]; boxOf(V, k, bmin, bmax);
+        x0=y0=1e30f; x1=y1=-1e30f;
+        for(int c=0;c<8;++c){
+            float p[3] = { c&1 ? bmax[0] : bmin[0], c&2 ? bmax[1] : bmin[1], c&4 ? bmax[2] : bmin[2] };
+            float cx=0, cy=0, cw=0;
+            for(int a=0;a<3;++a){ cx += mvp_[4*a]*p[a]; cy += mvp_[4*a+1]*p[a]; cw += mvp_[4*a+3]*p[a]; }
+            cx += mvp_[12]; cy += mvp_[13]; cw += mvp_[15];
+            if(cw <= 1e-4f) return false;
+            float sx = x + (cx/cw*0.5f + 0.5f)*w, sy = y + (cy/cw*0.5f + 0.5f)*h;
+            x0=std::min(x0,sx); y0=std::min(y0,sy); x1=std::max(x1,sx); y1=std::max(y1,sy);
+        }
+        return true;
+    }
+    // Pixels of pane (x,y,w,h) brick k's box projects onto, occluded or not (0 off screen).
+    float brickArea(const GovVolume& V, const VolumeBrick& k, int x, int y, int w, int h) const {
+        float x0,y0,x1,y1;
+        if(!brickRect(V, k, x,y,w,h, x0,y0,x1,y1)) return 0.f;
+        float cw = std::min(x1,(float)(x+w)) - std::max(x0,(float)x), ch = std::min(y1,(float)(y+h)) - std::max(y0,(float)y);
+        return cw > 0.f && ch > 0.f ? cw*ch : 0.f;
+    }
+
+private:
+    static GLint loc(GLuint p, const char* n){ return glGetUniformLocation(p, n); }
+
+    // Brick bounds in volume space, from its level-0 origin (independent of its current level).
+    static void boxOf(const GovVolume& V, const VolumeBrick& k, float* bmin, float* bmax){
+        const int b[3] = {k.bx, k.by, k.bz};
+        for(int a=0;a<3;++a){
+            float dim = (float)V.data.dim(a, 0);
+            bmin[a] = std::min((float)(b[a]*V.brick), dim) / dim;
+            bmax[a] = std::min((float)((b[a]+1)*V.brick), dim) / dim;
+        }
+    }
+
+    // Column-major 4x4 helpers.
+    static void mul(const float* a, const float* b, float* r){
+        float t[16];
+        for(int c=0;c<4;++c) for(int i=0;i<4;++i){ float s=0; for(int k=0;k<4;++k) s += a[4*k+i]*b[4*c+k]; t[4*c+i]=s; }
+        std::copy(t, t+16, r);
+    }
+    static void perspective(float fovy, float aspect, float zn, float zf, float* m){
+        float f = 1.f/std::tan(fovy*0.5f);
+        std::fill(m, m+16, 0.f);
+        m[0]=f/aspect; m[5]=f; m[10]=(zf+zn)/(zn-zf); m[11]=-1.f; m[14]=2.f*zf*zn/(zn-zf);
+    }
+    static void lookAt(const float* eye, float* m){       // looking at the origin, +y up
+        float f[3] = {-eye[0], -eye[1], -eye[2]};
+        float fl = std::sqrt(f[0]*f[0]+f[1]*f[1]+f[2]*f[2]); for(float& v : f) v/=fl;
+        float s[3] = { -f[2], 0.f, f[0] };                 // f x up
+        float sl = std::max(1e-6f, std::sqrt(s[0]*s[0]+s[2]*s[2])); s[0]/=sl; s[2]/=sl;
+        float u[3] = { s[1]*f[2]-s[2]*f[1], s[2]*f[0]-s[0]*f[2], s[0]*f[1]-s[1]*f[0] };
+        float r[16] = { s[0],u[0],-f[0],0, s[1],u[1],-f[1],0, s[2],u[2],-f[2],0, 0,0,0,1 };
+        for(int i=0;i<3;++i) r[12+i] = -(r[i]*eye[0] + r[4+i]*eye[1] + r[8+i]*eye[2]);
+        std::copy(r, r+16, m);
+    }
+
+    GLuint prog_=0, metric_=0, vao_=0, vbo_=0;
+    float  mvp_[16] = {};
+    float  cam_[3] = {};
+};
+
+inline VolumeRenderer gVolumeRenderer;
@@ -0,0 +1,299 @@
+// vram_bench — headless replay of a scripted allocation/visibility timeline
+// - Fixed simulated time step, so runs are comparable between builds on the same GPU
+// - The governor and admission drive a GpuBackend: --backend=gl (hidden GLFW window, offscreen
+//   1280x720 target, vsync off; same residency / ledger / telemetry code as the demo) or
+//   --backend=vk (VK_EXT_memory_budget, block suballocation, transfer queue; headless, needs
+//   a VG_VULKAN build). Objects are procedural checkers, pads are committed 8K RGBA8 chains
+//   requested through admission
+// - Per frame: freeMB, pending/waiting, steps taken, bias per object, CPU/GPU frame time and
+//   the governor's own CPU time -> <out>.csv
+// - Per pressure event (pad +N, target change): once a sample read after the event shows freeMB
+//   below the band, the time until a later sample is back in it -> <out>.json, with run totals
+//
+// Script (one action per line, '#' comments, times in simulated seconds):
+//   0.0  objects 24 512 4096   # N objects, sizes from min to max (priorities cycle L/N/H)
+//   1.0  pad +4                # request 4 pads;  pad -2 frees two
+//   4.0  hide 0-7              # visibility by object id range; show 0-7
+//   6.0  target 1536           # targetFreeMB
+//   20.0 end
+// Usage: vram_bench [script] [--out=prefix] [--policy=buckets|knapsack]
+//                   [--control=band|predictive|pid] [--backend=gl|vk] [--fallback=MB] [--dt=seconds]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <algorithm>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "residency.h"
+#include "governor.h"
+#include "admission.h"
+#include "ledger.h"
+#include "backend.h"
+#include "gl_backend.h"
+#ifdef VG_VULKAN
+#include "vk_backend.h"
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+// =================== Script ===================
+struct Action { double t; std::string op; int a=0, b=0, c=0; };
+
+static const char* kDefaultScript = R"(
+0.0  objects 24 512 4096
+1.0  pad +4
+4.0  pad +4
+7.0  hide 0-7
+9.0  show 0-7
+11.0 pad -6
+13.0 target 1536
+16.0 pad +3
+20.0 end
+)";
+
+static std::vector<Action> parseScript(std::istream& in){
+    std::vector<Action> out;
+    std::string line;
+    while(std::getline(in, line)){
+        line = line.substr(0, line.find('#'));
+        std::istringstream ss(line);
+        Action A; std::string arg;
+        if(!(ss >> A.t >> A.op)) continue;
+        if(A.op=="objects"){ ss >> A.a; if(!(ss >> A.b >> A.c)){ A.b=512; A.c=4096; } }
+        else if(A.op=="pad" || A.op=="target"){ ss >> A.a; }
+        else if(A.op=="hide" || A.op=="show"){
+            ss >> arg; size_t d = arg.find('-');
+            A.a = std::atoi(arg.c_str()); A.b = d==std::string::npos ? A.a : std::atoi(arg.c_str()+d+1);
+        }
+        else if(A.op!="end"){ std::fprintf(stderr,"[Script] unknown action '%s'\n", A.op.c_str()); continue; }
+        out.push_back(A);
+    }
+    std::stable_sort(out.begin(), out.end(), [](const Action& x, const Action& y){ return x.t < y.t; });
+    return out;
+}
+
+// =================== Scene ===================
+static LevelSource checkerSource(int chk){
+    return [chk](int level,int w,int h){
+        int c = std::max(1, chk >> level);
+        std::vector<uint8_t> v((size_t)w*h*4);
+        for(int y=0;y<h;++y) for(int x=0;x<w;++x){
+            uint8_t t = (((x/c)^(y/c))&1) ? 230 : 30;
+            size_t i=((size_t)y*w+x)*4; v[i]=v[i+1]=v[i+2]=t; v[i+3]=255;
+        }
+        return v;
+    };
+}
+
+static const int PAD_DIM = 8192;
+static double padMB(){ return chainBytes(GL_RGBA8, PAD_DIM, PAD_DIM, mipLevelsFor(PAD_DIM, PAD_DIM)) / (1024.0*1024.0); }
+
+// =================== State ===================
+static Governor          gGov;
+static AdmissionControl  gAdmit(gGov);
+static std::unique_ptr<GpuBackend> gBackend;
+static std::vector<int>  gTex;      // backend texture, indexed by governor id
+static std::vector<int>  gPads;     // live backend pads
+static double            gNow = 0.0;
+
+static void syncResidency(){
+    GpuBackend& B = *gBackend;
+    B.setPressure(gGov.underPressure);
+    for(int i=0;i<(int)gTex.size();++i){
+        int t = gTex[i], top = B.residentTop(t), levels = B.levels(t);
+        int want = gGov.visible(i) ? gGov.wantedTop(i) : levels-1;
+        if(want < top){
+            double growMB = (double)(B.bytesAt(t, want) - B.bytesAt(t, top)) / (1024.0*1024.0);
+            if(!gAdmit.tryAdmit(growMB, gGov.priority(i), gNow)) want = top;
+        }
+        B.setResidentTop(t, want);
+        gGov.setFootprint(i, (float)(B.bytesAt(t, B.residentTop(t))/(1024.0*1024.0)), B.residentTop(t), levels);
+    }
+}
+
+// =================== Recording ===================
+struct Event   { double t; std::string what; double leftAt=-1.0, recoveredAt=-1.0; };
+struct Summary { int frames=0, steps=0; double cpuMs=0, gpuMs=0, govUs=0, maxBias=0; int minFreeMB=1<<30; };
+
+static std::string jsonEscape(const std::string& s){
+    std::string o; for(char c : s){ if(c=='"'||c=='\\') o+='\\'; o+=c; } return o;
+}
+
+int main(int argc, char** argv){
+    std::string scriptPath, out = "vram_bench", policy = "buckets", control = "band", backend = "gl";
+    int fallbackMB = 0; double dt = 1.0/60.0;
+    for(int i=1;i<argc;++i){
+        std::string a = argv[i];
+        auto val = [&](const char* k){ return a.rfind(k,0)==0 ? a.substr(std::string(k).size()) : std::string(); };
+        if(!val("--out=").empty()) out = val("--out=");
+        else if(!val("--policy=").empty()) policy = val("--policy=");
+        else if(!val("--control=").empty()) control = val("--control=");
+        else if(!val("--backend=").empty()) backend = val("--backend=");
+        else if(!val("--fallback=").empty()) fallbackMB = std::atoi(val("--fallback=").c_str());
+        else if(!val("--dt=").empty()) dt = std::max(1e-3, std::atof(val("--dt=").c_str()));
+        else if(a.rfind("--",0)!=0) scriptPath = a;
+        else { std::fprintf(stderr,"usage: %s [script] [--out=prefix] [--policy=buckets|knapsack] [--control=band|predictive|pid] [--backend=gl|vk] [--fallback=MB] [--dt=s]\n", argv[0]); return 2; }
+    }
+    std::vector<Action> script;
+    if(scriptPath.empty()){ std::istringstream ss(kDefaultScript); script = parseScript(ss); }
+    else {
+        std::ifstream f(scriptPath);
+        if(!f){ std::fprintf(stderr,"[Script] can't open %s\n", scriptPath.c_str()); return 1; }
+        script = parseScript(f);
+    }
+
+#ifdef VG_VULKAN
+    if(backend=="vk") gBackend = std::make_unique<VkBackend>();
+#endif
+    if(backend=="gl") gBackend = std::make_unique<GlBackend>();
+    if(!gBackend){ std::fprintf(stderr,"[Bench] backend '%s' is not built (configure with -DVG_VULKAN=ON for vk)\n", backend.c_str()); return 2; }
+    if(!gBackend->init(fallbackMB)) return 1;
+    std::printf("[Bench] %s backend | %s\n", gBackend->name(), gBackend->device().c_str());
+    gBackend->onFreed = [](size_t bytes){ gGov.announceFree(bytes/(1024.0*1024.0), gNow); };
+    gGov.verbose = false;
+    if(policy=="knapsack") gGov.policy = std::make_unique<KnapsackPolicy>();
+    gGov.setControl(control=="pid" ? ControlMode::PID : control=="predictive" ? ControlMode::Predictive : ControlMode::Band);
+    gAdmit.applyShed = syncResidency;
+
+    // One bias column per object the script will ever add, so every row matches the header.
+    int objectCols = 0;
+    for(const auto& A : script) if(A.op=="objects") objectCols += std::max(0, A.a);
+    std::FILE* csv = std::fopen((out + ".csv").c_str(), "w");
+    if(!csv){ std::fprintf(stderr,"can't write %s.csv\n", out.c_str()); return 1; }
+    std::fprintf(csv, "frame,t,freeMB,valid,targetFreeMB,pendingMB,waiting,pads,ledgerMB,steps,cpuMs,gpuMs,govUs");
+    for(int i=0;i<objectCols;++i) std::fprintf(csv, ",b%d", i);
+    std::fprintf(csv, "\n");
+
+    std::vector<Event> events;
+    std::vector<float> prevBias;
+    std::vector<GridDraw> draws;
+    const char* telSource = "none";
+    Summary S;
+    size_t next = 0;
+    double endT = script.empty() ? 10.0 : script.back().t;
+    for(const auto& A : script) if(A.op=="end") endT = A.t;
+
+    for(uint64_t frame=0;; ++frame){
+        double t = frame * dt;
+        if(t > endT) break;
+        gNow = t;
+        auto f0 = Clock::now();
+
+        // Script actions due this frame
+        for(; next<script.size() && script[next].t <= t; ++next){
+            const Action& A = script[next];
+            if(A.op=="objects"){
+                for(int k=0;k<A.a;++k){
+                    int id = gGov.add((Priority)(k%3));
+                    int lo = (int)std::log2(std::max(1,A.b)), hi = (int)std::log2(std::max(A.b,A.c));
+                    int dim = 1 << (lo + (hi>lo ? (k*7)%(hi-lo+1) : 0));
+                    int tex = gBackend->createTexture(dim, dim, checkerSource(32), 0);
+                    if(tex < 0){ std::fprintf(stderr,"[Bench] can't create object %d (%dx%d)\n", id, dim, dim); gBackend->shutdown(); return 1; }
+                    gTex.push_back(tex);
+                    gGov.setFootprint(id, (float)(gBackend->bytesAt(tex, 0)/(1024.0*1024.0)), 0, gBackend->levels(tex));
+                }
+            } else if(A.op=="pad"){
+                if(A.a > 0){
+                    for(int k=0;k<A.a;++k) gAdmit.request(padMB(), Priority::Normal, t, []{ int p = gBackend->createPad(PAD_DIM); if(p >= 0) gPads.push_back(p); }, "pad");
+                    events.push_back({t, "pad +" + std::to_string(A.a)});
+                } else for(int k=0;k<-A.a && !gPads.empty();++k){ gBackend->destroyPad(gPads.back()); gPads.pop_back(); }
+            } else if(A.op=="hide" || A.op=="show"){
+                for(int i=std::max(0,A.a); i<=A.b && i<(int)gGov.size(); ++i) gGov.setVisible(i, A.op=="show");
+            } else if(A.op=="target"){
+                gGov.targetFreeMB = A.a;
+                events.push_back({t, "target " + std::to_string(A.a)});
+            }
+        }
+
+        // Governor tick (timed: this is what the governor costs per frame on the CPU, the
+        // budget read and the retirement pump included, as in VramGovernor::frame)
+        auto g0 = Clock::now();
+        BudgetSample tel = gBackend->sampleBudget(t);
+        telSource = tel.source;
+        gBackend->beginFrame();
+        gGov.setRetiringMB(gBackend->retiringMB());
+        gGov.setGpuTime(gBackend->avgGpuMs());
+        gGov.evaluate(t, tel.freeMB, tel.valid);
+        gAdmit.service(t);
+        syncResidency();
+        double govUs = std::chrono::duration<double, std::micro>(Clock::now() - g0).count();
+
+        // Draw every visible object into the offscreen grid
+        int n = (int)gTex.size(), cols = std::max(1, (int)std::ceil(std::sqrt((double)n))), rows = std::max(1, (n+cols-1)/cols);
+        draws.clear();
+        for(int i=0;i<n;++i){
+            if(!gGov.visible(i)) continue;
+            float x0 = -1.f + 2.f*(i%cols)/cols, y0 = -1.f + 2.f*(i/cols)/rows;
+            draws.push_back({gTex[i], x0, y0, x0 + 2.f/cols, y0 + 2.f/rows, gGov.bias(i) + gGov.globalNudge});
+        }
+        gBackend->drawGrid(draws);
+        gBackend->present();
+        double cpuMs = std::chrono::duration<double, std::milli>(Clock::now() - f0).count();
+
+        // Record
+        int steps = 0;
+        prevBias.resize(gGov.size(), 0.f);
+        for(int i=0;i<(int)gGov.size();++i){
+            if(gGov.bias(i)!=prevBias[i]){ ++steps; prevBias[i]=gGov.bias(i); }
+            S.maxBias = std::max(S.maxBias, (double)gGov.bias(i));
+        }
+        int lo = gGov.targetFreeMB - gGov.hysteresisMB;
+        // Only samples read after the event count (telemetry may hand back a cached one).
+        for(auto& E : events){
+            if(E.recoveredAt >= 0 || tel.time <= E.t) continue;
+            if(E.leftAt < 0){ if(tel.freeMB < lo) E.leftAt = tel.time; }
+            else if(tel.time > E.leftAt && tel.freeMB >= lo) E.recoveredAt = tel.time;
+        }
+        std::fprintf(csv, "%llu,%.4f,%d,%d,%d,%.1f,%zu,%zu,%.1f,%d,%.3f,%.3f,%.1f",
+            (unsigned long long)frame, t, tel.freeMB, tel.valid?1:0, gGov.targetFreeMB, gGov.pendingMB(),
+            gAdmit.waiting(), gPads.size(), gBackend->allocatedMB(), steps, cpuMs, gBackend->gpuMs(), govUs);
+        for(int i=0;i<objectCols;++i){
+            if(i < (int)gGov.size()) std::fprintf(csv, ",%.3f", gGov.bias(i));
+            else std::fprintf(csv, ",");
+        }
+        std::fprintf(csv, "\n");
+
+        ++S.frames; S.steps += steps; S.cpuMs += cpuMs; S.gpuMs += gBackend->gpuMs(); S.govUs += govUs;
+        S.minFreeMB = std::min(S.minFreeMB, tel.freeMB);
+    }
+    std::fclose(csv);
+
+    // Summary
+    std::FILE* js = std::fopen((out + ".json").c_str(), "w");
+    if(js){
+        int f = std::max(1, S.frames);
+        std::fprintf(js, "{\n  \"backend\": \"%s\",\n  \"renderer\": \"%s\",\n  \"telemetry\": \"%s\",\n  \"policy\": \"%s\",\n  \"control\": \"%s\",\n",
+            gBackend->name(), jsonEscape(gBackend->device()).c_str(), telSource, gGov.policy->name(), controlName(gGov.control()));
+        std::fprintf(js, "  \"frames\": %d,\n  \"dt\": %.6f,\n  \"steps\": %d,\n  \"maxBias\": %.3f,\n  \"minFreeMB\": %d,\n",
+            S.frames, dt, S.steps, S.maxBias, S.minFreeMB);
+        std::fprintf(js, "  \"avgCpuMs\": %.3f,\n  \"avgGpuMs\": %.3f,\n  \"avgGovernorUs\": %.2f,\n  \"events\": [",
+            S.cpuMs/f, S.gpuMs/f, S.govUs/f);
+        // recoverSeconds: from the first out-of-band sample; 0 if freeMB never left the band, -1 if it never came back.
+        for(size_t i=0;i<events.size();++i){
+            const Event& E = events[i];
+            std::fprintf(js, "%s\n    { \"t\": %.3f, \"what\": \"%s\", \"leftBand\": %s, \"recoverSeconds\": %.3f }", i?",":"",
+                E.t, jsonEscape(E.what).c_str(), E.leftAt<0 ? "false" : "true",
+                E.leftAt<0 ? 0.0 : E.recoveredAt<0 ? -1.0 : E.recoveredAt - E.leftAt);
+        }
+        std::fprintf(js, "\n  ]\n}\n");
+        std::fclose(js);
+    }
+    std::printf("[Bench] %d frames, %d steps, min freeMB %d -> %s.csv / %s.json\n", S.frames, S.steps, S.minFreeMB, out.c_str(), out.c_str());
+    for(const auto& E : events)
+        std::printf("  %-12s at %6.2fs: %s\n", E.what.c_str(), E.t,
+            E.leftAt<0 ? "stayed in band" : E.recoveredAt<0 ? "never back in band"
+                       : (std::to_string(E.recoveredAt-E.leftAt) + "s to recover").c_str());
+
+    gBackend->shutdown();
+    return 0;
+}
@@ -0,0 +1,198 @@
+// vram_governor — library translation unit (API in vram_governor.h)
+// - Home of stb_image's implementation and of the per-frame loop the demos used to inline
+
+#include "vram_governor.h"
+
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+
+#include "upload.h"
+#include "decode_pool.h"
+#include "resource_thread.h"
+#include "ledger.h"
+#include "trace.h"
+#include "gputimer.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+// =================== Shaders ===================
+GLuint vgCompileShader(GLenum type, const char* src){
+    GLuint s = glCreateShader(type);
+    glShaderSource(s,1,&src,nullptr);
+    glCompileShader(s);
+    GLint ok=0; glGetShaderiv(s,GL_COMPILE_STATUS,&ok);
+    if(!ok){ GLint len=0; glGetShaderiv(s,GL_INFO_LOG_LENGTH,&len);
+        std::string log(len,'\0'); glGetShaderInfoLog(s,len,nullptr,log.data());
+        std::fprintf(stderr,"[Shader] compile error:\n%s\n", log.c_str());
+        glDeleteShader(s); return 0; }
+    return s;
+}
+static GLuint vgLink(GLuint p){
+    glLinkProgram(p);
+    GLint ok=0; glGetProgramiv(p,GL_LINK_STATUS,&ok);
+    if(!ok){ GLint len=0; glGetProgramiv(p,GL_INFO_LOG_LENGTH,&len);
+        std::string log(len,'\0'); glGetProgramInfoLog(p,len,nullptr,log.data());
+        std::fprintf(stderr,"[Program] link error:\n%s\n", log.c_str());
+        glDeleteProgram(p); return 0; }
+    return p;
+}
+GLuint vgLinkProgram(GLuint vs, GLuint fs){
+    GLuint p = glCreateProgram();
+    glAttachShader(p,vs); glAttachShader(p,fs);
+    return vgLink(p);
+}
+GLuint vgLinkCompute(GLuint cs){
+    GLuint p = glCreateProgram();
+    glAttachShader(p,cs);
+    return vgLink(p);
+}
+
+// =================== VramGovernor ===================
+VramGovernor::VramGovernor() : admit_(gov_) {}
+
+bool VramGovernor::init(const VgConfig& cfg){
+    if(ready_) return true;
+    gov_.verbose = cfg.verbose;
+    if(cfg.targetFreeMB >= 0) gov_.targetFreeMB = cfg.targetFreeMB;
+    if(cfg.knapsack) gov_.policy = std::make_unique<KnapsackPolicy>();
+    gov_.setControl(cfg.control);
+    gov_.gpuBudgetMs = cfg.gpuBudgetMs;
+
+    tel_.init();
+    if(cfg.fallbackMB > 0){ tel_.useTelemetry = false; tel_.fallbackBaseFreeMB = cfg.fallbackMB; }
+    else {
+        GLint kb=0; glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &kb);
+        tel_.fallbackBaseFreeMB = (glGetError()==GL_NO_ERROR && kb>0) ? (kb/1024)*9/10 : 6000;
+    }
+
+    if(cfg.asyncUploads){ gUploads.init(); gDecode.init(); }
+    gAsyncUploads = cfg.asyncUploads;
+    if(cfg.resourceShare) gRes.start(cfg.resourceShare);
+    gRetire.onFreed = [this](size_t bytes){ gov_.announceFree(bytes/(1024.0*1024.0), stats_.now); };
+    admit_.applyShed = [this]{ syncResidency(true); };
+    ready_ = true;
+    std::printf("[Governor] library ready (telemetry=%s, uploads=%s, resource thread=%s)\n",
+        tel_.useTelemetry ? telModeName(tel_.mode) : "FALLBACK", gAsyncUploads ? "async" : "sync", gRes.threaded() ? "on" : "off");
+    return true;
+}
+
+void VramGovernor::shutdown(){
+    if(!ready_) return;
+    admit_.clear();
+    tel_.shutdown();
+    if(gDecode.running()) gDecode.shutdown();
+    if(gAsyncUploads){ gUploads.shutdown(); gAsyncUploads = false; }
+    for(auto& T : tex_) destroyGovTexture(T);
+    tex_.clear();
+    gRetire.drain();
+    gTexPool.trimTo(0);
+    gRes.shutdown();
+    gRetire.onFreed = nullptr;
+    admit_.applyShed = nullptr;
+    ready_ = false;
+}
+
+int VramGovernor::adoptTexture(int id, GovTexture&& T){
+    if(id >= (int)tex_.size()) tex_.resize(id+1);
+    tex_[id] = std::move(T);
+    gov_.setFootprint(id, residentMB(tex_[id]), tex_[id].residentTop, tex_[id].levels);
+    return id;
+}
+
+int VramGovernor::addTexture(int w, int h, LevelSource src, Priority p, int top){
+    GovTexture T; T.baseW=w; T.baseH=h; T.source=std::move(src); T.priority=(int)p;
+    createGovTexture(T, top);
+    return adoptTexture(gov_.add(p), std::move(T));
+}
+
+int VramGovernor::addImage(const std::string& path, Priority p, int top){
+    int w=0,h=0,ch=0;
+    if(!stbi_info(path.c_str(),&w,&h,&ch)){ std::fprintf(stderr,"[Decode] %s not found\n", path.c_str()); return -1; }
+    GovTexture T; T.baseW=w; T.baseH=h; T.imagePath=path; T.priority=(int)p;
+    T.source = [path](int level,int,int){      // synchronous path (no pool)
+        std::vector<DecodedLevel> out; decodeLevels(path, level, level+1, out);
+        return out.empty() ? std::vector<uint8_t>() : std::move(out.back().rgba);
+    };
+    createGovTexture(T, top);
+    return adoptTexture(gov_.add(p), std::move(T));
+}
+
+void VramGovernor::removeTexture(int id){
+    if(id < 0 || id >= (int)tex_.size() || !tex_[id].tex) return;
+    destroyGovTexture(tex_[id]);
+    tex_[id] = GovTexture{};
+    gov_.setVisible(id, false);
+    gov_.setFootprint(id, 0.f, 0, 1);
+}
+
+void   VramGovernor::setVisible(int id, bool v){ gov_.setVisible(id, v); }
+void   VramGovernor::setDensity(int id, float coverage, float requiredMip, float finestMip){ gov_.setDensity(id, coverage, requiredMip, finestMip); }
+GLuint VramGovernor::texture(int id) const { return govTexture(id).tex; }
+const GovTexture& VramGovernor::govTexture(int id) const {
+    static const GovTexture kNone;
+    return id >= 0 && id < (int)tex_.size() ? tex_[id] : kNone;
+}
+float  VramGovernor::bias(int id) const { return gov_.bias(id) + gov_.globalNudge; }
+
+void VramGovernor::request(double mb, Priority p, std::function<void()> alloc, const char* what){
+    admit_.request(mb, p, stats_.now, std::move(alloc), what);
+}
+void VramGovernor::announceFree(double mb){ gov_.announceFree(mb, stats_.now); }
+
+// Reclaim first so the sample and the tick see it.
+const VgFrameStats& VramGovernor::frame(double now, double gpuMs){
+    VG_ZONE("governor.frame");
+    auto g0 = std::chrono::steady_clock::now();
+    stats_.now = now;
+    gRes.poll();
+    gRetire.pump();
+    const TelemetrySample& tel = tel_.sample(now);
+    gov_.setRetiringMB(gRetire.queuedBytes()/(1024.0*1024.0));
+    gov_.setGpuTime(gpuMs);
+    gov_.evaluate(now, tel.freeMB, tel.valid);
+    admit_.service(now);
+    syncResidency();
+    if(gAsyncUploads){ VG_GPU_ZONE("upload"); gUploads.pump(); }
+
+    stats_.freeMB = tel.freeMB;
+    stats_.telemetryValid = tel.valid;
+    stats_.underPressure = gov_.underPressure;
+    stats_.pendingMB = gov_.pendingMB();
+    stats_.retiringMB = gRetire.queuedBytes()/(1024.0*1024.0);
+    stats_.residentMB = gov_.residentMB();
+    stats_.waiting = admit_.waiting();
+    stats_.governorUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - g0).count();
+    return stats_;
+}
+
+// Governor biases -> residency, with admission gating every mip that streams back in. `shed`:
+// admission needs the memory now, so holdRelease is not asked.
+void VramGovernor::syncResidency(bool shed){
+    VG_ZONE("residency.sync");
+    if(gov_.underPressure) gTexPool.trimTo(0);      // pooled storage is still committed VRAM
+    gRetire.recycle = !gov_.underPressure;
+    double now = stats_.now;
+    for(int id=0; id<(int)tex_.size(); ++id){
+        GovTexture& T = tex_[id];
+        if(!T.tex) continue;
+        bool hold = holdRelease && holdRelease(id, now);
+        bool vis = gov_.visible(id);
+        int want = vis ? gov_.wantedTop(id) : T.levels-1;
+        float commit = vis ? gov_.wantedCommit(id) : 1.f;
+        int before = T.residentTop;
+        double growMB = ((double)residentBytes(T, std::max(want, 0), commit) - (double)residentBytes(T)) / (1024.0*1024.0);
+        if(growMB > 0.0 && !admit_.tryAdmit(growMB, gov_.priority(id), now)){
+            want = before; commit = committedFraction(T);
+        }
+        if(growMB < 0.0 && hold && !shed){ want = before; commit = committedFraction(T); }
+        if(setResidentTop(T, want, commit)){
+            if(gov_.verbose) std::printf("[Residency] obj %d top mip %d -> %d (%.0f%% committed)  (%.1f MB resident)\n",
+                id, before, T.residentTop, 100.0*committedFraction(T), residentMB(T));
+            if(gov_.underPressure) gTexPool.trimTo(0);
+        }
+        gov_.setFootprint(id, residentMB(T), T.residentTop, T.levels, committedFraction(T));
+    }
+    if(onSync) onSync();
+}
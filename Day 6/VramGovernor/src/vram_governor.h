@@ -0,0 +1,109 @@
+// vram_governor — the governor as a library, for an existing GL render loop
+// - Link the vram_governor target; init() once the GL context is current, frame() once per
+//   frame before drawing, shutdown() before the context goes away
+// - frame() is the governor block of the Day 6 demo's loop in one call: resource-thread
+//   completions, retirement, telemetry, governor evaluate, admission, residency, async uploads.
+//   It returns what it saw (VgFrameStats)
+// - Objects are governed textures: a procedural LevelSource, an image file (decoded on the
+//   pool), or a GovTexture the app built itself (adoptTexture). Draw with texture(id) sampled
+//   at bias(id); ids are the Governor's
+// - Hooks: holdRelease keeps a texture's finer level while the app still samples it (the
+//   demo's bias animation); onSync runs each residency pass for governed resources that
+//   aren't textures (the demo's volume bricks), so shedding reaches them too
+// - The resource thread (gRes) starts only when VgConfig::resourceShare names a window to
+//   share objects with; without it, resource commands run inline
+// - Other allocations (render targets, scratch buffers) go through request() so admission
+//   can make room for them first; announceFree() for memory the app gives back itself
+// - One instance per process: retirement, uploads and decode are process-wide queues
+// - The modules themselves (governor.h, residency.h, telemetry.h, ...) stay public for apps
+//   that need more; governor() / admission() / telemetry() reach the instances behind this
+// - vgCompileShader / vgLinkProgram / vgLinkCompute: the shader helpers every demo used to
+//   carry a copy of
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <GL/glew.h>
+
+struct GLFWwindow;
+
+#include "governor.h"
+#include "admission.h"
+#include "telemetry.h"
+#include "residency.h"
+
+struct VgConfig {
+    int         targetFreeMB = -1;      // -1: Governor default
+    int         fallbackMB = 0;         // > 0: ignore driver telemetry, assume this much VRAM
+    bool        asyncUploads = true;    // stream-in through the upload ring and decode pool
+    bool        knapsack = false;       // KnapsackPolicy instead of priority buckets
+    ControlMode control = ControlMode::Band;
+    double      gpuBudgetMs = 0.0;      // > 0: also shed when gpuMs passed to frame() exceeds it
+    bool        verbose = false;        // governor status lines and one line per residency change
+    GLFWwindow* resourceShare = nullptr;    // set: start gRes on a context shared with this window
+};
+
+struct VgFrameStats {
+    double now = 0.0;
+    int    freeMB = 0;
+    bool   telemetryValid = false, underPressure = false;
+    double pendingMB = 0.0, retiringMB = 0.0, residentMB = 0.0;
+    size_t waiting = 0;                 // requests admission is holding back
+    double governorUs = 0.0;            // CPU time of this frame() call, telemetry read included
+};
+
+class VramGovernor {
+public:
+    VramGovernor();
+    VramGovernor(const VramGovernor&) = delete;
+    VramGovernor& operator=(const VramGovernor&) = delete;
+
+    bool init(const VgConfig& cfg = {});
+    void shutdown();
+
+    // Governed textures; -1 if the image can't be read.
+    int    addTexture(int w, int h, LevelSource src, Priority p = Priority::Normal, int top = 0);
+    int    addImage(const std::string& path, Priority p = Priority::Normal, int top = 0);
+    int    adoptTexture(int id, GovTexture&& T);    // created by the app for governor id `id`
+    void   removeTexture(int id);       // storage retired; the id stays hidden
+    void   setVisible(int id, bool v);
+    void   setDensity(int id, float coverage, float requiredMip, float finestMip);
+    GLuint texture(int id) const;
+    const GovTexture& govTexture(int id) const;     // empty for ids without a texture
+    float  bias(int id) const;          // LOD bias to sample texture(id) at (global nudge included)
+
+    // Per texture, every residency pass: true keeps its finer levels for now (drops wait;
+    // growth still goes through admission). Ignored while admission sheds.
+    std::function<bool(int id, double now)> holdRelease;
+    // After the textures, every residency pass (including admission's shed).
+    std::function<void()> onSync;
+
+    // Once per frame; gpuMs is the app's (smoothed) GPU frame time, 0 if not measured.
+    const VgFrameStats& frame(double now, double gpuMs = 0.0);
+    const VgFrameStats& stats() const { return stats_; }
+
+    void request(double mb, Priority p, std::function<void()> alloc, const char* what = "alloc");
+    void announceFree(double mb);
+
+    Governor&         governor()  { return gov_; }
+    AdmissionControl& admission() { return admit_; }
+    Telemetry&        telemetry() { return tel_; }
+
+private:
+    void syncResidency(bool shed = false);
+
+    Governor         gov_;
+    AdmissionControl admit_;
+    Telemetry        tel_;
+    std::vector<GovTexture> tex_;       // indexed by governor id (empty for ids added elsewhere)
+    VgFrameStats     stats_;
+    bool             ready_ = false;
+};
+
+// Compile / link with the info log on failure; 0 on error (nothing is left allocated).
+GLuint vgCompileShader(GLenum type, const char* src);
+GLuint vgLinkProgram(GLuint vs, GLuint fs);
+GLuint vgLinkCompute(GLuint cs);
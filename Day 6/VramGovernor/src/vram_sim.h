@@ -0,0 +1,93 @@
+// VramSim — GPU-free model of the memory the governor controls
+// - Objects are mip chains (RGBA8 footprint per level); MipTail residency follows the governor's
+//   wantedTop: drops free at once, restores stream back under a per-tick upload budget
+// - Sparse residency also keeps only wantedCommit() of the top level (page granularity ignored)
+// - The "driver" has a fixed budget; free = budget - resident - external allocations
+// - Telemetry is what the governor actually sees: sampled every samplePeriod, delayed by
+//   latency and jittered by a seeded noise term, so a run is reproducible from its seed
+// - Time is whatever the caller passes in; nothing here reads a clock or touches GL
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "governor.h"
+
+struct SimObject {
+    int   dim = 1024;           // square level-0 size
+    int   levels = 11;
+    int   residentTop = 0;
+    float committed = 1.f;      // share of residentTop's level resident (sparse)
+    float coverage = 0.01f;     // screen share while visible
+
+    double levelMB(int l) const { double d = std::max(1, dim >> l); return d*d*4.0 / (1024.0*1024.0); }
+    double chainMB(int top) const { double s=0; for(int l=std::max(0,top); l<levels; ++l) s += levelMB(l); return s; }
+    double residentMB(int top, float c) const { return chainMB(top) - (1.0 - c)*levelMB(top); }
+};
+
+class VramSim {
+public:
+    double budgetMB        = 4096.0;   // what the driver lets this process keep resident
+    double externalMB      = 0.0;      // pads, render targets, other processes
+    double samplePeriod    = 0.1;      // telemetry refresh (matches Telemetry::samplePeriod)
+    double latency         = 0.05;     // age of the value a telemetry read returns
+    double noiseMB         = 8.0;      // +- uniform jitter on each telemetry sample
+    double streamMBPerTick = 48.0;     // upload budget for restoring mips
+
+    explicit VramSim(unsigned seed=1) : rng_(seed) {}
+
+    int add(Governor& g, Priority p, int dim, float coverage){
+        SimObject o; o.dim = dim; o.levels = 1 + (int)std::floor(std::log2((double)std::max(1,dim))); o.coverage = coverage;
+        int id = g.add(p);
+        g.setFootprint(id, (float)o.chainMB(0), 0, o.levels);
+        g.setDensity(id, coverage, 0.f, 0.f);
+        objs_.push_back(o);
+        residentMB_ += o.chainMB(0);
+        return id;
+    }
+    void setVisible(Governor& g, int i, bool v){
+        g.setVisible(i, v);
+        g.setDensity(i, v ? objs_[i].coverage : 0.f, 0.f, 0.f);
+    }
+
+    // Apply the governor's wanted residency, then advance the telemetry history to `now`.
+    void tick(Governor& g, double now){
+        double stream = streamMBPerTick;
+        for(int i=0;i<(int)objs_.size();++i){
+            SimObject& o = objs_[i];
+            int want = g.visible(i) ? g.wantedTop(i) : o.levels-1;
+            want = std::clamp(want, 0, o.levels-1);
+            float c = g.visible(i) ? g.wantedCommit(i) : 1.f;
+            double before = o.residentMB(o.residentTop, o.committed), after = o.residentMB(want, c);
+            if(after > before){
+                if(after - before > stream){ want = o.residentTop; c = o.committed; after = before; }
+                else stream -= after - before;
+            }
+            residentMB_ += after - before;
+            o.residentTop = want; o.committed = c;
+            g.setFootprint(i, (float)after, o.residentTop, o.levels, o.committed);
+        }
+        history_.push_back({now, freeMB()});
+        while(history_.size() > 1 && history_[1].first <= now - latency) history_.pop_front();
+        if(now - lastSample_ >= samplePeriod || reported_ < -1e8){
+            lastSample_ = now;
+            std::uniform_real_distribution<double> j(-noiseMB, noiseMB);
+            reported_ = history_.front().second + (noiseMB > 0.0 ? j(rng_) : 0.0);
+        }
+    }
+
+    double freeMB()     const { return budgetMB - residentMB_ - externalMB; }   // ground truth
+    int    reportedMB() const { return (int)std::lround(reported_); }          // what telemetry says
+    double residentMB() const { return residentMB_; }
+    const std::vector<SimObject>& objects() const { return objs_; }
+
+private:
+    std::vector<SimObject> objs_;
+    std::deque<std::pair<double,double>> history_;
+    double residentMB_ = 0.0, lastSample_ = 0.0, reported_ = -1e9;
+    std::mt19937 rng_;
+};